@@ -0,0 +1,123 @@
+// measure the cost of passing messages between rpi-threads using
+// the channels in <libpi/include/rpi-chan.h>.
+//
+//  1. ping-pong: two threads bounce a counter back and forth.  every
+//     message forces a block (and so a context switch), so this is
+//     the worst-case latency.
+//  2. stream: a producer fills buffers and sends pointers to them
+//     down a deep channel (zero-copy); the consumer checks them and
+//     returns them on a free channel.  the consumer uses <chan_select>
+//     to also listen on a "done" channel.  this is the best-case
+//     throughput since most sends/recvs do not block.
+#include "rpi.h"
+#include "cycle-count.h"
+#include "rpi-chan.h"
+
+enum { NTRIALS = 4096, NBUF = 16, BUFSIZE = 64 };
+
+gen_chan_T(u32ch, u32_chan_t, uint32_t, 2)
+
+typedef struct buf {
+    uint32_t seqno;
+    uint8_t data[BUFSIZE];
+} buf_t;
+gen_chan_T(bufch, buf_chan_t, buf_t *, NBUF+1)
+
+static u32_chan_t ping, pong, done;
+static buf_chan_t full, empty;
+
+/****************************************************************
+ * 1. ping-pong
+ */
+static void pinger(void *arg) {
+    uint32_t s = cycle_cnt_read();
+    for(uint32_t i = 0; i < NTRIALS; i++) {
+        u32ch_send(&ping, i);
+        uint32_t v = u32ch_recv(&pong);
+        if(v != i+1)
+            panic("expected %d, have %d\n", i+1, v);
+    }
+    uint32_t t = cycle_cnt_read() - s;
+    output("ping-pong: %d round trips took %d cycles: %d cycles per trip\n",
+        NTRIALS, t, t / NTRIALS);
+}
+static void ponger(void *arg) {
+    for(uint32_t i = 0; i < NTRIALS; i++)
+        u32ch_send(&pong, u32ch_recv(&ping) + 1);
+}
+
+/****************************************************************
+ * 2. zero-copy stream
+ */
+static void producer(void *arg) {
+    for(uint32_t i = 0; i < NTRIALS; i++) {
+        buf_t *b = bufch_recv(&empty);
+        b->seqno = i;
+        b->data[0] = i;
+        bufch_send(&full, b);
+    }
+    u32ch_send(&done, NTRIALS);
+}
+static void consumer(void *arg) {
+    uint32_t expect = 0, n = 0;
+
+    buf_t *b;
+    uint32_t total;
+    uint32_t s = cycle_cnt_read();
+    while(1) {
+        chan_case_t cases[] = {
+            chan_case_recv(&full, &b),
+            chan_case_recv(&done, &total),
+        };
+        int k = chan_select(cases, 2);
+        if(k == 1)
+            break;
+
+        if(b->seqno != expect || b->data[0] != (uint8_t)expect)
+            panic("expected seqno=%d, have %d\n", expect, b->seqno);
+        expect++;
+        n++;
+        bufch_send(&empty, b);
+    }
+
+    // the done message can race ahead of the last buffers.
+    while(bufch_try_recv(&full, &b)) {
+        if(b->seqno != expect)
+            panic("expected seqno=%d, have %d\n", expect, b->seqno);
+        expect++;
+        n++;
+        bufch_send(&empty, b);
+    }
+    uint32_t t = cycle_cnt_read() - s;
+    if(n != total || n != NTRIALS)
+        panic("received %d buffers, expected %d\n", n, total);
+
+    output("stream: %d messages took %d cycles: %d cycles per message\n",
+        n, t, t / NTRIALS);
+}
+
+void notmain(void) {
+    caches_enable();
+    kmalloc_init(1);
+
+    u32ch_init(&ping, "ping");
+    u32ch_init(&pong, "pong");
+    rpi_fork(pinger, 0);
+    rpi_fork(ponger, 0);
+    rpi_thread_start();
+    chan_stats(&ping.hdr);
+    chan_stats(&pong.hdr);
+
+    u32ch_init(&done, "done");
+    bufch_init(&full, "full");
+    bufch_init(&empty, "empty");
+    for(int i = 0; i < NBUF; i++)
+        bufch_send(&empty, kmalloc(sizeof(buf_t)));
+    rpi_fork(producer, 0);
+    rpi_fork(consumer, 0);
+    rpi_thread_start();
+    chan_stats(&full.hdr);
+    chan_stats(&empty.hdr);
+
+    output("SUCCESS\n");
+}
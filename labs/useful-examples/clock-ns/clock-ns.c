@@ -0,0 +1,60 @@
+// <clock-ns.h>: compare the cost of <clock_now_ns> against
+// <timer_get_usec>, then run for a while with background resync and
+// check it stays monotonic and close to the system timer.
+#include "rpi.h"
+#include "cycle-count.h"
+#include "irq-dispatch.h"
+#include "timer-oneshot.h"
+#include "clock-ns.h"
+#include "cpu-freq.h"
+
+enum { N = 100, RUN_SEC = 10 };
+
+void notmain(void) {
+    caches_enable();
+
+    irq_dispatch_init();
+    oneshot_init(SYS_TIMER_CHAN3);
+    clock_ns_init();
+    clock_ns_start(0);
+    enable_interrupts();
+
+    output("measured %d cycles/usec (boot calibration=%d, nominal=%d)\n",
+        clock_ns_cyc_per_usec(), cpu_cyc_per_usec(), CYC_PER_USEC);
+
+    // cost per call.
+    uint32_t s = cycle_cnt_read();
+    for(int i = 0; i < N; i++)
+        timer_get_usec();
+    uint32_t t_usec = (cycle_cnt_read() - s) / N;
+
+    s = cycle_cnt_read();
+    for(int i = 0; i < N; i++)
+        clock_now_ns();
+    uint32_t t_ns = (cycle_cnt_read() - s) / N;
+    output("timer_get_usec: %d cycles, clock_now_ns: %d cycles\n", t_usec, t_ns);
+
+    // spin for a while: monotonic and tracking the system timer.
+    uint64_t last = clock_now_ns(), end = timer_get_usec64() + RUN_SEC*1000*1000;
+    uint32_t max_err_ns = 0;
+    unsigned n = 0;
+    while(timer_get_usec64() < end) {
+        uint64_t now = clock_now_ns();
+        if(now < last)
+            panic("went backwards: %llx < %llx\n", now, last);
+        last = now;
+
+        // compare in ns (a multiply, not a 64-bit divide): the system
+        // timer only has 1usec resolution so up to 1000ns is noise.
+        if(n++ % 1024 == 0) {
+            uint64_t u = timer_get_usec64() * 1000;
+            uint64_t err = now > u ? now - u : u - now;
+            if(err > max_err_ns)
+                max_err_ns = err;
+        }
+    }
+    output("%d reads over %d sec, max error vs system timer=%dns\n",
+        n, RUN_SEC, max_err_ns);
+    clock_ns_stats();
+    output("SUCCESS\n");
+}
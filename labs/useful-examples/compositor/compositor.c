@@ -0,0 +1,93 @@
+// <compositor.h>: a small dashboard -- a scatter plot that gains a
+// few points a frame, a status bar of changing "digits" and a
+// color-keyed cursor wandering over both -- drawn through the
+// dirty-rectangle compositor, first with cpu copies, then dma, then
+// with the whole screen damaged every frame for comparison.
+//
+// page 1 of the framebuffer is the (offscreen) back surface, page 0
+// the one on screen: we never flip.
+#include "rpi.h"
+#include "fb.h"
+#include "compositor.h"
+
+enum { W = 640, H = 480, NFRAME = 300,
+       PW = 400, PH = 300, SW = 640, SH = 24, CW = 16, CH = 16 };
+
+static uint32_t plot_px[PW * PH], status_px[SW * SH], cursor_px[CW * CH];
+static comp_t c;
+static layer_t plot, status, cursor;
+
+static uint32_t seed = 1;
+// [0, n): scale the 24 random bits by <n> instead of '%', which is
+// a runtime divide (no libgcc).
+static unsigned rnd(unsigned n) {
+    seed = seed * 1103515245 + 12345;
+    return ((uint64_t)(seed >> 8) * n) >> 24;
+}
+
+static void setup(fb_t *fb) {
+    surface_t back = surface_mk(fb->page[1], W, H, fb->pitch, 32);
+    surface_t front = surface_mk(fb->page[0], W, H, fb->pitch, 32);
+    comp_init(&c, back, front, 0x00101010);
+
+    comp_layer_add(&c, &plot, surface_mk(plot_px, PW, PH, 0, 32), 20, 40);
+    surf_clear(&plot.s, 0x00002000);
+    surf_rect(&plot.s, 0, 0, PW, PH, 0x0000c000);
+
+    comp_layer_add(&c, &status, surface_mk(status_px, SW, SH, 0, 32), 0, H - SH);
+    surf_clear(&status.s, 0x00202060);
+
+    // a ring: black is transparent.
+    comp_layer_add(&c, &cursor, surface_mk(cursor_px, CW, CH, 0, 32), 0, 0);
+    surf_clear(&cursor.s, 0);
+    surf_circle(&cursor.s, CW / 2, CH / 2, CW / 2 - 1, 0x00ffff00);
+    comp_layer_key(&c, &cursor, 0);
+}
+
+static void frame(unsigned f) {
+    // a few new points.
+    for(unsigned i = 0; i < 8; i++) {
+        int x = 1 + rnd(PW - 4), y = 1 + rnd(PH - 4);
+        surf_fill_rect(&plot.s, x, y, 2, 2, 0x0000ff00);
+        layer_damage(&plot, (rect_t){ x, y, 2, 2 });
+    }
+    // four 8x16 "digits".
+    for(unsigned i = 0; i < 4; i++) {
+        int x = 8 + i * 12;
+        surf_fill_rect(&status.s, x, 4, 8, 16, (f * 37 + i * 91) & 0xff);
+        layer_damage(&status, (rect_t){ x, 4, 8, 16 });
+    }
+    comp_layer_move(&c, &cursor, (f * 3) % (W - CW), (f * 2) % (H - CW));
+}
+
+static void run(const char *name, int full) {
+    comp_stats_reset(&c);
+    for(unsigned f = 0; f < NFRAME; f++) {
+        frame(f);
+        if(full)
+            comp_damage(&c, (rect_t){ 0, 0, W, H });
+        comp_frame(&c);
+    }
+    output("%s: ", name);
+    comp_stats_print(&c);
+}
+
+void notmain(void) {
+    caches_enable();
+
+    fb_t *fb = fb_init(W, H, 32);
+    setup(fb);
+    comp_frame(&c);
+
+    run("cpu", 0);
+    comp_dma(&c, 1);
+    run("dma", 0);
+    comp_dma(&c, 0);
+    run("cpu, full frame", 1);
+
+    // back is always complete, and front should be a copy of it.
+    for(unsigned y = 0; y < H; y++)
+        if(memcmp(surface_row(&c.back, y), surface_row(&c.front, y), W * 4))
+            panic("row %d: front != back\n", y);
+    output("SUCCESS\n");
+}
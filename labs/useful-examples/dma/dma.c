@@ -0,0 +1,166 @@
+// <dma.h>: check memcpy / memset / blit / fill against the cpu at
+// odd sizes and alignments, run an async chain with a completion
+// interrupt, then compare throughput with the cpu's memcpy.
+//
+// runs on a pi or under qemu: <make qemu>.  (qemu's cycle counter
+// doesn't run, so we time with the system timer.)
+#include "rpi.h"
+#include "irq-dispatch.h"
+#include "dma.h"
+
+enum { MB = 1024*1024, N = MB + 64 };
+
+static uint8_t a[N] __attribute__((aligned(32)));
+static uint8_t b[N] __attribute__((aligned(32)));
+
+static void fill_rand(uint8_t *p, unsigned n, uint32_t seed) {
+    for(unsigned i = 0; i < n; i++) {
+        seed = seed * 1103515245 + 12345;
+        p[i] = seed >> 16;
+    }
+}
+
+static void check_memcpy(unsigned n, unsigned soff, unsigned doff) {
+    fill_rand(a, N, n + soff);
+    memset(b, 0xee, N);
+    dma_memcpy(b + doff, a + soff, n);
+    if(memcmp(b + doff, a + soff, n) != 0)
+        panic("dma_memcpy(n=%d, soff=%d, doff=%d): data wrong\n", n, soff, doff);
+    // nothing outside the range.
+    if(doff && b[doff-1] != 0xee)
+        panic("dma_memcpy(n=%d): wrote before dst\n", n);
+    if(b[doff + n] != 0xee)
+        panic("dma_memcpy(n=%d): wrote past dst\n", n);
+}
+
+static void check_memset(unsigned n, unsigned off) {
+    memset(b, 0xee, N);
+    dma_memset(b + off, 0x5a, n);
+    for(unsigned i = 0; i < n; i++)
+        if(b[off + i] != 0x5a)
+            panic("dma_memset(n=%d, off=%d): byte %d=%x\n", n, off, i, b[off+i]);
+    if((off && b[off-1] != 0xee) || b[off + n] != 0xee)
+        panic("dma_memset(n=%d, off=%d): wrote outside\n", n, off);
+}
+
+// copy a w x h rect from (sx,sy) in a 640-byte pitch surface to
+// (dx,dy) in a 1000-byte pitch one.
+static void check_blit(unsigned w, unsigned h, unsigned sx, unsigned sy,
+                       unsigned dx, unsigned dy) {
+    enum { SP = 640, DP = 1000 };
+    fill_rand(a, SP * 600, w * h);
+    memset(b, 0xee, DP * 600);
+    dma_blit(b + dy*DP + dx, DP, a + sy*SP + sx, SP, w, h);
+
+    for(unsigned y = 0; y < 600; y++)
+        for(unsigned x = 0; x < DP; x++) {
+            uint8_t exp = 0xee;
+            if(y >= dy && y < dy + h && x >= dx && x < dx + w)
+                exp = a[(y - dy + sy) * SP + (x - dx + sx)];
+            if(b[y*DP + x] != exp)
+                panic("dma_blit(%dx%d): (%d,%d)=%x, expected %x\n",
+                    w, h, x, y, b[y*DP+x], exp);
+        }
+}
+
+static void check_fill2d(void) {
+    enum { P = 1024, W = 400, H = 300, X = 64, Y = 20 };
+    memset(b, 0xee, P * (H + 2*Y));
+    dma_fill2d(b + Y*P + X, P, 0x11223344, W, H);
+    uint32_t *p = (void *)b;
+    for(unsigned y = 0; y < H + 2*Y; y++)
+        for(unsigned x = 0; x < P / 4; x++) {
+            int in = y >= Y && y < Y + H && x >= X/4 && x < (X + W)/4;
+            uint32_t exp = in ? 0x11223344 : 0xeeeeeeee;
+            if(p[y*P/4 + x] != exp)
+                panic("dma_fill2d: word (%d,%d)=%x, expected %x\n",
+                    x, y, p[y*P/4+x], exp);
+        }
+}
+
+static volatile int ndone;
+static void done(unsigned ch, void *arg) {
+    ndone += (uint32_t)arg;
+}
+
+// three memcpys in one chain, one interrupt at the end.
+static void check_async(void) {
+    static dma_cb_t cb[3];
+    int ch = dma_chan_alloc(DMA_ANY);
+    if(ch < 0)
+        panic("no dma channel\n");
+
+    fill_rand(a, 3 * 4096, 99);
+    memset(b, 0, 3 * 4096);
+    for(unsigned i = 0; i < 3; i++) {
+        // reverse the order of the three blocks.
+        dma_cb_memcpy(&cb[i], b + (2 - i) * 4096, a + i * 4096, 4096);
+        dma_cb_chain(&cb[i], i < 2 ? &cb[i+1] : 0);
+    }
+    dma_cache_clean(a, 3 * 4096);
+    dma_cache_inv(b, 3 * 4096);
+
+    ndone = 0;
+    dma_start(ch, &cb[0], done, (void *)1);
+    uint32_t s = timer_get_usec();
+    while(!ndone)
+        if(timer_get_usec() - s > 1000*1000)
+            panic("no completion interrupt\n");
+
+    for(unsigned i = 0; i < 3; i++)
+        if(memcmp(b + (2 - i) * 4096, a + i * 4096, 4096) != 0)
+            panic("async chain: block %d wrong\n", i);
+    dma_stats_t st = dma_stats(ch);
+    output("async: 3-block chain on channel %d (%s), %d interrupt\n",
+        ch, dma_chan_is_lite(ch) ? "lite" : "full", st.nints);
+    dma_chan_free(ch);
+}
+
+void notmain(void) {
+    caches_enable();
+    irq_dispatch_init();
+    dma_init();
+
+    unsigned sizes[] = { 1, 3, 4, 15, 16, 17, 100, 4096, 65535, 65536 + 7, MB };
+    for(unsigned i = 0; i < sizeof sizes / sizeof sizes[0]; i++)
+        for(unsigned off = 0; off < 4; off++) {
+            check_memcpy(sizes[i], off, (off * 7) % 16);
+            check_memset(sizes[i], off);
+        }
+    output("memcpy/memset: ok\n");
+
+    check_blit(640, 480, 0, 0, 0, 0);
+    check_blit(100, 50, 3, 7, 901, 530);
+    check_blit(1, 600, 639, 0, 0, 0);
+    check_blit(333, 1, 17, 5, 11, 0);
+    output("blit: ok\n");
+
+    check_fill2d();
+    output("fill2d: ok\n");
+
+    enable_interrupts();
+    check_async();
+
+    // throughput: 1MB.
+    uint32_t s = timer_get_usec();
+    for(unsigned i = 0; i < 4; i++)
+        memcpy(b, a, MB);
+    uint32_t t_cpu = (timer_get_usec() - s) / 4;
+
+    s = timer_get_usec();
+    for(unsigned i = 0; i < 4; i++)
+        dma_memcpy(b, a, MB);
+    uint32_t t_dma = (timer_get_usec() - s) / 4;
+    // raw usec: MB/s is 1000000/usec, but that's a runtime divide
+    // (no libgcc).
+    output("1MB copy: cpu %dusec, dma %dusec\n", t_cpu, t_dma);
+
+    s = timer_get_usec();
+    memset(b, 0, MB);
+    t_cpu = timer_get_usec() - s;
+    s = timer_get_usec();
+    dma_memset(b, 0, MB);
+    t_dma = timer_get_usec() - s;
+    output("1MB clear: cpu %dusec, dma %dusec\n", t_cpu, t_dma);
+    output("SUCCESS\n");
+}
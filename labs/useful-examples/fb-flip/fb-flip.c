@@ -0,0 +1,59 @@
+// <fb.h>: bounce a square around a double-buffered framebuffer,
+// first flipping on vsync (no tearing), then as fast as we can
+// render, and print frame time / flip latency for both.
+//
+// to check for tearing by eye: the square is drawn as stripes of the
+// frame number's color; a torn frame shows two colors at once.
+#include "rpi.h"
+#include "fb.h"
+
+enum { W = 640, H = 480, DEPTH = 32, SZ = 64, NFRAME = 300 };
+
+static void draw(fb_t *fb, unsigned frame, int x, int y) {
+    uint8_t *p = fb_back(fb);
+
+    // whole page: background, then the square.
+    for(unsigned r = 0; r < fb->h; r++)
+        memset(p + r * fb->pitch, 0x20, fb->w * fb->bytes_pp);
+
+    uint32_t c = frame & 1 ? 0x00ff8000 : 0x000080ff;
+    for(unsigned r = 0; r < SZ; r++) {
+        uint32_t *row = (void *)(p + (y + r) * fb->pitch);
+        for(unsigned i = 0; i < SZ; i++)
+            row[x + i] = c;
+    }
+}
+
+static void run(fb_t *fb, unsigned vsync) {
+    int x = 0, y = 0, dx = 5, dy = 3;
+    for(unsigned f = 0; f < NFRAME; f++) {
+        draw(fb, f, x, y);
+        fb_flip(fb, vsync);
+
+        if(x + dx < 0 || x + dx + SZ > W)
+            dx = -dx;
+        if(y + dy < 0 || y + dy + SZ > H)
+            dy = -dy;
+        x += dx;
+        y += dy;
+    }
+}
+
+void notmain(void) {
+    caches_enable();
+
+    fb_t *fb = fb_init(W, H, DEPTH);
+    output("fb: %dx%d depth=%d pitch=%d at %p (%d bytes), %s\n",
+        fb->w, fb->h, fb->depth, fb->pitch, fb->base, fb->size,
+        fb->rgb_p ? "rgb" : "bgr");
+
+    run(fb, FB_VSYNC);
+    output("vsync: ");
+    fb_stats_print(fb);
+
+    fb_stats_reset(fb);
+    run(fb, FB_NO_VSYNC);
+    output("no vsync: ");
+    fb_stats_print(fb);
+    output("SUCCESS\n");
+}
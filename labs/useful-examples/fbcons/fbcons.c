@@ -0,0 +1,68 @@
+// <fbcons.h>: characters per second through printk to the uart, and
+// to the framebuffer console scrolling each of its three ways.  then
+// leave the console installed, mirrored to the uart.
+#include "rpi.h"
+#include "fbcons.h"
+
+enum { W = 640, H = 480, NLINE = 400, LINE = 72 };
+
+static fbcons_t c;
+static char text[NLINE * (LINE + 1) + 1];
+
+// <NLINE> lines of <LINE> characters: every line scrolls once the
+// screen is full.
+static void mk_text(void) {
+    char *p = text;
+    for(unsigned l = 0; l < NLINE; l++) {
+        for(unsigned i = 0; i < LINE; i++)
+            *p++ = ' ' + (l + i) % 95;
+        *p++ = '\n';
+    }
+    *p = 0;
+}
+
+// through printk so we pay what printk users pay.
+static uint32_t time_printk(void) {
+    uint32_t s = timer_get_usec();
+    printk("%s", text);
+    return timer_get_usec() - s;
+}
+
+static uint32_t run_cons(const char *name) {
+    fbcons_install(&c, 0);
+    uint32_t t = time_printk();
+    fbcons_uninstall();
+    output("%s: %d chars in %dusec\n", name, strlen(text), t);
+    fbcons_stats_print(&c);
+    return t;
+}
+
+void notmain(void) {
+    caches_enable();
+    mk_text();
+
+    output("uart: printing %d lines...\n", NLINE);
+    uint32_t t_uart = time_printk();
+    // raw usec: chars/sec and speedups would be runtime divides (no
+    // libgcc).
+    output("uart: %d chars in %dusec\n", strlen(text), t_uart);
+
+    fb_t *fb = fb_init(W, H, 32);
+    surface_t front = surface_mk(fb->page[0], W, H, fb->pitch, fb->depth);
+
+    fbcons_init(&c, front, FBCONS_SCROLL_CPU);
+    uint32_t t_cpu = run_cons("fbcons, cpu scroll");
+    fbcons_init(&c, front, FBCONS_SCROLL_DMA);
+    uint32_t t_dma = run_cons("fbcons, dma scroll");
+    fbcons_init_fb(&c, fb);
+    uint32_t t_pan = run_cons("fbcons, pan scroll");
+
+    output("usec: uart %d, cpu scroll %d, dma scroll %d, pan scroll %d\n",
+        t_uart, t_cpu, t_dma, t_pan);
+
+    // from here on printk shows on both.
+    fbcons_color(&c, surface_rgb(&c.s, 0, 255, 0), 0);
+    fbcons_install(&c, 1);
+    printk("fbcons: mirrored to hdmi and uart\n");
+    output("SUCCESS\n");
+}
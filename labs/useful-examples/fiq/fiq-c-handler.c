@@ -0,0 +1,19 @@
+// C FIQ handler called through the <fiq_install_c> trampoline.
+// this file should only have code that runs in FIQ mode: <nfiq>
+// lives in banked r10 so gcc can't use r10 anywhere in here.
+#include "rpi.h"
+#include "cycle-count.h"
+#include "fiq.h"
+#include "fiq-gpio.h"
+
+FIQ_REG(nfiq, r10);
+
+void fiq_gpio_c(void *ctx) {
+    evq_t *q = ctx;
+
+    gpio_fast_event_clear(in_pin);
+    nfiq++;
+    // we're the only producer: lock-free.
+    if(!evq_push(q, cycle_cnt_read()))
+        q->overflow++;
+}
@@ -0,0 +1,115 @@
+// measure GPIO edge-to-handler latency the same way as lab 1's
+// <gpio-int.c>, for three handlers:
+//   1. IRQ through the vectored dispatcher (<irq-dispatch.h>).
+//   2. FIQ with a C handler (<fiq_install_c>) that keeps a counter
+//      in banked r10 and pushes timestamps into a lock-free queue.
+//   3. FIQ with a 4-instruction asm handler copied into the FIQ
+//      slot (<fiq_install_asm>) that keeps all state in r8-r11.
+//
+// put a loopback jumper between <in_pin> and <out_pin>.
+#include "rpi.h"
+#include "cycle-count.h"
+#include "irq-dispatch.h"
+#include "fiq.h"
+#include "fiq-gpio.h"
+
+enum { NTRIALS = 10 };
+
+static evq_t q;
+static volatile uint32_t asm_count;
+
+static void irq_gpio(unsigned irq, void *ctx) {
+    evq_t *q = ctx;
+    gpio_event_clear(in_pin);
+    evq_push(q, cycle_cnt_read());
+}
+
+// wait for one edge after writing <v>: either a queue entry or
+// the asm counter changing.
+static uint32_t edge(unsigned v, int use_counter) {
+    uint32_t s = cycle_cnt_read();
+    if(use_counter) {
+        uint32_t c = asm_count;
+        gpio_write(out_pin, v);
+        while(asm_count == c)
+            ;
+    } else {
+        uint32_t ts;
+        gpio_write(out_pin, v);
+        while(!evq_pop_nonblk(&q, &ts))
+            ;
+    }
+    return cycle_cnt_read() - s;
+}
+
+static unsigned test_cost(const char *msg, int use_counter) {
+    assert(gpio_read(in_pin) == 0);
+
+    unsigned sum = 0;
+    for(int i = 0; i < NTRIALS; i++) {
+        sum += edge(1, use_counter);
+        sum += edge(0, use_counter);
+    }
+    unsigned ave = sum / (2*NTRIALS);
+    output("%s: ave = %d cycles\n", msg, ave);
+    return ave;
+}
+
+void notmain(void) {
+    gpio_set_output(out_pin);
+    gpio_set_input(in_pin);
+    gpio_write(out_pin, 1);
+    if(gpio_read(in_pin) != 1)
+        panic("connect jumper from pin %d to pin %d\n", in_pin, out_pin);
+    gpio_write(out_pin, 0);
+    if(gpio_read(in_pin) != 0)
+        panic("connect jumper from pin %d to pin %d\n", in_pin, out_pin);
+
+    caches_enable();
+    q = evq_mk();
+
+    // 1. IRQ
+    irq_dispatch_init();
+    irq_register(IRQ_GPIO0, irq_gpio, &q);
+    gpio_int_rising_edge(in_pin);
+    gpio_int_falling_edge(in_pin);
+    gpio_event_clear(in_pin);
+    enable_interrupts();
+    unsigned irq = test_cost("IRQ (dispatch)", 0);
+
+    // 2. FIQ, C handler.  routing to FIQ disables the IRQ.
+    fiq_disable();
+    fiq_install_c(fiq_gpio_c, &q);
+    fiq_route(IRQ_GPIO0);
+    gpio_event_clear(in_pin);
+    fiq_enable();
+    unsigned fiq_c = test_cost("FIQ (C handler)", 0);
+
+    fiq_regs_t r;
+    fiq_disable();
+    fiq_regs_get(&r);
+    output("C handler: %d FIQs counted in banked r10, queue overflows=%d\n",
+        r.r10, q.overflow);
+    assert(r.r10 == 2*NTRIALS);
+
+    // 3. FIQ, asm handler.
+    r = (fiq_regs_t) {
+        .r8 = GPIO_EDS0,
+        .r9 = 1 << in_pin,
+        .r10 = 0,
+        .r11 = (uint32_t)&asm_count,
+    };
+    extern uint8_t fiq_gpio_asm[], fiq_gpio_asm_end[];
+    fiq_regs_set(&r);
+    fiq_install_asm(fiq_gpio_asm, fiq_gpio_asm_end);
+    gpio_event_clear(in_pin);
+    fiq_enable();
+    unsigned fiq_asm = test_cost("FIQ (asm handler)", 1);
+    fiq_disable();
+    fiq_unroute();
+
+    output("saved over IRQ: C=%d cycles, asm=%d cycles per edge\n",
+        irq - fiq_c, irq - fiq_asm);
+    if(fiq_c >= irq || fiq_asm >= irq)
+        output("ERROR: FIQ did not beat IRQ!\n");
+}
@@ -0,0 +1,15 @@
+#ifndef __FIQ_GPIO_H__
+#define __FIQ_GPIO_H__
+// shared between the FIQ handlers and the driver <fiq-gpio.c>
+#include "circular-T.h"
+#include "gpio-fast.h"
+
+// put a loopback jumper between these.
+enum { out_pin = 26, in_pin = 27 };
+
+// the handler pushes the cycle count at each edge.
+gen_circular_T(evq, evq_t, uint32_t, 64)
+
+// C handler: <ctx> is the <evq_t> to push to.
+void fiq_gpio_c(void *ctx);
+#endif
@@ -0,0 +1,192 @@
+// the renderer and its kernels: see fractal.h
+#include "fractal.h"
+
+const char *fr_kern_name[FR_NKERN] = { "f64", "f32", "q28" };
+
+// one complex iteration count.  <n> is the loop count we actually
+// ran, for the iteration totals.
+#define GEN_FLOAT_KERN(name, T)                                         \
+static unsigned name(T zr, T zi, T cr, T ci, unsigned maxit,            \
+                     unsigned cycle_p, unsigned *n, unsigned *cyc) {    \
+    T sr = zr, si = zi;                                                 \
+    unsigned period = 8, k = 0;                                         \
+    for(unsigned i = 0; i < maxit; i++) {                               \
+        T r2 = zr * zr, i2 = zi * zi;                                   \
+        if(r2 + i2 > (T)4) {                                            \
+            *n += i;                                                    \
+            return i;                                                   \
+        }                                                               \
+        zi = (T)2 * zr * zi + ci;                                       \
+        zr = r2 - i2 + cr;                                              \
+        if(cycle_p) {                                                   \
+            if(zr == sr && zi == si) {                                  \
+                *n += i + 1;                                            \
+                (*cyc)++;                                               \
+                return maxit;                                           \
+            }                                                           \
+            if(++k == period) {                                         \
+                k = 0;                                                  \
+                period *= 2;                                            \
+                sr = zr;                                                \
+                si = zi;                                                \
+            }                                                           \
+        }                                                               \
+    }                                                                   \
+    *n += maxit;                                                        \
+    return maxit;                                                       \
+}
+GEN_FLOAT_KERN(kern_f64, double)
+GEN_FLOAT_KERN(kern_f32, float)
+
+// Q28: |z| <= 2 before each step, so the new z is under 8 and fits;
+// the squares are checked in 64 bits before they're narrowed.
+enum { Q = 28 };
+#define Q_ONE (1 << Q)
+
+static unsigned kern_q28(int32_t zr, int32_t zi, int32_t cr, int32_t ci,
+                         unsigned maxit, unsigned cycle_p,
+                         unsigned *n, unsigned *cyc) {
+    int32_t sr = zr, si = zi;
+    unsigned period = 8, k = 0;
+    for(unsigned i = 0; i < maxit; i++) {
+        int64_t r2 = ((int64_t)zr * zr) >> Q;
+        int64_t i2 = ((int64_t)zi * zi) >> Q;
+        if(r2 + i2 > 4LL * Q_ONE) {
+            *n += i;
+            return i;
+        }
+        // 2 * zr * zi: one less shift.
+        zi = (int32_t)(((int64_t)zr * zi) >> (Q - 1)) + ci;
+        zr = (int32_t)(r2 - i2) + cr;
+        if(cycle_p) {
+            if(zr == sr && zi == si) {
+                *n += i + 1;
+                (*cyc)++;
+                return maxit;
+            }
+            if(++k == period) {
+                k = 0;
+                period *= 2;
+                sr = zr;
+                si = zi;
+            }
+        }
+    }
+    *n += maxit;
+    return maxit;
+}
+
+// per-column / per-row coordinates in each kernel's format, once a
+// frame so the loops never convert.
+static double re64[FR_MAXW], im64[FR_MAXH];
+static float re32[FR_MAXW], im32[FR_MAXH];
+static int32_t req[FR_MAXW], imq[FR_MAXH];
+// julia's constant c in Q28.
+static int32_t jrq, jiq;
+
+static int32_t to_q(double d) {
+    return (int32_t)(d * Q_ONE);
+}
+
+static void setup_coords(const surface_t *s, const fr_view_t *v) {
+    double step = v->scale / s->w;
+    double x0 = v->cx - step * s->w / 2, y0 = v->cy + step * s->h / 2;
+    for(unsigned x = 0; x < s->w; x++) {
+        re64[x] = x0 + step * x;
+        re32[x] = re64[x];
+        req[x] = to_q(re64[x]);
+    }
+    // y goes up the screen.
+    for(unsigned y = 0; y < s->h; y++) {
+        im64[y] = y0 - step * y;
+        im32[y] = im64[y];
+        imq[y] = to_q(im64[y]);
+    }
+    jrq = to_q(v->jr);
+    jiq = to_q(v->ji);
+}
+
+static unsigned
+pixel(const fr_view_t *v, fr_opts_t *o, unsigned x, unsigned y, fr_result_t *r) {
+    unsigned n = 0, cyc = 0, it;
+    switch(o->kern) {
+    case FR_F64:
+        it = v->julia_p
+            ? kern_f64(re64[x], im64[y], v->jr, v->ji, v->maxit, o->cycle_p, &n, &cyc)
+            : kern_f64(0, 0, re64[x], im64[y], v->maxit, o->cycle_p, &n, &cyc);
+        break;
+    case FR_F32:
+        it = v->julia_p
+            ? kern_f32(re32[x], im32[y], v->jr, v->ji, v->maxit, o->cycle_p, &n, &cyc)
+            : kern_f32(0, 0, re32[x], im32[y], v->maxit, o->cycle_p, &n, &cyc);
+        break;
+    default:
+        it = v->julia_p
+            ? kern_q28(req[x], imq[y], jrq, jiq, v->maxit, o->cycle_p, &n, &cyc)
+            : kern_q28(0, 0, req[x], imq[y], v->maxit, o->cycle_p, &n, &cyc);
+        break;
+    }
+    r->iters += n;
+    r->ncycle += cyc;
+    r->npixel++;
+    if(it == v->maxit)
+        r->ninside++;
+    return it;
+}
+
+// inside black, outside a repeating blue -> orange ramp.
+static uint32_t color(const surface_t *s, unsigned it, unsigned maxit) {
+    if(it >= maxit)
+        return surface_rgb(s, 0, 0, 0);
+    unsigned t = (it * 8) & 0xff;
+    return surface_rgb(s, t, t / 2 + 32, 255 - t);
+}
+
+void fr_render(const surface_t *s, uint16_t *it, const fr_view_t *v,
+               fr_opts_t *o, fr_result_t *r) {
+    if(s->w > FR_MAXW || s->h > FR_MAXH)
+        panic("fractal: %dx%d > %dx%d\n", s->w, s->h, FR_MAXW, FR_MAXH);
+    if(!o->tile || o->tile % 8)
+        panic("fractal: tile %d: must be a multiple of 8\n", o->tile);
+    if(v->maxit > 0xffff)
+        panic("fractal: maxit %d > 65535\n", v->maxit);
+
+    memset(r, 0, sizeof *r);
+    setup_coords(s, v);
+
+    unsigned first = o->progressive_p ? 8 : 1;
+    for(unsigned l = first; l; l /= 2) {
+        for(unsigned ty = 0; ty < s->h; ty += o->tile)
+            for(unsigned tx = 0; tx < s->w; tx += o->tile) {
+                unsigned ty1 = ty + o->tile, tx1 = tx + o->tile;
+                if(ty1 > s->h)
+                    ty1 = s->h;
+                if(tx1 > s->w)
+                    tx1 = s->w;
+
+                for(unsigned y = ty; y < ty1; y += l)
+                    for(unsigned x = tx; x < tx1; x += l) {
+                        // done by a coarser pass.
+                        // (<l> is a power of two: mask, don't divide.)
+                        if(l < first && ((x | y) & (2 * l - 1)) == 0)
+                            continue;
+                        unsigned n = pixel(v, o, x, y, r);
+                        it[y * s->w + x] = n;
+                        uint32_t c = color(s, n, v->maxit);
+                        if(l == 1)
+                            surface_put_raw(s, x, y, c);
+                        else
+                            surf_fill_rect(s, x, y, l, l, c);
+                    }
+                if(o->progress)
+                    o->progress(o, l);
+            }
+    }
+
+    uint32_t h = 2166136261u;
+    for(unsigned i = 0; i < s->w * s->h; i++) {
+        h = (h ^ (it[i] & 0xff)) * 16777619u;
+        h = (h ^ (it[i] >> 8)) * 16777619u;
+    }
+    r->checksum = h;
+}
@@ -0,0 +1,94 @@
+// mandelbrot / julia benchmark: render each standard view (views.h)
+// into the framebuffer with each kernel (double vfp, single vfp, Q28
+// fixed point), with and without cycle detection, progressively.
+// prints cycles per frame (and per refinement pass) and the image
+// checksum: compare the checksums with unix/fractal-ref's to check an
+// optimized kernel still computes the same image.
+#include "rpi.h"
+#include "asm-helpers.h"
+#include "cycle-count.h"
+#include "cpu-freq.h"
+#include "fb.h"
+#include "fractal.h"
+#include "views.h"
+
+// the float kernels are vfp code: the Makefile's flags.
+#ifndef RPI_FP_ENABLED
+#   error "fractal needs -DRPI_FP_ENABLED -mhard-float -mfpu=vfp"
+#endif
+
+enum { W = 640, H = 480, TILE = 32 };
+
+static uint16_t it[W * H];
+
+// the cycle counter wraps in a few seconds: extend it to 64 bits a
+// tile at a time, and split by pass.
+static uint32_t last;
+static uint64_t cyc, pass_cyc[9];
+
+// arm1176 3-52: coprocessor access control.  cp10 and cp11 are the
+// vfp.
+cp_asm(cpacr, p15, 0, c1, c0, 2)
+
+// <staff-start.S> does this at boot under RPI_FP_ENABLED; redo it so
+// the benchmark doesn't depend on which start file it was linked
+// with.  full access to cp10/cp11, then set FPEXC.EN.
+static void vfp_enable(void) {
+    cpacr_set(cpacr_get() | 0xf << 20);
+    asm volatile("fmxr fpexc, %0" :: "r" (1 << 30));
+}
+
+static void progress(fr_opts_t *o, unsigned level) {
+    uint32_t now = cycle_cnt_read();
+    uint32_t d = now - last;
+    last = now;
+    cyc += d;
+    pass_cyc[level] += d;
+}
+
+static fr_result_t run(const surface_t *s, const fr_view_t *v,
+                       unsigned kern, unsigned cycle_p) {
+    fr_opts_t o = {
+        .kern = kern, .cycle_p = cycle_p, .progressive_p = 1,
+        .tile = TILE, .progress = progress,
+    };
+    fr_result_t r;
+
+    cyc = 0;
+    memset(pass_cyc, 0, sizeof pass_cyc);
+    last = cycle_cnt_read();
+    fr_render(s, it, v, &o, &r);
+
+    // cycles in units of 2^20 ("M"): shifts, since a 64-bit divide
+    // needs libgcc.  per-pixel and per-iteration costs are left to
+    // the reader.
+    output("%s %s%s: %d Mcycles, %d pixels, %d Miters, checksum=%x\n",
+        v->name, fr_kern_name[kern], cycle_p ? " +cycle" : "",
+        (uint32_t)(cyc >> 20), r.npixel, (uint32_t)(r.iters >> 20),
+        r.checksum);
+    output("\tpasses: 8:%dM 4:%dM 2:%dM 1:%dM; inside=%d, %d caught by cycle detection\n",
+        (uint32_t)(pass_cyc[8] >> 20), (uint32_t)(pass_cyc[4] >> 20),
+        (uint32_t)(pass_cyc[2] >> 20), (uint32_t)(pass_cyc[1] >> 20),
+        r.ninside, r.ncycle);
+    return r;
+}
+
+void notmain(void) {
+    vfp_enable();
+    caches_enable();
+
+    fb_t *fb = fb_init(W, H, 32);
+    surface_t s = surface_mk(fb_front(fb), W, H, fb->pitch, fb->depth);
+    output("fractal: %dx%d, %dx%d tiles, %dMHz\n", W, H, TILE, TILE,
+        cpu_cyc_per_usec());
+
+    for(unsigned v = 0; v < FR_NVIEW; v++)
+        for(unsigned k = 0; k < FR_NKERN; k++) {
+            fr_result_t a = run(&s, &fr_views[v], k, 0);
+            fr_result_t b = run(&s, &fr_views[v], k, 1);
+            if(a.checksum != b.checksum)
+                panic("%s %s: cycle detection changed the image: %x != %x\n",
+                    fr_views[v].name, fr_kern_name[k], a.checksum, b.checksum);
+        }
+    output("SUCCESS\n");
+}
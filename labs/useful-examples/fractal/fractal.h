@@ -0,0 +1,70 @@
+// tiled mandelbrot / julia renderer shared by the pi benchmark
+// (fractal.c) and the host reference (unix/fractal-ref.c).
+#ifndef __FRACTAL_H__
+#define __FRACTAL_H__
+/*
+ * kernels (same escape-time loop, different arithmetic):
+ *   FR_F64: double precision vfp.
+ *   FR_F32: single precision vfp.
+ *   FR_Q28: signed 32-bit fixed point with 28 fraction bits (|z| < 8),
+ *           64-bit products.  no fpu at all in the loop.
+ *
+ * cycle detection: every 2^k iterations save z; if z ever comes back
+ * *exactly* to the saved value the orbit is periodic and can never
+ * escape, so stop and call it maxit.  exact compares mean the
+ * iteration counts -- and so the checksum -- are the same with it on
+ * or off; only the time changes.  most of the win is inside the set,
+ * where every point would otherwise run to maxit.
+ *
+ * progressive: each tile is sampled every 8th pixel (drawn as 8x8
+ * blocks), then every 4th, 2nd and 1st, computing only the pixels
+ * the coarser passes didn't.  the final image is the same as a
+ * straight render.
+ *
+ * checksum: fnv-1a over the per-pixel iteration counts.  the pi and
+ * the host compute identical values for the same view and kernel.
+ */
+#include "surface.h"
+
+enum { FR_F64 = 0, FR_F32, FR_Q28, FR_NKERN };
+
+#define FR_MAXW 1920
+#define FR_MAXH 1080
+
+typedef struct {
+    const char *name;
+    unsigned julia_p;           // 0: mandelbrot, z0 = 0, c = pixel.
+    double cx, cy;              // center.
+    double scale;               // width of the view (complex units).
+    double jr, ji;              // julia: z0 = pixel, c = (jr, ji).
+    unsigned maxit;
+} fr_view_t;
+
+typedef struct fr_opts {
+    unsigned kern;
+    unsigned cycle_p;
+    unsigned progressive_p;
+    unsigned tile;              // tile size in pixels: multiple of 8.
+
+    // called after every tile of every pass (e.g. to keep a 64-bit
+    // cycle count); <level> is the pass's sample spacing.  may be 0.
+    void (*progress)(struct fr_opts *o, unsigned level);
+    void *arg;
+} fr_opts_t;
+
+typedef struct {
+    uint32_t checksum;
+    uint64_t iters;             // loop iterations, all pixels.
+    uint32_t npixel;            // pixels computed.
+    uint32_t ninside;           // reached maxit.
+    uint32_t ncycle;            // ... of which caught by cycle detection.
+} fr_result_t;
+
+extern const char *fr_kern_name[FR_NKERN];
+
+// render <v> into <s> (s->w <= FR_MAXW, s->h <= FR_MAXH), leaving the
+// iteration counts in <it> (s->w * s->h entries).
+void fr_render(const surface_t *s, uint16_t *it, const fr_view_t *v,
+               fr_opts_t *o, fr_result_t *r);
+
+#endif
@@ -0,0 +1,44 @@
+// host reference for the fractal benchmark: the same renderer and
+// views as the pi, so its checksums should match the pi's line for
+// line.  also checks that cycle detection and progressive refinement
+// don't change any image.
+//
+//      ./fractal-ref [w h]         (default 640 480, as on the pi)
+#include "../views.h"
+
+static uint16_t it[FR_MAXW * FR_MAXH];
+static uint32_t px[FR_MAXW * FR_MAXH];
+
+int main(int argc, char *argv[]) {
+    unsigned w = 640, h = 480;
+    if(argc == 3) {
+        w = atoi(argv[1]);
+        h = atoi(argv[2]);
+    } else if(argc != 1) {
+        fprintf(stderr, "usage: %s [w h]\n", argv[0]);
+        return 1;
+    }
+    surface_t s = surface_mk(px, w, h, 0, 32);
+
+    for(unsigned v = 0; v < FR_NVIEW; v++)
+        for(unsigned k = 0; k < FR_NKERN; k++) {
+            fr_result_t plain, fast;
+            fr_opts_t o = { .kern = k, .tile = 32 };
+            fr_render(&s, it, &fr_views[v], &o, &plain);
+            o.cycle_p = o.progressive_p = 1;
+            fr_render(&s, it, &fr_views[v], &o, &fast);
+
+            if(plain.checksum != fast.checksum)
+                panic("%s %s: checksum %x plain, %x with cycle detection + progressive\n",
+                    fr_views[v].name, fr_kern_name[k], plain.checksum, fast.checksum);
+            if(plain.npixel != w * h || fast.npixel != w * h)
+                panic("%s %s: computed %d / %d pixels, expected %d\n",
+                    fr_views[v].name, fr_kern_name[k], plain.npixel, fast.npixel, w * h);
+
+            printf("%-8s %s: checksum=%08x inside=%u iters=%llu (cycle detection: %llu, %u caught)\n",
+                fr_views[v].name, fr_kern_name[k], plain.checksum, plain.ninside,
+                (unsigned long long)plain.iters, (unsigned long long)fast.iters,
+                fast.ncycle);
+        }
+    return 0;
+}
@@ -0,0 +1,17 @@
+// the benchmark's standard views: the pi and the host reference
+// render exactly these.
+#ifndef __VIEWS_H__
+#define __VIEWS_H__
+#include "fractal.h"
+
+static const fr_view_t fr_views[] = {
+    { .name = "full",     .cx = -0.5,   .cy = 0,     .scale = 3.5,  .maxit = 256 },
+    { .name = "seahorse", .cx = -0.745, .cy = 0.105, .scale = 0.02, .maxit = 512 },
+    // mostly inside the set: what cycle detection is for.
+    { .name = "interior", .cx = -0.2,   .cy = 0,     .scale = 1.0,  .maxit = 1000 },
+    { .name = "julia",    .julia_p = 1, .cx = 0, .cy = 0, .scale = 3.2,
+      .jr = -0.8, .ji = 0.156, .maxit = 512 },
+};
+#define FR_NVIEW (sizeof fr_views / sizeof fr_views[0])
+
+#endif
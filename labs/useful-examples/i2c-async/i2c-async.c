@@ -0,0 +1,131 @@
+// <i2c-async.h> against an mpu6050 (address 0x68, on pins 2/3):
+//   1. nack reporting: a read from an address nobody answers.
+//   2. combined write-then-read: WHO_AM_I.
+//   3. a queue of transactions with callbacks.
+//   4. blocking <i2c_write>+<i2c_read> vs. pipelined async reads of
+//      the 14 sensor bytes, with the same fake computation per sample.
+#include "rpi.h"
+#include "cycle-count.h"
+#include "cpu-freq.h"
+#include "irq-dispatch.h"
+#include "i2c.h"
+#include "i2c-async.h"
+
+enum {
+    MPU_ADDR    = 0x68,
+    EMPTY_ADDR  = 0x2a,     // change if you have something there.
+
+    PWR_MGMT_1  = 0x6b,
+    WHO_AM_I    = 0x75,
+    ACCEL_XOUT_H = 0x3b,    // accel (6), temp (2), gyro (6).
+    NSENSOR     = 14,
+
+    NSAMPLE     = 200,
+    WORK        = 20000,    // fake computation per sample (loop iters).
+};
+
+// stand-in for filtering a sample.
+static volatile uint32_t sink;
+static void compute(const uint8_t *b) {
+    uint32_t x = b[0];
+    for(unsigned i = 0; i < WORK; i++)
+        x = x * 33 + b[i % NSENSOR];
+    sink = x;
+}
+
+static volatile unsigned ncallback;
+static void count(i2c_xfer_t *x, void *arg) {
+    ncallback++;
+}
+
+void notmain(void) {
+    irq_dispatch_init();
+
+    // blocking baseline first: staff driver, default clock (100kHz).
+    i2c_init();
+    delay_ms(30);
+    uint8_t wake[2] = { PWR_MGMT_1, 0 };
+    i2c_write(MPU_ADDR, wake, 2);
+    delay_ms(10);
+
+    uint8_t buf[2][NSENSOR];
+    uint32_t s = cycle_cnt_read();
+    for(unsigned i = 0; i < NSAMPLE; i++) {
+        uint8_t reg = ACCEL_XOUT_H;
+        i2c_write(MPU_ADDR, &reg, 1);
+        i2c_read(MPU_ADDR, buf[0], NSENSOR);
+        compute(buf[0]);
+    }
+    uint32_t t_block = cycle_cnt_read() - s;
+
+    i2c_async_init(I2C_ASYNC_100KHZ);
+    enable_interrupts();
+
+    // 1. nobody home.
+    static i2c_xfer_t x[3];
+    i2c_xfer_reg_read(&x[0], EMPTY_ADDR, 0, buf[0], 1);
+    i2c_submit(&x[0], 0, 0);
+    int r = i2c_xfer_wait(&x[0]);
+    if(r != I2C_ERR_NACK)
+        panic("addr %x: expected nack, got <%s>\n", EMPTY_ADDR, i2c_status_str(r));
+    output("addr %x: %s after %dusec\n", EMPTY_ADDR, i2c_status_str(r), x[0].usec);
+
+    // 2. repeated start.
+    i2c_xfer_reg_read(&x[0], MPU_ADDR, WHO_AM_I, buf[0], 1);
+    i2c_submit(&x[0], 0, 0);
+    if((r = i2c_xfer_wait(&x[0])) != I2C_OK)
+        panic("WHO_AM_I: %s\n", i2c_status_str(r));
+    if(buf[0][0] != MPU_ADDR)
+        panic("WHO_AM_I: got %x, expected %x\n", buf[0][0], MPU_ADDR);
+    output("WHO_AM_I=%x in %dusec\n", buf[0][0], x[0].usec);
+
+    // 3. accel, temp, gyro as three queued reads + one that fails.
+    static uint8_t a[6], t[2], g[6], e[1];
+    static i2c_xfer_t y;
+    i2c_xfer_reg_read(&x[0], MPU_ADDR, 0x3b, a, 6);
+    i2c_xfer_reg_read(&x[1], MPU_ADDR, 0x41, t, 2);
+    i2c_xfer_reg_read(&y, EMPTY_ADDR, 0, e, 1);
+    i2c_xfer_reg_read(&x[2], MPU_ADDR, 0x43, g, 6);
+    ncallback = 0;
+    i2c_submit(&x[0], count, 0);
+    i2c_submit(&x[1], count, 0);
+    i2c_submit(&y, count, 0);
+    i2c_submit(&x[2], count, 0);
+    output("queued %d transactions\n", i2c_async_pending());
+    if(i2c_xfer_wait(&x[2]) != I2C_OK || x[0].status != I2C_OK
+    || x[1].status != I2C_OK || y.status != I2C_ERR_NACK)
+        panic("queue: statuses %d %d %d %d\n",
+            x[0].status, x[1].status, y.status, x[2].status);
+    if(ncallback != 4)
+        panic("queue: %d callbacks, expected 4\n", ncallback);
+    output("queue: ok (accel x=%d)\n", (int16_t)(a[0] << 8 | a[1]));
+
+    // 4. pipelined: sample i+1 is on the bus while we compute on i.
+    s = cycle_cnt_read();
+    i2c_xfer_reg_read(&x[0], MPU_ADDR, ACCEL_XOUT_H, buf[0], NSENSOR);
+    i2c_submit(&x[0], 0, 0);
+    for(unsigned i = 0; i < NSAMPLE; i++) {
+        unsigned cur = i % 2, nxt = !cur;
+        if((r = i2c_xfer_wait(&x[cur])) != I2C_OK)
+            panic("sample %d: %s\n", i, i2c_status_str(r));
+        if(i + 1 < NSAMPLE) {
+            i2c_xfer_reg_read(&x[nxt], MPU_ADDR, ACCEL_XOUT_H, buf[nxt], NSENSOR);
+            i2c_submit(&x[nxt], 0, 0);
+        }
+        compute(buf[cur]);
+    }
+    uint32_t t_async = cycle_cnt_read() - s;
+
+    // how long the compute alone takes.
+    s = cycle_cnt_read();
+    for(unsigned i = 0; i < NSAMPLE; i++)
+        compute(buf[0]);
+    uint32_t t_work = cycle_cnt_read() - s;
+
+    output("%d samples: compute only %dusec, blocking %dusec, pipelined %dusec\n",
+        NSAMPLE, cpu_cyc_to_usec(t_work), cpu_cyc_to_usec(t_block),
+        cpu_cyc_to_usec(t_async));
+    output("one 14-byte register read takes %dusec on the bus\n", x[(NSAMPLE-1) % 2].usec);
+    i2c_async_stats_print("i2c-async");
+    output("SUCCESS\n");
+}
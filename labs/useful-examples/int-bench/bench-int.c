@@ -0,0 +1,125 @@
+// run the <int-bench.h> latency + throughput report over the
+// handler variants from lab 1 (1-fast-dev-int) and the following
+// examples so each optimization step shows up in one table:
+//   1. lab 1's single source <int_vector> via staff <default_vec_ints>.
+//   2. the vectored dispatcher (<irq-dispatch.h>).
+//   3. FIQ with a C handler (<fiq_install_c>).
+//   4. FIQ with a 4-instruction asm handler in the FIQ slot.
+//
+// put a loopback jumper between <in_pin> and <out_pin>.
+#include "rpi.h"
+#include "vector-base.h"
+#include "irq-dispatch.h"
+#include "fiq.h"
+#include "gpio-fast.h"
+#include "int-bench.h"
+
+enum { out_pin = 26, in_pin = 27 };
+
+static void gpio_int_setup(unsigned pin) {
+    gpio_int_rising_edge(pin);
+    gpio_int_falling_edge(pin);
+    gpio_event_clear(pin);
+}
+
+static void irq_off(unsigned pin) {
+    disable_interrupts();
+    dev_barrier();
+    PUT32(IRQ_Disable_1, 0xffffffff);
+    PUT32(IRQ_Disable_2, 0xffffffff);
+    dev_barrier();
+    gpio_event_clear(pin);
+}
+
+// 1. single source, same body as lab 1.
+void int_vector(uint32_t pc) {
+    dev_barrier();
+    if(!gpio_event_detected(in_pin))
+        panic("unexpected interrupt\n");
+    gpio_event_clear(in_pin);
+    int_bench_nedges++;
+    dev_barrier();
+}
+static void single_setup(unsigned pin) {
+    extern uint32_t default_vec_ints[];
+    irq_off(pin);
+    vector_base_reset(default_vec_ints);
+    gpio_int_setup(pin);
+    enable_interrupts();
+}
+
+// 2. dispatcher.
+static void dispatch_handler(unsigned irq, void *arg) {
+    gpio_event_clear(in_pin);
+    int_bench_nedges++;
+}
+static void dispatch_setup(unsigned pin) {
+    irq_off(pin);
+    irq_dispatch_init();
+    irq_register(IRQ_GPIO0, dispatch_handler, 0);
+    gpio_int_setup(pin);
+    enable_interrupts();
+}
+
+// 3. FIQ, C handler.
+static void fiq_c_handler(void *ctx) {
+    gpio_event_clear(in_pin);
+    int_bench_nedges++;
+}
+static void fiq_c_setup(unsigned pin) {
+    irq_off(pin);
+    fiq_disable();
+    fiq_install_c(fiq_c_handler, 0);
+    gpio_int_setup(pin);
+    fiq_route(IRQ_GPIO0);
+    gpio_event_clear(pin);
+    fiq_enable();
+}
+static void fiq_teardown(unsigned pin) {
+    fiq_disable();
+    fiq_unroute();
+    gpio_event_clear(pin);
+}
+
+// 4. FIQ, asm handler: the one from the fiq example
+// (<../fiq/fiq-handler.S>), counting into <int_bench_nedges>.
+static void fiq_asm_setup(unsigned pin) {
+    extern uint8_t fiq_gpio_asm[], fiq_gpio_asm_end[];
+
+    irq_off(pin);
+    fiq_disable();
+    fiq_regs_t r = {
+        .r8 = GPIO_EDS0,
+        .r9 = 1 << pin,
+        .r10 = int_bench_nedges,
+        .r11 = (uint32_t)&int_bench_nedges,
+    };
+    fiq_regs_set(&r);
+    fiq_install_asm(fiq_gpio_asm, fiq_gpio_asm_end);
+    gpio_int_setup(pin);
+    fiq_route(IRQ_GPIO0);
+    gpio_event_clear(pin);
+    fiq_enable();
+}
+
+void notmain(void) {
+    gpio_set_output(out_pin);
+    gpio_set_input(in_pin);
+    gpio_write(out_pin, 1);
+    if(gpio_read(in_pin) != 1)
+        panic("connect jumper from pin %d to pin %d\n", in_pin, out_pin);
+    gpio_write(out_pin, 0);
+    if(gpio_read(in_pin) != 0)
+        panic("connect jumper from pin %d to pin %d\n", in_pin, out_pin);
+
+    caches_enable();
+
+    int_bench_variant_t v[] = {
+        { "int_vector", single_setup, irq_off },
+        { "dispatch",   dispatch_setup, irq_off },
+        { "fiq-c",      fiq_c_setup, fiq_teardown },
+        { "fiq-asm",    fiq_asm_setup, fiq_teardown },
+    };
+    int_bench_cfg_t c = int_bench_cfg_mk(out_pin, in_pin);
+    int_bench_compare(&c, v, sizeof v / sizeof v[0]);
+}
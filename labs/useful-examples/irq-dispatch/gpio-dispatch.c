@@ -0,0 +1,110 @@
+// compare the cost of GPIO interrupts going through the vectored
+// dispatcher (<libpi/include/irq-dispatch.h>) versus the single
+// source <int_vector> path from lab 1 (1-fast-dev-int).  both
+// handlers do the same work so the difference is the dispatch
+// overhead.
+//
+// put a loopback jumper between <in_pin> and <out_pin>.
+#include "rpi.h"
+#include "cycle-count.h"
+#include "vector-base.h"
+#include "irq-dispatch.h"
+
+enum { out_pin = 26, in_pin = 27, NTRIALS = 10 };
+
+static volatile unsigned n_rising_edge, n_falling_edge;
+
+// the common handler body.
+static inline void gpio_edge(void) {
+    if(gpio_read(in_pin) == 0)
+        n_falling_edge++;
+    else
+        n_rising_edge++;
+    gpio_event_clear(in_pin);
+}
+
+// 1. single source: reached from the staff <default_vec_ints>
+void int_vector(uint32_t pc) {
+    dev_barrier();
+    if(!gpio_event_detected(in_pin))
+        panic("unexpected interrupt\n");
+    gpio_edge();
+    dev_barrier();
+}
+
+// 2. registered with the dispatcher for <IRQ_GPIO0>.
+static void gpio_handler(unsigned irq, void *arg) {
+    gpio_edge();
+}
+
+// same measurement loop as lab 1's <test_cost>
+static unsigned test_cost(const char *msg, unsigned pin) {
+    assert(gpio_read(in_pin) == 0);
+
+    unsigned sum = 0, min = ~0, max = 0;
+    for(int i = 0; i < NTRIALS; i++) {
+        uint32_t c = cycle_cnt_read();
+        let r = n_rising_edge;
+        gpio_set_on(pin);
+        while(n_rising_edge == r)
+            ;
+        uint32_t t = cycle_cnt_read() - c;
+        sum += t;
+        min = t < min ? t : min;
+        max = t > max ? t : max;
+
+        c = cycle_cnt_read();
+        let f = n_falling_edge;
+        gpio_set_off(pin);
+        while(n_falling_edge == f)
+            ;
+        t = cycle_cnt_read() - c;
+        sum += t;
+        min = t < min ? t : min;
+        max = t > max ? t : max;
+    }
+    output("%s: min=%d, max=%d, ave=%d cycles\n", msg, min, max, sum / (2*NTRIALS));
+    return sum / (2*NTRIALS);
+}
+
+static void gpio_int_setup(void) {
+    gpio_int_rising_edge(in_pin);
+    gpio_int_falling_edge(in_pin);
+    gpio_event_clear(in_pin);
+}
+
+void notmain(void) {
+    gpio_set_output(out_pin);
+    gpio_set_input(in_pin);
+    gpio_write(out_pin, 1);
+    if(gpio_read(in_pin) != 1)
+        panic("connect jumper from pin %d to pin %d\n", in_pin, out_pin);
+    gpio_write(out_pin, 0);
+    if(gpio_read(in_pin) != 0)
+        panic("connect jumper from pin %d to pin %d\n", in_pin, out_pin);
+
+    caches_enable();
+
+    // 1. single source.
+    extern uint32_t default_vec_ints[];
+    dev_barrier();
+    PUT32(IRQ_Disable_1, 0xffffffff);
+    PUT32(IRQ_Disable_2, 0xffffffff);
+    dev_barrier();
+    vector_base_reset(default_vec_ints);
+    gpio_int_setup();
+    enable_interrupts();
+    unsigned single = test_cost("single source int_vector", out_pin);
+    disable_interrupts();
+
+    // 2. dispatcher.
+    irq_dispatch_init();
+    irq_register(IRQ_GPIO0, gpio_handler, 0);
+    gpio_int_setup();
+    enable_interrupts();
+    unsigned vec = test_cost("vectored dispatch", out_pin);
+    disable_interrupts();
+
+    output("dispatch overhead = %d cycles per interrupt\n", (int)(vec - single));
+    irq_stats();
+}
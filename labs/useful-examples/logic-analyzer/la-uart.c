@@ -0,0 +1,48 @@
+// logic analyzer (<la-capture.h>) self-test: the uart sends out
+// of its hardware fifo without the cpu, so we can stuff 8 bytes in
+// and capture our own TX pin (GPIO 14) while they go out.
+//
+//      my-install la-uart.bin | tee log
+//      unix/la2vcd -o uart.vcd -r uart.lar log
+//      gtkwave uart.vcd
+//      unix/la-decode uart.lar uart 14 115200
+#include "rpi.h"
+#include "la-capture.h"
+#include "cpu-freq.h"
+
+enum { UART_TX = 14, NSAMPLES = 4096 };
+
+static la_sample_t buf[NSAMPLES];
+
+void notmain(void) {
+    la_cfg_t c = {
+        .mask = 1 << UART_TX,
+        .buf = buf,
+        .n = NSAMPLES,
+    };
+
+    // 1. idle line, no trigger: measures the raw sample rate.
+    uart_flush_tx();
+    c.timeout_cyc = cpu_usec_to_cyc(1000);
+    la_capture_t cap = la_capture(&c);
+    output("idle capture:\n");
+    la_report(&c, &cap);
+    output("la: a 1MB buffer holds %d edges\n", (1024*1024) / sizeof(la_sample_t));
+
+    // 2. trigger on the first start bit of 8 bytes, long enough for
+    // all of them (10 bits each at 115200 ~ 700usec).
+    const char msg[] = "LA-test!";
+    c.trig_mask = 1 << UART_TX;
+    c.trig_val = 0;
+    c.timeout_cyc = cpu_usec_to_cyc(2000);
+    uart_flush_tx();
+    for(int i = 0; i < 8; i++)
+        uart_put8(msg[i]);
+    cap = la_capture(&c);
+    uart_flush_tx();
+
+    output("\nuart capture of <%s>:\n", msg);
+    la_report(&c, &cap);
+    la_stream(&c, &cap);
+    output("done\n");
+}
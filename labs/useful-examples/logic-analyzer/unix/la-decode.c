@@ -0,0 +1,122 @@
+// decode a flat capture (<.lar>) with the <la-proto.h> decoders.
+//
+// usage:
+//      la-decode [-q] <file.lar> uart <pin> [<baud>]
+//      la-decode [-q] <file.lar> spi <sclk> <mosi> <miso> <cs|-> [<mode> [<nbits>]]
+//      la-decode [-q] <file.lar> i2c <scl> <sda>
+//
+// uart baud 0 (or missing) = guess it.  -q prints only the data, one
+// item per line, in the same form <la-synth> prints what it
+// generated, so the two can be compared.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "la-proto.h"
+
+static int quiet_p;
+
+static void usage(void) {
+    fprintf(stderr,
+        "usage: la-decode [-q] <file.lar> uart <pin> [<baud>]\n"
+        "       la-decode [-q] <file.lar> spi <sclk> <mosi> <miso> <cs|-> [<mode> [<nbits>]]\n"
+        "       la-decode [-q] <file.lar> i2c <scl> <sda>\n");
+    exit(1);
+}
+
+static unsigned num(const char *s) {
+    char *end;
+    unsigned long x = strtoul(s, &end, 0);
+    if(*end)
+        usage();
+    return x;
+}
+
+static void uart_print(const la_file_t *f, const la_uart_t *u, void *arg) {
+    if(quiet_p) {
+        printf("%02x\n", u->byte);
+        return;
+    }
+    printf("%12.3fus: 0x%02x '%c'%s\n", la_usec(f, u->start), u->byte,
+        isprint(u->byte) ? u->byte : '.',
+        u->framing_err ? " FRAMING ERROR" : "");
+}
+
+static void spi_print(const la_file_t *f, const la_spi_t *w, void *arg) {
+    if(quiet_p)
+        printf("%x %x\n", w->mosi, w->miso);
+    else
+        printf("%12.3fus: xfer %u: mosi=0x%x miso=0x%x\n",
+            la_usec(f, w->start), w->xfer, w->mosi, w->miso);
+}
+
+static void i2c_print(const la_file_t *f, const la_i2c_t *e, void *arg) {
+    const char *ack = e->ack_p ? "ack" : "nack";
+    if(!quiet_p)
+        printf("%12.3fus: ", la_usec(f, e->cyc));
+    switch(e->type) {
+    case LA_I2C_START:   printf("S\n"); break;
+    case LA_I2C_RESTART: printf("Sr\n"); break;
+    case LA_I2C_STOP:    printf("P\n"); break;
+    case LA_I2C_ADDR:
+        printf("A %02x %c %s\n", e->byte, e->read_p ? 'R' : 'W', ack);
+        break;
+    case LA_I2C_DATA:
+        printf("D %02x %s\n", e->byte, ack);
+        break;
+    }
+}
+
+int main(int argc, char *argv[]) {
+    int i = 1;
+    if(i < argc && !strcmp(argv[i], "-q")) {
+        quiet_p = 1;
+        i++;
+    }
+    if(argc - i < 2)
+        usage();
+
+    la_file_t *f = la_open(argv[i++]);
+    const char *proto = argv[i++];
+    char **a = &argv[i];
+    int na = argc - i;
+    unsigned n;
+
+    if(!strcmp(proto, "uart")) {
+        if(na < 1 || na > 2)
+            usage();
+        unsigned pin = num(a[0]);
+        unsigned baud = na == 2 ? num(a[1]) : 0;
+        if(!baud) {
+            if(!(baud = la_uart_autobaud(f, pin))) {
+                fprintf(stderr, "la-decode: no edges on pin %u\n", pin);
+                exit(1);
+            }
+            fprintf(stderr, "la-decode: guessed baud=%u\n", baud);
+        }
+        n = la_uart_decode(f, pin, baud, uart_print, 0);
+    } else if(!strcmp(proto, "spi")) {
+        if(na < 4 || na > 6)
+            usage();
+        la_spi_cfg_t c = {
+            .sclk = num(a[0]),
+            .mosi = num(a[1]),
+            .miso = num(a[2]),
+            .cs = strcmp(a[3], "-") ? num(a[3]) : ~0u,
+            .mode = na > 4 ? num(a[4]) : 0,
+            .nbits = na > 5 ? num(a[5]) : 8,
+        };
+        n = la_spi_decode(f, &c, spi_print, 0);
+    } else if(!strcmp(proto, "i2c")) {
+        if(na != 2)
+            usage();
+        n = la_i2c_decode(f, num(a[0]), num(a[1]), i2c_print, 0);
+    } else
+        usage();
+
+    fprintf(stderr, "la-decode: %llu samples, %u items\n",
+        (unsigned long long)f->n, n);
+    la_close(f);
+    return 0;
+}
@@ -0,0 +1,255 @@
+// protocol decoders over mmap'd captures: see <la-proto.h>
+#include <fcntl.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "la-proto.h"
+
+static void die(const char *fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    fprintf(stderr, "la-proto: ");
+    vfprintf(stderr, fmt, ap);
+    va_end(ap);
+    exit(1);
+}
+
+la_file_t *la_open(const char *path) {
+    int fd = open(path, O_RDONLY);
+    if(fd < 0)
+        die("can't open <%s>\n", path);
+    struct stat st;
+    if(fstat(fd, &st) < 0)
+        die("can't stat <%s>\n", path);
+    if((size_t)st.st_size < sizeof(la_file_hdr_t))
+        die("<%s> is too small to be a capture\n", path);
+
+    void *m = mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if(m == MAP_FAILED)
+        die("can't mmap <%s>\n", path);
+    close(fd);
+    // we walk it front to back exactly once.
+    madvise(m, st.st_size, MADV_SEQUENTIAL);
+
+    la_file_t *f = calloc(1, sizeof *f);
+    f->map = m;
+    f->map_len = st.st_size;
+    f->hdr = *(la_file_hdr_t *)m;
+    f->r = (const la_file_rec_t *)((la_file_hdr_t *)m + 1);
+    f->n = f->hdr.nsamples;
+
+    if(f->hdr.magic != LA_FILE_MAGIC)
+        die("<%s>: bad magic %x\n", path, f->hdr.magic);
+    if(!f->hdr.cyc_per_usec)
+        die("<%s>: cyc_per_usec is 0\n", path);
+    if(!f->n || sizeof f->hdr + f->n * sizeof *f->r > f->map_len)
+        die("<%s>: header says %llu samples but file is %zu bytes\n",
+            path, (unsigned long long)f->n, f->map_len);
+    return f;
+}
+
+void la_close(la_file_t *f) {
+    munmap(f->map, f->map_len);
+    free(f);
+}
+
+/*****************************************************************
+ * uart
+ */
+
+// forward-only cursor: level of <pin> at cycle <t>.  <t> must not
+// decrease between calls.
+typedef struct {
+    const la_file_rec_t *r;
+    uint64_t n, j;
+} cursor_t;
+
+static inline unsigned level_at(cursor_t *c, unsigned pin, uint64_t t) {
+    while(c->j + 1 < c->n && c->r[c->j + 1].cyc <= t)
+        c->j++;
+    return la_bit(c->r[c->j].lev, pin);
+}
+
+unsigned la_uart_decode(const la_file_t *f, unsigned pin, unsigned baud,
+                        la_uart_fn fn, void *arg) {
+    if(!baud)
+        die("baud is 0\n");
+    const la_file_rec_t *r = f->r;
+    uint64_t n = f->n, last = r[n-1].cyc;
+    double bit = f->hdr.cyc_per_usec * 1e6 / baud;
+
+    unsigned nbytes = 0;
+    unsigned prev = la_bit(r[0].lev, pin);
+    for(uint64_t i = 1; i < n; i++) {
+        unsigned b = la_bit(r[i].lev, pin);
+        if(!(prev == 1 && b == 0)) {
+            prev = b;
+            continue;
+        }
+
+        // falling edge: start bit.  sample in the middle of each bit.
+        uint64_t t0 = r[i].cyc;
+        if(t0 + 9.5 * bit > last)
+            break;      // runs off the end of the capture.
+
+        cursor_t c = { .r = r, .n = n, .j = i };
+        if(level_at(&c, pin, t0 + 0.5 * bit) != 0) {
+            // glitch: start bit didn't last.
+            prev = b;
+            continue;
+        }
+        la_uart_t u = { .start = t0 };
+        for(unsigned k = 0; k < 8; k++)
+            u.byte |= level_at(&c, pin, t0 + (k + 1.5) * bit) << k;
+        u.framing_err = !level_at(&c, pin, t0 + 9.5 * bit);
+        fn(f, &u, arg);
+        nbytes++;
+
+        // look for the next start bit after the middle of the stop bit.
+        i = c.j;
+        prev = la_bit(r[i].lev, pin);
+    }
+    return nbytes;
+}
+
+unsigned la_uart_autobaud(const la_file_t *f, unsigned pin) {
+    static const unsigned std[] = {
+        300, 1200, 2400, 4800, 9600, 19200, 38400, 57600,
+        115200, 230400, 460800, 921600, 1000000, 2000000,
+    };
+
+    uint64_t min = ~0ULL, last = 0;
+    int have_last = 0;
+    for(uint64_t i = 1; i < f->n; i++) {
+        if(!((f->r[i].lev ^ f->r[i-1].lev) >> pin & 1))
+            continue;
+        if(have_last && f->r[i].cyc - last < min)
+            min = f->r[i].cyc - last;
+        last = f->r[i].cyc;
+        have_last = 1;
+    }
+    if(min == ~0ULL)
+        return 0;
+
+    double est = f->hdr.cyc_per_usec * 1e6 / min;
+    for(unsigned i = 0; i < sizeof std / sizeof std[0]; i++)
+        if(est > std[i] * 0.95 && est < std[i] * 1.05)
+            return std[i];
+    return est + 0.5;
+}
+
+/*****************************************************************
+ * spi
+ */
+unsigned la_spi_decode(const la_file_t *f, const la_spi_cfg_t *c,
+                       la_spi_fn fn, void *arg) {
+    unsigned cpol = (c->mode >> 1) & 1, cpha = c->mode & 1;
+    unsigned nbits = c->nbits ? c->nbits : 8;
+    int use_cs = c->cs != ~0u;
+    if(nbits > 32)
+        die("spi: %d bits per word: max is 32\n", nbits);
+
+    const la_file_rec_t *r = f->r;
+    unsigned nwords = 0, xfer = 0;
+    int active = !use_cs || !la_bit(r[0].lev, c->cs);
+    la_spi_t w = {0};
+    unsigned nbit = 0;
+
+    for(uint64_t i = 1; i < f->n; i++) {
+        uint32_t prv = r[i-1].lev, cur = r[i].lev;
+        uint32_t diff = prv ^ cur;
+
+        if(use_cs && la_bit(diff, c->cs)) {
+            active = !la_bit(cur, c->cs);
+            if(active)
+                xfer++;
+            // a partial word is dropped.
+            nbit = 0;
+        }
+        if(!active || !la_bit(diff, c->sclk))
+            continue;
+
+        // leading edge = leaving the idle level.
+        int leading = la_bit(prv, c->sclk) == cpol;
+        if(leading == (int)cpha)
+            continue;
+
+        // data was set up before the edge: use the level before it.
+        if(!nbit)
+            w = (la_spi_t){ .start = r[i].cyc, .xfer = xfer };
+        w.mosi = w.mosi << 1 | la_bit(prv, c->mosi);
+        w.miso = w.miso << 1 | la_bit(prv, c->miso);
+        if(++nbit == nbits) {
+            fn(f, &w, arg);
+            nwords++;
+            nbit = 0;
+        }
+    }
+    return nwords;
+}
+
+/*****************************************************************
+ * i2c
+ */
+unsigned la_i2c_decode(const la_file_t *f, unsigned scl, unsigned sda,
+                       la_i2c_fn fn, void *arg) {
+    const la_file_rec_t *r = f->r;
+    unsigned nev = 0;
+    int in_frame = 0, first = 0;
+    unsigned nbit = 0, shift = 0;
+    uint64_t byte_start = 0;
+
+#   define EMIT(...) do {                           \
+        la_i2c_t _e = { __VA_ARGS__ };              \
+        fn(f, &_e, arg);                            \
+        nev++;                                      \
+    } while(0)
+
+    for(uint64_t i = 1; i < f->n; i++) {
+        uint32_t prv = r[i-1].lev, cur = r[i].lev;
+        unsigned scl0 = la_bit(prv, scl), scl1 = la_bit(cur, scl);
+        unsigned sda0 = la_bit(prv, sda), sda1 = la_bit(cur, sda);
+        uint64_t t = r[i].cyc;
+
+        // SDA moving while SCL stays high: start or stop.
+        if(scl0 && scl1 && sda0 != sda1) {
+            if(!sda1) {
+                EMIT(.type = in_frame ? LA_I2C_RESTART : LA_I2C_START, .cyc = t);
+                in_frame = 1;
+                first = 1;
+            } else if(in_frame) {
+                EMIT(.type = LA_I2C_STOP, .cyc = t);
+                in_frame = 0;
+            }
+            nbit = shift = 0;
+            continue;
+        }
+
+        // SCL rising: sample SDA (it's stable while SCL is high).
+        if(!in_frame || scl0 || !scl1)
+            continue;
+        if(nbit < 8) {
+            if(!nbit)
+                byte_start = t;
+            shift = shift << 1 | sda1;
+            nbit++;
+            continue;
+        }
+
+        // 9th clock: ack.
+        if(first)
+            EMIT(.type = LA_I2C_ADDR, .cyc = byte_start, .byte = shift >> 1,
+                .read_p = shift & 1, .ack_p = !sda1);
+        else
+            EMIT(.type = LA_I2C_DATA, .cyc = byte_start, .byte = shift,
+                .ack_p = !sda1);
+        first = 0;
+        nbit = shift = 0;
+    }
+#   undef EMIT
+    return nev;
+}
@@ -0,0 +1,107 @@
+// unix-side protocol decoders for logic-analyzer captures: read a
+// flat <.lar> file (libpi/include/la-format.h, made by <la2vcd -r>
+// or <la-synth>) and reconstruct UART bytes, SPI words and I2C
+// transactions.
+//
+// the file is mmap'd and every decoder is a single forward pass over
+// the records, so multi-million edge captures take well under a
+// second.  each decoder calls a callback per item rather than
+// building a list.
+//
+// times are in cycles since the first sample: <la_usec> converts.
+#ifndef __LA_PROTO_H__
+#define __LA_PROTO_H__
+#include <stdint.h>
+#include <stddef.h>
+#include "la-format.h"
+
+typedef struct {
+    la_file_hdr_t hdr;
+    const la_file_rec_t *r;     // hdr.nsamples records, mmap'd.
+    uint64_t n;
+
+    void *map;
+    size_t map_len;
+} la_file_t;
+
+// mmap <path>; dies on error.
+la_file_t *la_open(const char *path);
+void la_close(la_file_t *f);
+
+static inline unsigned la_bit(uint32_t lev, unsigned pin) {
+    return (lev >> pin) & 1;
+}
+static inline double la_usec(const la_file_t *f, uint64_t cyc) {
+    return (double)cyc / f->hdr.cyc_per_usec;
+}
+
+/*****************************************************************
+ * uart: 8N1, idle high, lsb first.
+ */
+typedef struct {
+    uint64_t start;         // cycle of the start bit's falling edge.
+    uint8_t byte;
+    unsigned framing_err:1; // stop bit was low.
+} la_uart_t;
+
+typedef void (*la_uart_fn)(const la_file_t *f, const la_uart_t *u, void *arg);
+
+// decode <pin> at <baud>.  returns the number of bytes.
+unsigned la_uart_decode(const la_file_t *f, unsigned pin, unsigned baud,
+                        la_uart_fn fn, void *arg);
+
+// guess the baud rate from the shortest pulse on <pin> (rounded to
+// the closest standard rate within 5%, otherwise the raw estimate).
+// 0 if there are no pulses.
+unsigned la_uart_autobaud(const la_file_t *f, unsigned pin);
+
+/*****************************************************************
+ * spi: <cs> active low (~0 = no chip select: one long transfer),
+ * msb first, <nbits> per word.  mode bit 1 = cpol (idle level of
+ * sclk), bit 0 = cpha (0: sample on the leading edge).
+ */
+typedef struct {
+    unsigned sclk, mosi, miso, cs;
+    unsigned mode;
+    unsigned nbits;         // 0 = 8.
+} la_spi_cfg_t;
+
+typedef struct {
+    uint64_t start;         // first clock edge of the word.
+    uint32_t mosi, miso;
+    unsigned xfer;          // which chip-select period.
+} la_spi_t;
+
+typedef void (*la_spi_fn)(const la_file_t *f, const la_spi_t *w, void *arg);
+
+// returns the number of words.  partial words at a cs deassert are
+// dropped.
+unsigned la_spi_decode(const la_file_t *f, const la_spi_cfg_t *c,
+                       la_spi_fn fn, void *arg);
+
+/*****************************************************************
+ * i2c: events in the order they happened on the bus.
+ */
+typedef enum {
+    LA_I2C_START,
+    LA_I2C_RESTART,
+    LA_I2C_STOP,
+    LA_I2C_ADDR,            // first byte after a (re)start.
+    LA_I2C_DATA,
+} la_i2c_type_t;
+
+typedef struct {
+    la_i2c_type_t type;
+    uint64_t cyc;
+    uint8_t byte;           // ADDR: 7-bit address; DATA: the byte.
+    unsigned read_p:1;      // ADDR: R/W bit.
+    unsigned ack_p:1;       // ADDR/DATA: acked (SDA low on 9th clock).
+} la_i2c_t;
+
+typedef void (*la_i2c_fn)(const la_file_t *f, const la_i2c_t *e, void *arg);
+
+// returns the number of events.
+unsigned la_i2c_decode(const la_file_t *f, unsigned scl, unsigned sda,
+                       la_i2c_fn fn, void *arg);
+
+#endif
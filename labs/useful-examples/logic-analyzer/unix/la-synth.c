@@ -0,0 +1,294 @@
+// generate synthetic captures (<.lar>) so the <la-proto.h>
+// decoders can be tested without a pi.  prints what it encoded in
+// the same form as <la-decode -q> so the two can be compared:
+//
+//      la-synth u.lar uart 14 115200 1000 > exp
+//      la-decode -q u.lar uart 14 115200 > got
+//      cmp exp got
+//
+// usage:
+//      la-synth <out.lar> uart <pin> <baud> <nbytes> [<seed>]
+//      la-synth <out.lar> spi <mode> <nwords> [<seed>]
+//      la-synth <out.lar> i2c <addr> <nbytes> [<seed>]
+//
+// spi uses the bcm spi0 pins (sclk=11 mosi=10 miso=9 ce0=8), i2c
+// the bsc1 pins (scl=3 sda=2).  the stamps are in cycles at 700MHz,
+// uart edges get a few cycles of jitter like a real capture.
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "la-format.h"
+
+enum {
+    CYC_PER_USEC = 700,
+    UART_JITTER = 16,
+    SPI_SCLK = 11, SPI_MOSI = 10, SPI_MISO = 9, SPI_CS = 8,
+    SPI_HALF = 100,             // cycles per half sclk period.
+    I2C_SCL = 3, I2C_SDA = 2,
+    I2C_QUARTER = 200,          // cycles per quarter scl period.
+};
+
+static void die(const char *fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    fprintf(stderr, "la-synth: ");
+    vfprintf(stderr, fmt, ap);
+    va_end(ap);
+    exit(1);
+}
+
+// reproducible: xorshift32.
+static uint32_t seed = 1;
+static uint32_t rnd(void) {
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    return seed;
+}
+
+/*****************************************************************
+ * the capture being built: one record per change.
+ */
+static la_file_rec_t *recs;
+static uint64_t nrecs, caprecs;
+static uint32_t mask, lev;
+static uint64_t now;
+
+static void start(uint32_t m, uint32_t initial) {
+    mask = m;
+    lev = initial & m;
+    now = 0;
+    nrecs = 0;
+    caprecs = 1 << 16;
+    recs = malloc(caprecs * sizeof *recs);
+    recs[nrecs++] = (la_file_rec_t){ .cyc = 0, .lev = lev };
+}
+
+static void append(void) {
+    if(nrecs == caprecs) {
+        caprecs *= 2;
+        if(!(recs = realloc(recs, caprecs * sizeof *recs)))
+            die("out of memory\n");
+    }
+    recs[nrecs++] = (la_file_rec_t){ .cyc = now, .lev = lev };
+}
+
+// set <pin> to <v> at the current time.
+static void set(unsigned pin, unsigned v) {
+    uint32_t l = (lev & ~(1u << pin)) | (v << pin);
+    if(l == lev)
+        return;
+    lev = l;
+
+    // same instant as the last change: one record.
+    la_file_rec_t *last = &recs[nrecs-1];
+    if(last->cyc >= now)
+        last->lev = lev;
+    else
+        append();
+}
+
+static void finish(const char *name) {
+    // idle a little so the last item is fully inside the capture.
+    now += 10000;
+    append();
+
+    la_file_hdr_t h = {
+        .magic = LA_FILE_MAGIC,
+        .mask = mask,
+        .cyc_per_usec = CYC_PER_USEC,
+        .trigger = ~0,
+        .nsamples = nrecs,
+    };
+    FILE *f = fopen(name, "wb");
+    if(!f)
+        die("can't open <%s>\n", name);
+    if(fwrite(&h, sizeof h, 1, f) != 1
+    || fwrite(recs, sizeof *recs, nrecs, f) != nrecs)
+        die("write to <%s> failed\n", name);
+    fclose(f);
+    fprintf(stderr, "la-synth: %llu samples\n", (unsigned long long)nrecs);
+}
+
+/*****************************************************************
+ * uart: 8N1, random idle gaps between some bytes.
+ */
+static void uart(unsigned pin, unsigned baud, unsigned n) {
+    double bit = CYC_PER_USEC * 1e6 / baud;
+    start(1u << pin, 1u << pin);
+
+    double t = 1000;
+    for(unsigned i = 0; i < n; i++) {
+        uint8_t b = rnd();
+        // 10 bits: start, 8 data lsb first, stop.
+        unsigned frame = 1u << 9 | (unsigned)b << 1;
+        for(unsigned k = 0; k < 10; k++) {
+            uint64_t jit = rnd() % UART_JITTER;
+            uint64_t at = t + k * bit + jit;
+            if(at > now)
+                now = at;
+            set(pin, (frame >> k) & 1);
+        }
+        t += 10 * bit;
+        if(rnd() % 4 == 0)
+            t += (rnd() % 20) * bit;
+        printf("%02x\n", b);
+    }
+}
+
+/*****************************************************************
+ * spi: random transfers of 1-8 words.
+ */
+static void spi(unsigned mode, unsigned n) {
+    unsigned cpol = (mode >> 1) & 1, cpha = mode & 1;
+    start(1u << SPI_SCLK | 1u << SPI_MOSI | 1u << SPI_MISO | 1u << SPI_CS,
+          1u << SPI_CS | cpol << SPI_SCLK);
+
+    now = 1000;
+    while(n) {
+        unsigned nw = 1 + rnd() % 8;
+        if(nw > n)
+            nw = n;
+        n -= nw;
+
+        set(SPI_CS, 0);
+        now += SPI_HALF;
+        for(unsigned w = 0; w < nw; w++) {
+            uint8_t mo = rnd(), mi = rnd();
+            for(int k = 7; k >= 0; k--) {
+                if(!cpha) {
+                    // data out, then sample on leading edge.
+                    set(SPI_MOSI, (mo >> k) & 1);
+                    set(SPI_MISO, (mi >> k) & 1);
+                    now += SPI_HALF / 2;
+                    set(SPI_SCLK, !cpol);
+                    now += SPI_HALF;
+                    set(SPI_SCLK, cpol);
+                    now += SPI_HALF / 2;
+                } else {
+                    // leading edge shifts out, trailing samples.
+                    set(SPI_SCLK, !cpol);
+                    now += SPI_HALF / 4;
+                    set(SPI_MOSI, (mo >> k) & 1);
+                    set(SPI_MISO, (mi >> k) & 1);
+                    now += SPI_HALF * 3 / 4;
+                    set(SPI_SCLK, cpol);
+                    now += SPI_HALF;
+                }
+            }
+            printf("%x %x\n", mo, mi);
+        }
+        set(SPI_CS, 1);
+        now += 10 * SPI_HALF;
+    }
+}
+
+/*****************************************************************
+ * i2c: write <n> bytes, repeated start, read <n> bytes.
+ */
+static void i2c_bit(unsigned v) {
+    // scl is low: change sda, then clock it.
+    set(I2C_SDA, v);
+    now += I2C_QUARTER;
+    set(I2C_SCL, 1);
+    now += 2 * I2C_QUARTER;
+    set(I2C_SCL, 0);
+    now += I2C_QUARTER;
+}
+
+static void i2c_byte(uint8_t b, unsigned ack) {
+    for(int k = 7; k >= 0; k--)
+        i2c_bit((b >> k) & 1);
+    i2c_bit(!ack);
+}
+
+static void i2c_start(void) {
+    // from scl low or idle: sda high, scl high, then sda falls.
+    set(I2C_SDA, 1);
+    now += I2C_QUARTER;
+    set(I2C_SCL, 1);
+    now += I2C_QUARTER;
+    set(I2C_SDA, 0);
+    now += I2C_QUARTER;
+    set(I2C_SCL, 0);
+    now += I2C_QUARTER;
+}
+
+static void i2c(unsigned addr, unsigned n) {
+    start(1u << I2C_SCL | 1u << I2C_SDA, 1u << I2C_SCL | 1u << I2C_SDA);
+    now = 1000;
+
+    i2c_start();
+    printf("S\n");
+    i2c_byte(addr << 1, 1);
+    printf("A %02x W ack\n", addr);
+    for(unsigned i = 0; i < n; i++) {
+        uint8_t b = rnd();
+        i2c_byte(b, 1);
+        printf("D %02x ack\n", b);
+    }
+
+    i2c_start();
+    printf("Sr\n");
+    i2c_byte(addr << 1 | 1, 1);
+    printf("A %02x R ack\n", addr);
+    for(unsigned i = 0; i < n; i++) {
+        uint8_t b = rnd();
+        // the master nacks the last byte.
+        unsigned ack = i != n - 1;
+        i2c_byte(b, ack);
+        printf("D %02x %s\n", b, ack ? "ack" : "nack");
+    }
+
+    // stop: sda low, scl high, sda rises.
+    set(I2C_SDA, 0);
+    now += I2C_QUARTER;
+    set(I2C_SCL, 1);
+    now += I2C_QUARTER;
+    set(I2C_SDA, 1);
+    printf("P\n");
+}
+
+static unsigned num(const char *s) {
+    char *end;
+    unsigned long x = strtoul(s, &end, 0);
+    if(*end)
+        die("bad number <%s>\n", s);
+    return x;
+}
+
+int main(int argc, char *argv[]) {
+    if(argc < 3)
+        goto usage;
+    const char *out = argv[1], *proto = argv[2];
+    char **a = &argv[3];
+    int na = argc - 3;
+
+    // the seed is always the optional last argument.
+    int uart_p = !strcmp(proto, "uart");
+    int nreq = uart_p ? 3 : 2;
+    if(na == nreq + 1 && !(seed = num(a[nreq])))
+        die("seed must be non-zero\n");
+    if(na != nreq && na != nreq + 1)
+        goto usage;
+
+    if(uart_p)
+        uart(num(a[0]), num(a[1]), num(a[2]));
+    else if(!strcmp(proto, "spi"))
+        spi(num(a[0]), num(a[1]));
+    else if(!strcmp(proto, "i2c"))
+        i2c(num(a[0]), num(a[1]));
+    else
+        goto usage;
+    finish(out);
+    return 0;
+
+usage:
+    die("usage: la-synth <out.lar> uart <pin> <baud> <nbytes> [<seed>]\n"
+        "       la-synth <out.lar> spi <mode> <nwords> [<seed>]\n"
+        "       la-synth <out.lar> i2c <addr> <nbytes> [<seed>]\n");
+    return 1;
+}
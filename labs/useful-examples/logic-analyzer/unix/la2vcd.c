@@ -0,0 +1,183 @@
+// engler-style unix tool: pull a logic-analyzer capture (the <LA:>
+// lines from <la_stream>, see libpi/include/la-format.h) out of a pi
+// log and convert it to a VCD file (for gtkwave etc) and/or the flat
+// mmap-able capture file the decoders read.
+//
+// usage:
+//      la2vcd [-o out.vcd] [-r out.lar] [log]
+// reads stdin if no log; writes the VCD to stdout if neither -o nor
+// -r is given.
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+
+#include "la-format.h"
+
+static void die(const char *fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    fprintf(stderr, "la2vcd: ");
+    vfprintf(stderr, fmt, ap);
+    va_end(ap);
+    exit(1);
+}
+
+typedef struct {
+    uint8_t *data;
+    size_t n, cap;
+} bytes_t;
+
+static void bytes_push(bytes_t *b, uint8_t x) {
+    if(b->n == b->cap) {
+        b->cap = b->cap ? b->cap * 2 : 4096;
+        if(!(b->data = realloc(b->data, b->cap)))
+            die("out of memory\n");
+    }
+    b->data[b->n++] = x;
+}
+
+static int hexval(int c) {
+    if(c >= '0' && c <= '9') return c - '0';
+    if(c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if(c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// concatenate the payload of every <LA:> line.  other output (the
+// pi's printk) is ignored.
+static bytes_t read_stream(FILE *in) {
+    bytes_t b = {0};
+    char line[1024];
+    size_t plen = strlen(LA_LINE_PREFIX);
+
+    while(fgets(line, sizeof line, in)) {
+        // my-install may prefix lines: search rather than compare.
+        char *p = strstr(line, LA_LINE_PREFIX);
+        if(!p)
+            continue;
+        for(p += plen; hexval(p[0]) >= 0 && hexval(p[1]) >= 0; p += 2)
+            bytes_push(&b, hexval(p[0]) << 4 | hexval(p[1]));
+    }
+    if(!b.n)
+        die("no %s lines in input\n", LA_LINE_PREFIX);
+    return b;
+}
+
+// decode into <hdr> + an array of flat records.
+static la_file_rec_t *decode(const bytes_t *b, la_file_hdr_t *hdr) {
+    la_stream_hdr_t h;
+    if(b->n < sizeof h + 4)
+        die("capture truncated: %zu bytes\n", b->n);
+    memcpy(&h, b->data, sizeof h);
+    if(h.magic != LA_STREAM_MAGIC)
+        die("bad magic %x: expected %x\n", h.magic, LA_STREAM_MAGIC);
+    if(!h.cyc_per_usec)
+        die("cyc_per_usec is 0\n");
+
+    // hash covers everything but the trailing 4 bytes.
+    const uint8_t *end = b->data + b->n - 4;
+    uint32_t want, got = la_hash(LA_HASH_INIT, b->data, end - b->data);
+    memcpy(&want, end, 4);
+    if(got != want)
+        die("hash mismatch: computed %x, capture has %x (corrupted line?)\n",
+            got, want);
+
+    la_file_rec_t *r = calloc(h.nsamples, sizeof *r);
+    if(!r)
+        die("out of memory\n");
+    r[0] = (la_file_rec_t){ .cyc = 0, .lev = h.lev0 };
+
+    const uint8_t *p = b->data + sizeof h;
+    for(uint32_t i = 1; i < h.nsamples; i++) {
+        uint32_t dcyc, dlev;
+        if(!la_varint_get(&p, end, &dcyc) || !la_varint_get(&p, end, &dlev))
+            die("truncated at sample %u of %u\n", i, h.nsamples);
+        r[i].cyc = r[i-1].cyc + dcyc;
+        r[i].lev = r[i-1].lev ^ dlev;
+    }
+    if(p != end)
+        die("%zu extra bytes after %u samples\n", (size_t)(end - p), h.nsamples);
+
+    *hdr = (la_file_hdr_t) {
+        .magic = LA_FILE_MAGIC,
+        .mask = h.mask,
+        .cyc_per_usec = h.cyc_per_usec,
+        .trigger = h.trigger,
+        .nsamples = h.nsamples,
+    };
+    return r;
+}
+
+// one VCD identifier character per pin: '!' + pin.
+static void write_vcd(FILE *out, const la_file_hdr_t *h, const la_file_rec_t *r) {
+    fprintf(out, "$comment la2vcd: %llu samples, %u cycles/usec $end\n",
+        (unsigned long long)h->nsamples, h->cyc_per_usec);
+    fprintf(out, "$timescale 1ns $end\n$scope module pi $end\n");
+    for(unsigned pin = 0; pin < 32; pin++)
+        if(h->mask & (1u << pin))
+            fprintf(out, "$var wire 1 %c gpio%u $end\n", '!' + pin, pin);
+    fprintf(out, "$upscope $end\n$enddefinitions $end\n");
+
+    uint32_t prev = ~r[0].lev;
+    for(uint64_t i = 0; i < h->nsamples; i++) {
+        uint32_t diff = (r[i].lev ^ prev) & h->mask;
+        if(!diff)
+            continue;
+        fprintf(out, "#%llu\n",
+            (unsigned long long)(r[i].cyc * 1000 / h->cyc_per_usec));
+        for(unsigned pin = 0; pin < 32; pin++)
+            if(diff & (1u << pin))
+                fprintf(out, "%u%c\n", (r[i].lev >> pin) & 1, '!' + pin);
+        prev = r[i].lev;
+    }
+}
+
+static void write_raw(const char *name, const la_file_hdr_t *h, const la_file_rec_t *r) {
+    FILE *f = fopen(name, "wb");
+    if(!f)
+        die("can't open <%s>\n", name);
+    if(fwrite(h, sizeof *h, 1, f) != 1
+    || fwrite(r, sizeof *r, h->nsamples, f) != h->nsamples)
+        die("write to <%s> failed\n", name);
+    fclose(f);
+}
+
+int main(int argc, char *argv[]) {
+    const char *vcd = 0, *raw = 0, *log = 0;
+
+    for(int i = 1; i < argc; i++) {
+        if(!strcmp(argv[i], "-o") && i+1 < argc)
+            vcd = argv[++i];
+        else if(!strcmp(argv[i], "-r") && i+1 < argc)
+            raw = argv[++i];
+        else if(argv[i][0] == '-')
+            die("usage: la2vcd [-o out.vcd] [-r out.lar] [log]\n");
+        else
+            log = argv[i];
+    }
+
+    FILE *in = stdin;
+    if(log && !(in = fopen(log, "r")))
+        die("can't open <%s>\n", log);
+    bytes_t b = read_stream(in);
+
+    la_file_hdr_t h;
+    la_file_rec_t *r = decode(&b, &h);
+    fprintf(stderr, "la2vcd: %llu samples, %.3f msec\n",
+        (unsigned long long)h.nsamples,
+        r[h.nsamples-1].cyc / (h.cyc_per_usec * 1000.0));
+
+    if(raw)
+        write_raw(raw, &h, r);
+    if(vcd || !raw) {
+        FILE *out = stdout;
+        if(vcd && !(out = fopen(vcd, "w")))
+            die("can't open <%s>\n", vcd);
+        write_vcd(out, &h, r);
+        if(vcd)
+            fclose(out);
+    }
+    return 0;
+}
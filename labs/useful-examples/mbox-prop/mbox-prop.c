@@ -0,0 +1,88 @@
+// <mbox-prop.h>: query board info, memory split, clocks and
+// temperature in one batched message, then the same tags one message
+// each, and compare the time.
+#include "rpi.h"
+#include "mbox-prop.h"
+
+static mbox_prop_t m;
+
+static const struct { uint32_t id; const char *name; } clocks[] = {
+    { MBOX_CLK_ARM, "arm" },
+    { MBOX_CLK_CORE, "core" },
+    { MBOX_CLK_SDRAM, "sdram" },
+    { MBOX_CLK_UART, "uart" },
+    { MBOX_CLK_EMMC, "emmc" },
+};
+enum { NCLK = sizeof clocks / sizeof clocks[0] };
+
+enum { NFIXED = 9, NTAGS = NFIXED + 2*NCLK };
+
+// append query <i>.
+static int add(unsigned i) {
+    switch(i) {
+    case 0: return mbox_prop_get_fw_rev(&m);
+    case 1: return mbox_prop_get_board_model(&m);
+    case 2: return mbox_prop_get_board_rev(&m);
+    case 3: return mbox_prop_get_board_serial(&m);
+    case 4: return mbox_prop_get_arm_memory(&m);
+    case 5: return mbox_prop_get_vc_memory(&m);
+    case 6: return mbox_prop_get_temp(&m);
+    case 7: return mbox_prop_get_max_temp(&m);
+    case 8: return mbox_prop_get_voltage(&m, 0);
+    }
+    i -= NFIXED;
+    if(i % 2 == 0)
+        return mbox_prop_get_clock(&m, clocks[i/2].id);
+    return mbox_prop_get_max_clock(&m, clocks[i/2].id);
+}
+
+void notmain(void) {
+    int h[NTAGS];
+    unsigned i;
+
+    // batched.
+    mbox_prop_init(&m);
+    for(i = 0; i < NTAGS; i++)
+        h[i] = add(i);
+    uint32_t s = timer_get_usec();
+    int nbad = mbox_prop_send(&m);
+    uint32_t t_batch = timer_get_usec() - s;
+    if(nbad < 0)
+        panic("mailbox rejected the message: %x\n", m.status);
+    if(nbad)
+        output("%d tags not handled by this firmware\n", nbad);
+
+    // printk's %x (and %llx's low word) isn't zero padded, so the
+    // serial's two halves go out as separate fields.
+    output("firmware rev=%x, board model=%x rev=%x serial hi=%x lo=%x\n",
+        mbox_prop_u32(&m, h[0], 0), mbox_prop_u32(&m, h[1], 0),
+        mbox_prop_u32(&m, h[2], 0), mbox_prop_u32(&m, h[3], 1),
+        mbox_prop_u32(&m, h[3], 0));
+    output("arm memory: %x + %x, vc memory: %x + %x\n",
+        mbox_prop_u32(&m, h[4], 0), mbox_prop_u32(&m, h[4], 1),
+        mbox_prop_u32(&m, h[5], 0), mbox_prop_u32(&m, h[5], 1));
+    output("temp=%dmC (max %dmC), core voltage step=%d%s\n",
+        mbox_prop_u32(&m, h[6], 1), mbox_prop_u32(&m, h[7], 1),
+        mbox_prop_u32(&m, h[8], 1),
+        mbox_prop_ok(&m, h[6]) ? "" : " (temp not handled)");
+    for(i = 0; i < NCLK; i++) {
+        int c = h[NFIXED + 2*i], mx = h[NFIXED + 2*i + 1];
+        output("  %s clock: %dHz (max %dHz)%s\n", clocks[i].name,
+            mbox_prop_u32(&m, c, 1), mbox_prop_u32(&m, mx, 1),
+            mbox_prop_ok(&m, c) ? "" : " [not handled]");
+    }
+
+    // one round trip per tag.
+    s = timer_get_usec();
+    for(i = 0; i < NTAGS; i++) {
+        mbox_prop_init(&m);
+        add(i);
+        if(mbox_prop_send(&m) < 0)
+            panic("tag %d: mailbox rejected the message\n", i);
+    }
+    uint32_t t_single = timer_get_usec() - s;
+
+    output("%d tags: one message %dusec, one message per tag %dusec (%dusec each)\n",
+        NTAGS, t_batch, t_single, t_single / NTAGS);
+    output("SUCCESS\n");
+}
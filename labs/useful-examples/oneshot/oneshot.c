@@ -0,0 +1,73 @@
+// one-shot timers (<timer-oneshot.h>): arm a bunch of timers at
+// scrambled deadlines, check they fire in deadline order and how
+// late each one is, then re-arm one from its own callback and
+// sleep with <oneshot_sleep_us>.
+#include "rpi.h"
+#include "irq-dispatch.h"
+#include "timer-oneshot.h"
+
+enum { NTIMERS = 16, NPERIODIC = 20, PERIOD_USEC = 5000 };
+
+static oneshot_t timers[NTIMERS];
+static volatile unsigned nfired;
+static unsigned order[NTIMERS];
+static uint32_t late[NTIMERS];
+
+static void fire(void *arg) {
+    oneshot_t *t = arg;
+    unsigned i = t - timers;
+    late[i] = timer_get_usec64() - t->deadline;
+    order[nfired++] = i;
+}
+
+static oneshot_t periodic;
+static volatile unsigned nticks;
+static uint32_t max_late;
+
+// re-arm relative to the old deadline so we don't drift.
+static void tick(void *arg) {
+    uint32_t l = timer_get_usec64() - periodic.deadline;
+    if(l > max_late)
+        max_late = l;
+    if(++nticks < NPERIODIC)
+        oneshot_arm(&periodic, periodic.deadline + PERIOD_USEC, tick, 0);
+}
+
+void notmain(void) {
+    irq_dispatch_init();
+    oneshot_init(SYS_TIMER_CHAN3);
+    enable_interrupts();
+
+    output("64-bit time = %llx\n", timer_get_usec64());
+
+    // deadlines 1ms apart but armed out of order.
+    uint64_t now = timer_get_usec64();
+    for(unsigned i = 0; i < NTIMERS; i++) {
+        unsigned k = (i * 7) % NTIMERS;
+        oneshot_arm(&timers[k], now + 1000 * (k+1), fire, &timers[k]);
+    }
+    // cancel one.
+    if(!oneshot_cancel(&timers[NTIMERS-1]))
+        panic("cancel failed\n");
+
+    while(nfired < NTIMERS-1)
+        ;
+    for(unsigned i = 0; i < NTIMERS-1; i++) {
+        if(order[i] != i)
+            panic("timer %d fired at position %d\n", order[i], i);
+        output("timer %d: %d usec late\n", i, late[i]);
+    }
+
+    // periodic via re-arm.
+    oneshot_arm_in(&periodic, PERIOD_USEC, tick, 0);
+    while(nticks < NPERIODIC)
+        ;
+    output("periodic: %d ticks, max lateness=%d usec\n", nticks, max_late);
+
+    uint64_t s = timer_get_usec64();
+    oneshot_sleep_us(250*1000);
+    output("slept %d usec (asked 250000)\n", (uint32_t)(timer_get_usec64() - s));
+
+    oneshot_stats();
+    output("SUCCESS\n");
+}
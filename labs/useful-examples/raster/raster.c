@@ -0,0 +1,85 @@
+// <surface.h>: time the raster primitives on the framebuffer (32bpp)
+// and on offscreen 16 and 24bpp surfaces, against the obvious
+// pixel-at-a-time loop where there is one.
+//
+// correctness is checked on the host: see unix/ (make check).
+#include "rpi.h"
+#include "cycle-count.h"
+#include "fb.h"
+
+enum { W = 640, H = 480, NLINE = 1000, NCIRC = 200 };
+
+static uint8_t off[W * H * 3] __attribute__((aligned(32)));
+
+static uint32_t seed = 1;
+// [0, n): scale the 24 random bits by <n> instead of '%', which is
+// a runtime divide (no libgcc).
+static unsigned rnd(unsigned n) {
+    seed = seed * 1103515245 + 12345;
+    return ((uint64_t)(seed >> 8) * n) >> 24;
+}
+
+#define TIME(cyc, stmt) do {                                        \
+    uint32_t s_ = cycle_cnt_read();                                 \
+    stmt;                                                           \
+    cyc = cycle_cnt_read() - s_;                                    \
+} while(0)
+
+static void bench(const char *name, surface_t *s) {
+    uint32_t c = surface_rgb(s, 0x20, 0x40, 0x80), t;
+    uint32_t nbytes = s->w * s->h * s->bytes_pp;
+
+    // raw cycles: MB/s would be a runtime divide.
+    output("%s: %dx%d %dbpp pitch=%d, %d bytes\n",
+        name, s->w, s->h, s->depth, s->pitch, nbytes);
+
+    // full-surface fill: pixel at a time vs spans.
+    TIME(t, for(unsigned y = 0; y < s->h; y++)
+                for(unsigned x = 0; x < s->w; x++)
+                    surface_put_raw(s, x, y, c));
+    output("\tclear, per pixel:  %d cycles\n", t);
+    TIME(t, surf_clear(s, c));
+    output("\tclear, STM spans:  %d cycles\n", t);
+
+    // small rects hit the head/tail paths more.
+    TIME(t, for(unsigned i = 0; i < NCIRC; i++)
+                surf_fill_rect(s, rnd(s->w), rnd(s->h), 1 + rnd(48), 1 + rnd(48), c));
+    output("\t%d small fill_rects: %d cycles\n", NCIRC, t);
+
+    seed = 1;
+    TIME(t, for(unsigned i = 0; i < NLINE; i++)
+                surf_line(s, rnd(s->w), rnd(s->h), rnd(s->w), rnd(s->h), c));
+    output("\t%d lines: %d cycles (%d per line)\n", NLINE, t, t / NLINE);
+    seed = 1;
+    TIME(t, for(unsigned i = 0; i < NLINE; i++)
+                surf_line_aa(s, rnd(s->w), rnd(s->h), rnd(s->w), rnd(s->h), c));
+    output("\t%d aa lines: %d cycles (%d per line)\n", NLINE, t, t / NLINE);
+
+    TIME(t, for(unsigned i = 0; i < NCIRC; i++)
+                surf_circle(s, rnd(s->w), rnd(s->h), rnd(100), c));
+    output("\t%d circles: %d cycles\n", NCIRC, t);
+    TIME(t, for(unsigned i = 0; i < NCIRC; i++)
+                surf_fill_circle(s, rnd(s->w), rnd(s->h), rnd(100), c));
+    output("\t%d filled circles: %d cycles\n", NCIRC, t);
+
+    // half the surface down one row (overlapping: bottom up).
+    unsigned bh = s->h / 2;
+    TIME(t, surf_blit(s, 0, 1, s, 0, 0, s->w, bh));
+    output("\tblit %dx%d (%d bytes): %d cycles\n", s->w, bh,
+        s->w * bh * s->bytes_pp, t);
+}
+
+void notmain(void) {
+    caches_enable();
+
+    fb_t *fb = fb_init(W, H, 32);
+    surface_t s = fb_back_surface(fb);
+    bench("framebuffer", &s);
+    fb_flip(fb, FB_NO_VSYNC);
+
+    s = surface_mk(off, W, H, 0, 24);
+    bench("offscreen", &s);
+    s = surface_mk(off, W, H, 0, 16);
+    bench("offscreen", &s);
+    output("SUCCESS\n");
+}
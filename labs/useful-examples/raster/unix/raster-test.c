@@ -0,0 +1,375 @@
+// host check of <surface.h>: every primitive, at 16/24/32bpp, with a
+// padded pitch and an odd-offset sub-surface, is compared byte for
+// byte against a reference image drawn a pixel at a time.  lines are
+// checked by their properties (count, endpoints, distance to the
+// ideal line; aa coverage sums).
+//
+// on a mismatch both images are written as <what>-{got,ref}.ppm.
+#include "surface.h"
+
+enum { W = 97, H = 71, PAD = 13, NRAND = 2000 };
+
+static unsigned ntests;
+
+static uint32_t seed = 1;
+static uint32_t rnd(void) {
+    seed = seed * 1103515245 + 12345;
+    return seed >> 8;
+}
+// [lo, hi]
+static int rnd_in(int lo, int hi) {
+    return lo + rnd() % (hi - lo + 1);
+}
+
+// a surface over a zeroed buffer, pitch padded to keep alignment.
+static surface_t mk(uint8_t *buf, unsigned w, unsigned h, unsigned depth) {
+    unsigned bpp = depth / 8;
+    unsigned pitch = w * bpp + (bpp == 3 ? PAD : (PAD + bpp - 1) / bpp * bpp);
+    memset(buf, 0, pitch * h);
+    return surface_mk(buf, w, h, pitch, depth);
+}
+
+static void ppm(const surface_t *s, const char *name, const char *sfx) {
+    char path[128];
+    snprintf(path, sizeof path, "%s-%s.ppm", name, sfx);
+    FILE *f = fopen(path, "w");
+    if(!f)
+        return;
+    fprintf(f, "P6 %d %d 255\n", s->w, s->h);
+    for(unsigned y = 0; y < s->h; y++)
+        for(unsigned x = 0; x < s->w; x++) {
+            uint32_t v = surface_get_raw(s, x, y);
+            if(s->depth == 16)
+                v = (v >> 11 & 0x1f) << 19 | (v >> 5 & 0x3f) << 10 | (v & 0x1f) << 3;
+            fputc(v >> 16, f);
+            fputc(v >> 8, f);
+            fputc(v, f);
+        }
+    fclose(f);
+}
+
+// whole buffers, padding included: nothing may be written outside
+// the pixels.
+static void same(const char *what, const surface_t *got, const surface_t *ref) {
+    ntests++;
+    if(!memcmp(got->p, ref->p, got->pitch * got->h))
+        return;
+    for(unsigned i = 0; i < got->pitch * got->h; i++)
+        if(got->p[i] != ref->p[i]) {
+            unsigned y = i / got->pitch, x = (i % got->pitch) / got->bytes_pp;
+            ppm(got, what, "got");
+            ppm(ref, what, "ref");
+            panic("%s (%dbpp): byte %d (x=%d y=%d%s): got %x, want %x\n",
+                what, got->depth, i, x, y, x >= got->w ? ", padding" : "",
+                got->p[i], ref->p[i]);
+        }
+}
+
+/*****************************************************************
+ * reference: one clipped pixel at a time.
+ */
+static void ref_fill_rect(const surface_t *s, int x, int y, int w, int h, uint32_t c) {
+    for(int r = y; r < y + h; r++)
+        for(int i = x; i < x + w; i++)
+            surf_pixel(s, i, r, c);
+}
+static void ref_rect(const surface_t *s, int x, int y, int w, int h, uint32_t c) {
+    for(int r = y; r < y + h; r++)
+        for(int i = x; i < x + w; i++)
+            if(r == y || r == y + h - 1 || i == x || i == x + w - 1)
+                surf_pixel(s, i, r, c);
+}
+static void ref_blit(const surface_t *d, int dx, int dy,
+                     const surface_t *s, int sx, int sy, int w, int h) {
+    // through a copy so overlapping blits read the original.
+    static uint32_t tmp[H * 2][W * 2];
+    for(int r = 0; r < h; r++)
+        for(int i = 0; i < w; i++) {
+            int x = sx + i, y = sy + r;
+            tmp[r][i] = x >= 0 && x < (int)s->w && y >= 0 && y < (int)s->h
+                ? surface_get_raw(s, x, y) | 1u << 31 : 0;
+        }
+    for(int r = 0; r < h; r++)
+        for(int i = 0; i < w; i++)
+            if(tmp[r][i] >> 31)
+                surf_pixel(d, dx + i, dy + r, tmp[r][i] & 0xffffff);
+}
+
+// filled circle: every row of the outline filled from its leftmost to
+// its rightmost pixel.
+static void ref_fill_circle(const surface_t *s, int cx, int cy, int r, uint32_t c) {
+    enum { N = 2 * (W + H) };
+    static uint8_t buf[N * N * 4];
+    surface_t o = surface_mk(buf, N, N, 0, 32);
+    memset(buf, 0, sizeof buf);
+    surf_circle(&o, N / 2, N / 2, r, 1);
+    for(int y = 0; y < N; y++) {
+        int x0 = N, x1 = -1;
+        for(int x = 0; x < N; x++)
+            if(surface_get_raw(&o, x, y)) {
+                x0 = x0 < x ? x0 : x;
+                x1 = x;
+            }
+        for(int x = x0; x <= x1; x++)
+            surf_pixel(s, cx + x - N / 2, cy + y - N / 2, c);
+    }
+}
+
+/*****************************************************************
+ * tests.
+ */
+static uint32_t rnd_color(const surface_t *s) {
+    return surface_rgb(s, rnd() & 0xff, rnd() & 0xff, rnd() & 0xff);
+}
+
+static rect_t rnd_rect(void) {
+    return (rect_t){ rnd_in(-20, W + 5), rnd_in(-20, H + 5),
+                     rnd_in(-3, W + 10), rnd_in(-3, H + 10) };
+}
+
+static void rnd_clip(surface_t *a, surface_t *b) {
+    if(rnd() % 3 == 0) {
+        surface_unclip(a);
+        surface_unclip(b);
+        return;
+    }
+    rect_t r = rnd_rect();
+    surface_clip(a, r);
+    surface_clip(b, r);
+}
+
+// random primitives on a fresh pair each time; <sub> draws through
+// an odd-offset sub-surface so spans start at every alignment.
+static void test_random(unsigned depth, int sub) {
+    static uint8_t gbuf[(W * 4 + PAD + 4) * H], rbuf[(W * 4 + PAD + 4) * H];
+    static uint8_t sbuf[(W * 4 + PAD + 4) * H];
+    surface_t G = mk(gbuf, W, H, depth), R = mk(rbuf, W, H, depth);
+    surface_t g = G, r = R;
+    if(sub) {
+        rect_t sr = { 3, 1, W - 8, H - 4 };
+        g = surface_sub(&G, sr);
+        r = surface_sub(&R, sr);
+    }
+    surface_t src = mk(sbuf, W, H, depth);
+    for(unsigned i = 0; i < W * H; i++)
+        surface_put_raw(&src, i % W, i / W, rnd_color(&src));
+
+    char what[64];
+    for(unsigned n = 0; n < NRAND; n++) {
+        rnd_clip(&g, &r);
+        uint32_t c = rnd_color(&g);
+        rect_t a = rnd_rect();
+        switch(rnd() % 8) {
+        case 0:
+            snprintf(what, sizeof what, "hspan-%d", n);
+            surf_hspan(&g, a.x, a.x + a.w, a.y, c);
+            ref_fill_rect(&r, a.x, a.y, a.w, 1, c);
+            break;
+        case 1:
+            snprintf(what, sizeof what, "vspan-%d", n);
+            surf_vspan(&g, a.x, a.y, a.y + a.h, c);
+            ref_fill_rect(&r, a.x, a.y, 1, a.h, c);
+            break;
+        case 2:
+        case 3:
+            snprintf(what, sizeof what, "fill_rect-%d", n);
+            surf_fill_rect(&g, a.x, a.y, a.w, a.h, c);
+            ref_fill_rect(&r, a.x, a.y, a.w, a.h, c);
+            break;
+        case 4:
+            snprintf(what, sizeof what, "rect-%d", n);
+            surf_rect(&g, a.x, a.y, a.w, a.h, c);
+            ref_rect(&r, a.x, a.y, a.w, a.h, c);
+            break;
+        case 5: {
+            snprintf(what, sizeof what, "fill_circle-%d", n);
+            int rad = rnd_in(-1, H);
+            surf_fill_circle(&g, a.x, a.y, rad, c);
+            ref_fill_circle(&r, a.x, a.y, rad, c);
+            break;
+        }
+        case 6: {
+            snprintf(what, sizeof what, "blit-%d", n);
+            int sx = rnd_in(-10, W), sy = rnd_in(-10, H);
+            surf_blit(&g, a.x, a.y, &src, sx, sy, a.w, a.h);
+            ref_blit(&r, a.x, a.y, &src, sx, sy, a.w, a.h);
+            break;
+        }
+        case 7: {
+            // overlapping: within the surface itself.
+            snprintf(what, sizeof what, "self-blit-%d", n);
+            surface_t gu = g, ru = r;
+            surface_unclip(&gu);
+            surface_unclip(&ru);
+            int sx = a.x + rnd_in(-4, 4), sy = a.y + rnd_in(-4, 4);
+            surf_blit(&g, a.x, a.y, &gu, sx, sy, a.w, a.h);
+            ref_blit(&r, a.x, a.y, &ru, sx, sy, a.w, a.h);
+            break;
+        }
+        }
+        same(what, &G, &R);
+    }
+
+    surface_unclip(&g);
+    surface_unclip(&r);
+    uint32_t c = rnd_color(&g);
+    surf_clear(&g, c);
+    ref_fill_rect(&r, 0, 0, r.w, r.h, c);
+    same("clear", &G, &R);
+}
+
+// bresenham on a blank surface: exactly max(|dx|,|dy|)+1 pixels, both
+// ends, each within half a pixel of the true line along the minor
+// axis.  clipped: the unclipped line masked by the clip rectangle.
+static void test_lines(unsigned depth) {
+    static uint8_t gbuf[(W * 4 + PAD + 4) * H], rbuf[(W * 4 + PAD + 4) * H];
+    surface_t g = mk(gbuf, W, H, depth), r = mk(rbuf, W, H, depth);
+    uint32_t c = surface_rgb(&g, 255, 255, 255);
+
+    for(unsigned n = 0; n < NRAND; n++) {
+        int x0 = rnd_in(0, W - 1), y0 = rnd_in(0, H - 1);
+        int x1 = rnd_in(0, W - 1), y1 = rnd_in(0, H - 1);
+        int dx = abs(x1 - x0), dy = abs(y1 - y0);
+        memset(gbuf, 0, g.pitch * g.h);
+        surf_line(&g, x0, y0, x1, y1, c);
+
+        unsigned cnt = 0;
+        for(int y = 0; y < H; y++)
+            for(int x = 0; x < W; x++) {
+                if(!surface_get_raw(&g, x, y))
+                    continue;
+                cnt++;
+                // 2 * distance along the minor axis, in exact integers.
+                long err = dx >= dy
+                    ? 2L * ((long)(y - y0) * (x1 - x0) - (long)(x - x0) * (y1 - y0))
+                    : 2L * ((long)(x - x0) * (y1 - y0) - (long)(y - y0) * (x1 - x0));
+                long major = dx >= dy ? dx : dy;
+                if(labs(err) > major)
+                    panic("line (%d,%d)-(%d,%d): (%d,%d) too far off\n",
+                        x0, y0, x1, y1, x, y);
+            }
+        if(cnt != (unsigned)(dx > dy ? dx : dy) + 1)
+            panic("line (%d,%d)-(%d,%d): %d pixels\n", x0, y0, x1, y1, cnt);
+        if(!surface_get_raw(&g, x0, y0) || !surface_get_raw(&g, x1, y1))
+            panic("line (%d,%d)-(%d,%d): missing an endpoint\n", x0, y0, x1, y1);
+        ntests++;
+
+        // clipped, endpoints possibly outside.
+        rect_t cr = rnd_rect();
+        memcpy(rbuf, gbuf, g.pitch * g.h);
+        for(int y = 0; y < H; y++)
+            for(int x = 0; x < W; x++) {
+                surface_clip(&r, cr);
+                if(!surface_in_clip(&r, x, y))
+                    surface_put_raw(&r, x, y, 0);
+            }
+        surface_unclip(&r);
+        memset(gbuf, 0, g.pitch * g.h);
+        surface_clip(&g, cr);
+        surf_line(&g, x0, y0, x1, y1, c);
+        surface_unclip(&g);
+        same("clipped line", &g, &r);
+    }
+}
+
+// antialiased: each step along the major axis splits exactly 255 of
+// intensity between two pixels; axis-aligned and 45 degree lines are
+// the bresenham line at full intensity.
+static void test_line_aa(unsigned depth) {
+    static uint8_t gbuf[(W * 4 + PAD + 4) * H], rbuf[(W * 4 + PAD + 4) * H];
+    surface_t g = mk(gbuf, W, H, depth), r = mk(rbuf, W, H, depth);
+    uint32_t white = surface_rgb(&g, 255, 255, 255);
+    // low (blue) channel's max.
+    unsigned bmax = depth == 16 ? 0x1f : 0xff;
+
+    for(unsigned n = 0; n < NRAND; n++) {
+        int x0 = rnd_in(0, W - 2), y0 = rnd_in(0, H - 2);
+        int x1 = rnd_in(0, W - 2), y1 = rnd_in(0, H - 2);
+        memset(gbuf, 0, g.pitch * g.h);
+        surf_line_aa(&g, x0, y0, x1, y1, white);
+
+        int steep = abs(y1 - y0) > abs(x1 - x0);
+        int lo = steep ? (y0 < y1 ? y0 : y1) : (x0 < x1 ? x0 : x1);
+        int hi = steep ? (y0 < y1 ? y1 : y0) : (x0 < x1 ? x1 : x0);
+        for(int m = 0; m < (steep ? H : W); m++) {
+            unsigned sum = 0;
+            for(int k = 0; k < (steep ? W : H); k++) {
+                uint32_t v = steep ? surface_get_raw(&g, k, m)
+                                   : surface_get_raw(&g, m, k);
+                sum += (v & bmax) * 255 / bmax;
+            }
+            int on = m >= lo && m <= hi;
+            // 565 rounds each of the two pixels.
+            unsigned slop = depth == 16 ? 16 : 1;
+            if(on ? abs((int)sum - 255) > (int)slop : sum != 0)
+                panic("aa line (%d,%d)-(%d,%d): step %d: intensity %d\n",
+                    x0, y0, x1, y1, m, sum);
+        }
+        ntests++;
+    }
+
+    int ends[][4] = {
+        { 2, 5, 80, 5 }, { 7, 3, 7, 60 }, { 1, 1, 60, 60 },
+        { 60, 2, 2, 60 }, { 90, 60, 20, 60 },
+    };
+    for(unsigned i = 0; i < sizeof ends / sizeof ends[0]; i++) {
+        int *e = ends[i];
+        memset(gbuf, 0, g.pitch * g.h);
+        memset(rbuf, 0, r.pitch * r.h);
+        surf_line_aa(&g, e[0], e[1], e[2], e[3], white);
+        surf_line(&r, e[0], e[1], e[2], e[3], white);
+        same("aa straight line", &g, &r);
+    }
+}
+
+// blending: 0 leaves the pixel, 255 replaces it, 128 is halfway.
+static void test_blend(unsigned depth) {
+    static uint8_t buf[(W * 4 + PAD + 4) * H];
+    surface_t s = mk(buf, W, H, depth);
+    uint32_t bg = surface_rgb(&s, 0x10, 0x80, 0xf0);
+    uint32_t fg = surface_rgb(&s, 0xf0, 0x00, 0x30);
+
+    surface_put_raw(&s, 0, 0, bg);
+    surf_blend(&s, 0, 0, fg, 0);
+    surface_put_raw(&s, 1, 0, bg);
+    surf_blend(&s, 1, 0, fg, 255);
+    if(surface_get_raw(&s, 0, 0) != bg || surface_get_raw(&s, 1, 0) != fg)
+        panic("blend %dbpp: 0/255 wrong\n", depth);
+
+    surface_put_raw(&s, 2, 0, bg);
+    surf_blend(&s, 2, 0, fg, 128);
+    uint32_t v = surface_get_raw(&s, 2, 0);
+    uint32_t want = surface_rgb(&s, 0x80, 0x40, 0x90);
+    unsigned tol = depth == 16 ? 1 : 2;
+    for(unsigned sh = 0; sh < 24; sh += 8) {
+        // compare per channel in the surface's layout.
+        unsigned a, b;
+        if(depth == 16) {
+            unsigned shift = sh == 0 ? 0 : sh == 8 ? 5 : 11;
+            unsigned m = sh == 8 ? 0x3f : 0x1f;
+            a = v >> shift & m;
+            b = want >> shift & m;
+        } else {
+            a = v >> sh & 0xff;
+            b = want >> sh & 0xff;
+        }
+        if(abs((int)a - (int)b) > (int)tol)
+            panic("blend %dbpp: half: got %x, want %x\n", depth, v, want);
+    }
+    ntests++;
+}
+
+int main(void) {
+    unsigned depths[] = { 16, 24, 32 };
+    for(unsigned i = 0; i < 3; i++) {
+        unsigned d = depths[i];
+        test_random(d, 0);
+        test_random(d, 1);
+        test_lines(d);
+        test_line_aa(d);
+        test_blend(d);
+        printf("%dbpp: ok\n", d);
+    }
+    printf("raster-test: %d checks passed\n", ntests);
+    return 0;
+}
@@ -0,0 +1,94 @@
+// run synthetic periodic task sets under the EDF class in
+// <libpi/include/rt-sched.h> with best-effort rpi-threads soaking up
+// the idle time, and print the deadline-miss report.
+//
+//  1. a schedulable set (utilization ~0.2): should have 0 misses.
+//  2. the same set plus a hog that pushes utilization to ~1.1:
+//     should show misses, and the best-effort threads should
+//     still make some progress.
+//
+// runs on the pi or under qemu:
+//    qemu-system-arm -M raspi0 -nographic -kernel edf-test.elf
+// (qemu's timing is wall-clock based so the budgets are only
+// approximate, but the miss counts are.)
+#include "rpi.h"
+#include "rpi-thread.h"
+#include "rt-sched.h"
+#include "vector-base.h"
+
+enum { RUN_USEC = 2 * 1000 * 1000 };
+
+// each job spins for <arg> usec to fake work.
+static void busy(void *arg) {
+    uint32_t usec = (uint32_t)arg;
+    uint32_t s = timer_get_usec_raw();
+    while((timer_get_usec_raw() - s) < usec)
+        ;
+}
+
+void int_vector(uint32_t pc) {
+    dev_barrier();
+    if(!rt_sched_int())
+        panic("unexpected interrupt: pc=%x\n", pc);
+    dev_barrier();
+}
+
+// best-effort thread: count how many times we get to run
+// until time is up.
+static volatile unsigned be_iters;
+static uint32_t end_usec;
+static void best_effort(void *arg) {
+    while((int32_t)(timer_get_usec() - end_usec) < 0) {
+        be_iters++;
+        rpi_yield();
+    }
+}
+
+static void run(const char *msg) {
+    output("----------------------------------------------\n");
+    output("%s\n", msg);
+
+    be_iters = 0;
+    end_usec = timer_get_usec() + RUN_USEC;
+
+    rt_sched_start(SYS_TIMER_CHAN1);
+    rpi_fork(best_effort, 0);
+    rpi_fork(best_effort, 0);
+    rpi_thread_start();
+    rt_sched_stop();
+
+    rt_sched_report();
+    output("best-effort iterations: %d\n", be_iters);
+}
+
+// utilization (budget / period): .08 + .1 + .018 ~= 0.2
+static void add_base_set(void) {
+    //           name       job   work(us)       period  budget
+    rt_task_add("stepper",  busy, (void*)30,       500,    40);
+    rt_task_add("sensor",   busy, (void*)80,      1000,   100);
+    rt_task_add("frame",    busy, (void*)250,    16667,   300);
+}
+
+void notmain(void) {
+    extern uint32_t default_vec_ints[];
+
+    kmalloc_init(1);
+
+    dev_barrier();
+    PUT32(IRQ_Disable_1, 0xffffffff);
+    PUT32(IRQ_Disable_2, 0xffffffff);
+    dev_barrier();
+    vector_base_set(default_vec_ints);
+    enable_interrupts();
+
+    add_base_set();
+    run("schedulable task set");
+    rt_sched_reset();
+
+    add_base_set();
+    rt_task_add("hog",      busy, (void*)1800,    2000,  1800);
+    run("overloaded task set");
+    rt_sched_reset();
+
+    output("SUCCESS\n");
+}
@@ -0,0 +1,180 @@
+// <spi-async.h>: loopback-check queued transfers (both engines), then
+// compare throughput and cpu use against blocking transfers at a
+// few clock dividers.
+//
+// wiring: jumper MOSI (gpio 10) to MISO (gpio 9).
+//
+// the blocking baseline: staff <spi_n_transfer> only allows one clock
+// divider per boot, so it runs at BASE_DIV and the sweep uses
+// <poll_transfer> below, the same loop (fill fifo, drain fifo, spin).
+#include "rpi.h"
+#include "cycle-count.h"
+#include "cpu-freq.h"
+#include "irq-dispatch.h"
+#include "spi-async.h"
+
+enum {
+    NXFER = 16,         // transfers per run.
+    XFER = 4096,        // bytes per transfer.
+    BASE_DIV = 32,
+};
+
+static uint8_t tx[NXFER][XFER] __attribute__((aligned(32)));
+static uint8_t rx[NXFER][XFER] __attribute__((aligned(32)));
+
+static void fill_rand(uint32_t seed) {
+    for(unsigned i = 0; i < NXFER; i++)
+        for(unsigned j = 0; j < XFER; j++) {
+            seed = seed * 1103515245 + 12345;
+            tx[i][j] = seed >> 16;
+        }
+    memset(rx, 0, sizeof rx);
+}
+
+static void check(const char *what, unsigned nxfer, unsigned n) {
+    for(unsigned i = 0; i < nxfer; i++)
+        for(unsigned j = 0; j < n; j++)
+            if(rx[i][j] != tx[i][j])
+                panic("%s: transfer %d byte %d: sent %x, got %x (is MOSI jumpered to MISO?)\n",
+                    what, i, j, tx[i][j], rx[i][j]);
+}
+
+/*****************************************************************
+ * blocking baseline (spi0 registers: bcm2835 p152).
+ */
+enum {
+    SPI_CS = 0x20204000, SPI_FIFO = 0x20204004, SPI_CLK = 0x20204008,
+    CS_CLEAR = 3 << 4, CS_TA = 1 << 7, CS_DONE = 1 << 16,
+    CS_RXD = 1 << 17, CS_TXD = 1 << 18,
+};
+static void poll_transfer(unsigned div, uint8_t *r, const uint8_t *t, unsigned n) {
+    dev_barrier();
+    PUT32(SPI_CLK, div);
+    PUT32(SPI_CS, CS_CLEAR | CS_TA);
+    unsigned ti = 0, ri = 0;
+    while(ri < n) {
+        while(ti < n && ti - ri < 64 && (GET32(SPI_CS) & CS_TXD))
+            PUT32(SPI_FIFO, t[ti++]);
+        while(ri < n && (GET32(SPI_CS) & CS_RXD))
+            r[ri++] = GET32(SPI_FIFO);
+    }
+    while(!(GET32(SPI_CS) & CS_DONE))
+        ;
+    PUT32(SPI_CS, CS_CLEAR);
+    dev_barrier();
+}
+
+/*****************************************************************
+ * async.
+ */
+static volatile unsigned ndone;
+static void done(uint8_t *r, unsigned n, void *arg) {
+    if(r != rx[(unsigned)arg])
+        panic("callback %d: wrong rx buffer\n", (unsigned)arg);
+    ndone++;
+}
+
+// queue every transfer, then count how much a dummy loop gets done
+// while they run.  returns cycles until the last callback.
+static uint32_t run_async(unsigned div, unsigned n, uint32_t *busy_cyc,
+                          uint32_t *spins) {
+    spi_t s = spi_async_dev(SPI_CE0, div);
+    spi_async_stats_t st0 = spi_async_stats();
+
+    ndone = 0;
+    uint32_t start = cycle_cnt_read();
+    for(unsigned i = 0; i < NXFER; i++)
+        if(!spi_submit(s, rx[i], tx[i], n, done, (void *)i))
+            panic("queue full at %d\n", i);
+    uint32_t submit = cycle_cnt_read() - start;
+
+    uint32_t k = 0;
+    while(ndone < NXFER)
+        k++;
+    uint32_t t = cycle_cnt_read() - start;
+
+    spi_async_stats_t st1 = spi_async_stats();
+    *busy_cyc = submit + (uint32_t)(st1.irq_cyc - st0.irq_cyc);
+    *spins = k;
+    return t;
+}
+
+static void sweep(unsigned mode, const char *name) {
+    unsigned divs[] = { 256, 64, 32, 16, 8 };
+    unsigned total = NXFER * XFER;
+
+    spi_async_init(mode);
+    output("%s: %d bytes per run\n", name, total);
+    for(unsigned i = 0; i < sizeof divs / sizeof divs[0]; i++) {
+        unsigned d = divs[i];
+
+        fill_rand(d);
+        uint32_t s = cycle_cnt_read();
+        for(unsigned j = 0; j < NXFER; j++)
+            poll_transfer(d, rx[j], tx[j], XFER);
+        uint32_t t_poll = cycle_cnt_read() - s;
+        check("blocking", NXFER, XFER);
+
+        fill_rand(d + 1);
+        uint32_t busy, spins;
+        uint32_t t = run_async(d, XFER, &busy, &spins);
+        check(name, NXFER, XFER);
+
+        // raw usec and cycles: rates and percentages would be runtime
+        // divides (no libgcc).
+        output("  div=%d: blocking %dusec (all busy), async %dusec (busy %d of %d cycles, %d spins free)\n",
+            d, cpu_cyc_to_usec(t_poll), cpu_cyc_to_usec(t), busy, t, spins);
+    }
+    spi_async_stats_print(name);
+}
+
+void notmain(void) {
+    caches_enable();
+    irq_dispatch_init();
+
+    // staff baseline first, before we touch the spi.
+    spi_t s = spi_n_init(SPI_CE0, BASE_DIV);
+    fill_rand(1);
+    uint32_t start = cycle_cnt_read();
+    for(unsigned i = 0; i < NXFER; i++)
+        spi_n_transfer(s, rx[i], tx[i], XFER);
+    uint32_t t_staff = cycle_cnt_read() - start;
+    check("spi_n_transfer", NXFER, XFER);
+
+    fill_rand(2);
+    start = cycle_cnt_read();
+    for(unsigned i = 0; i < NXFER; i++)
+        poll_transfer(BASE_DIV, rx[i], tx[i], XFER);
+    uint32_t t_poll = cycle_cnt_read() - start;
+    check("blocking", NXFER, XFER);
+    output("div=%d, %d bytes: spi_n_transfer %dusec, blocking loop %dusec\n",
+        BASE_DIV, NXFER * XFER, cpu_cyc_to_usec(t_staff), cpu_cyc_to_usec(t_poll));
+
+    enable_interrupts();
+
+    // odd sizes, rx/tx of 0, both chip selects.
+    unsigned modes[] = { SPI_ASYNC_DMA, SPI_ASYNC_IRQ };
+    for(unsigned m = 0; m < 2; m++) {
+        spi_async_init(modes[m]);
+        unsigned sizes[] = { 1, 3, 4, 5, 63, 64, 65, 1000, XFER };
+        for(unsigned i = 0; i < sizeof sizes / sizeof sizes[0]; i++) {
+            fill_rand(sizes[i]);
+            for(unsigned j = 0; j < NXFER; j++)
+                spi_submit(spi_async_dev(j % 2 ? SPI_CE1 : SPI_CE0, 16 + 2*j),
+                    rx[j], tx[j], sizes[i], 0, 0);
+            spi_async_wait();
+            check(m ? "irq" : "dma", NXFER, sizes[i]);
+        }
+        spi_submit(spi_async_dev(SPI_CE0, 16), 0, tx[0], XFER, 0, 0);
+        spi_submit(spi_async_dev(SPI_CE0, 16), rx[0], 0, XFER, 0, 0);
+        spi_async_wait();
+        for(unsigned j = 0; j < XFER; j++)
+            if(rx[0][j])
+                panic("tx=0: byte %d=%x, expected 0\n", j, rx[0][j]);
+    }
+    output("loopback: ok\n");
+
+    sweep(SPI_ASYNC_DMA, "dma");
+    sweep(SPI_ASYNC_IRQ, "irq");
+    output("SUCCESS\n");
+}
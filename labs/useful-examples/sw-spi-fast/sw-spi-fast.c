@@ -0,0 +1,106 @@
+// <sw-spi-fast.h>: loopback-check the specialized bit-banged spi in
+// all four modes and the parallel lanes, then compare the SCK rate
+// with staff-sw-spi.o's <spi_n_transfer>.
+//
+// wiring (same pins as the hardware spi): jumper MOSI (10) to MISO
+// (9).  for the parallel test also 20 -> 19 and 21 -> 26.
+#include "rpi.h"
+#include "cycle-count.h"
+#include "spi.h"
+#include "sw-spi-fast.h"
+
+enum { MOSI = 10, MISO = 9, SCK = 11, CE0 = 8, N = 4096 };
+
+gen_sw_spi(m0, MOSI, MISO, SCK, SW_SPI_MODE0, 0)
+gen_sw_spi(m1, MOSI, MISO, SCK, SW_SPI_MODE1, 0)
+gen_sw_spi(m2, MOSI, MISO, SCK, SW_SPI_MODE2, 0)
+gen_sw_spi(m3, MOSI, MISO, SCK, SW_SPI_MODE3, 0)
+// write-only, and a slowed-down one (~1/4 the clock).
+gen_sw_spi(wo, MOSI, SW_SPI_NO_PIN, SCK, SW_SPI_MODE0, 0)
+gen_sw_spi(slow, MOSI, MISO, SCK, SW_SPI_MODE0, 40)
+
+static uint8_t tx[3][N], rx[3][N];
+
+static void fill_rand(uint32_t seed) {
+    for(unsigned l = 0; l < 3; l++)
+        for(unsigned i = 0; i < N; i++) {
+            seed = seed * 1103515245 + 12345;
+            tx[l][i] = seed >> 16;
+        }
+    memset(rx, 0, sizeof rx);
+}
+
+static void check(const char *what, unsigned lane) {
+    for(unsigned i = 0; i < N; i++)
+        if(rx[lane][i] != tx[lane][i])
+            panic("%s: byte %d: sent %x, got %x (jumpers?)\n",
+                what, i, tx[lane][i], rx[lane][i]);
+}
+
+// cycles per SCK period for <N> bytes in <cyc> cycles.  the rate
+// (cpu MHz / this) would be a runtime divide, which needs libgcc;
+// this one is by a constant.
+static uint32_t sck_cyc(uint32_t cyc) {
+    return cyc / (N * 8);
+}
+
+#define RUN(name, fn) do {                                          \
+    fill_rand(__LINE__);                                            \
+    gpio_fast_off(CE0);                                             \
+    uint32_t s = cycle_cnt_read();                                  \
+    fn(rx[0], tx[0], N);                                            \
+    uint32_t t = cycle_cnt_read() - s;                              \
+    gpio_fast_on(CE0);                                              \
+    check(name, 0);                                                 \
+    output("%s: %d bytes in %d cycles: SCK every %d cycles\n",      \
+        name, N, t, sck_cyc(t));                                    \
+} while(0)
+
+void notmain(void) {
+    caches_enable();
+
+    // staff first: its init sets up the same pins.
+    spi_t s = spi_n_init(SPI_CE0, 1);
+    fill_rand(1);
+    uint32_t start = cycle_cnt_read();
+    spi_n_transfer(s, rx[0], tx[0], N);
+    uint32_t t_staff = cycle_cnt_read() - start;
+    check("staff spi_n_transfer", 0);
+    output("staff spi_n_transfer: %d bytes in %d cycles: SCK every %d cycles\n",
+        N, t_staff, sck_cyc(t_staff));
+
+    gpio_set_output(CE0);
+    gpio_set_on(CE0);
+    m0_init();
+    RUN("mode 0", m0_transfer);
+    m1_init();
+    RUN("mode 1", m1_transfer);
+    m2_init();
+    RUN("mode 2", m2_transfer);
+    m3_init();
+    RUN("mode 3", m3_transfer);
+    slow_init();
+    RUN("mode 0, delay 40", slow_transfer);
+
+    wo_init();
+    fill_rand(2);
+    start = cycle_cnt_read();
+    wo_transfer(0, tx[0], N);
+    uint32_t t = cycle_cnt_read() - start;
+    output("write-only: SCK every %d cycles\n", sck_cyc(t));
+
+    // three lanes sharing SCK.
+    static sw_spi_par_t p;
+    unsigned mosi[] = { MOSI, 20, 21 }, miso[] = { MISO, 19, 26 };
+    sw_spi_par_init(&p, SCK, mosi, miso, 3, 0);
+    fill_rand(3);
+    uint8_t *r[] = { rx[0], rx[1], rx[2] };
+    const uint8_t *w[] = { tx[0], tx[1], tx[2] };
+    start = cycle_cnt_read();
+    sw_spi_par_transfer(&p, r, w, N);
+    t = cycle_cnt_read() - start;
+    for(unsigned l = 0; l < 3; l++)
+        check("parallel", l);
+    output("parallel x3: SCK every %d cycles (3 bits each)\n", sck_cyc(t));
+    output("SUCCESS\n");
+}
@@ -0,0 +1,116 @@
+// <sw-uart-multi.h>: how many 115200 channels can one sampler run?
+//
+//  1. cost: feed <msu_tick> precomputed levels with every channel
+//     receiving back-to-back bytes (the worst case) for 1..16
+//     channels and compare cycles/tick against the tick period.
+//  2. live: jumper the mini-uart TX (pin 14) to pins 20 and 21 and
+//     receive 256 bytes on both from the arm timer interrupt.
+//
+// the decoder itself is checked on the host: see unix/.
+#include "rpi.h"
+#include "cycle-count.h"
+#include "cpu-freq.h"
+#include "irq-dispatch.h"
+#include "sw-uart.h"
+#include "sw-uart-multi.h"
+
+enum {
+    BAUD = 115200,
+    OS = 4,
+    NBYTES = 8,
+    // NBYTES back-to-back frames plus two idle bits.
+    NTICKS = OS * (10 * NBYTES + 2),
+    NREP = 16,
+};
+
+static msu_t m;
+static uint32_t levs[NTICKS + MSU_MAX_CHAN];
+
+// channel <c> (pin 2+c) starts <c> ticks late so the phases spread.
+static void mk_levels(unsigned nchan) {
+    for(unsigned i = 0; i < NTICKS + MSU_MAX_CHAN; i++) {
+        uint32_t lev = ~0;
+        for(unsigned c = 0; c < nchan; c++) {
+            if(i < c)
+                continue;
+            unsigned bit = (i - c) / OS, byte = bit / 10;
+            if(byte >= NBYTES)
+                continue;
+            unsigned frame = 1u << 9 | ((0x55 + byte + c) & 0xff) << 1;
+            if(!((frame >> (bit % 10)) & 1))
+                lev &= ~(1u << (2 + c));
+        }
+        levs[i] = lev;
+    }
+}
+
+static unsigned cost(unsigned nchan) {
+    unsigned pins[MSU_MAX_CHAN];
+    for(unsigned c = 0; c < nchan; c++)
+        pins[c] = 2 + c;
+    msu_state_init(&m, pins, nchan, OS);
+    mk_levels(nchan);
+
+    uint32_t s = cycle_cnt_read();
+    for(unsigned r = 0; r < NREP; r++)
+        for(unsigned i = 0; i < NTICKS + MSU_MAX_CHAN; i++)
+            msu_tick(&m, levs[i]);
+    uint32_t t = (cycle_cnt_read() - s) / (NREP * (NTICKS + MSU_MAX_CHAN));
+
+    for(unsigned c = 0; c < nchan; c++)
+        if(m.ch[c].st.nbytes != NREP * NBYTES)
+            panic("chan %d: got %d bytes, expected %d\n",
+                c, m.ch[c].st.nbytes, NREP * NBYTES);
+    return t;
+}
+
+void notmain(void) {
+    caches_enable();
+
+    uint32_t period = BAUD_TO_CYCLES(BAUD * OS);
+    output("%d baud x%d: tick every %d cycles\n", BAUD, OS, period);
+
+    unsigned max = 0;
+    for(unsigned n = 1; n <= MSU_MAX_CHAN; n++) {
+        unsigned t = cost(n);
+        output("  %d channels: %d of %d cycles/tick (polled)\n",
+            n, t, period);
+        // leave half the cpu for everything else.
+        if(t < period / 2)
+            max = n;
+    }
+    output("channels at %d baud in under 50%% cpu: %d (all %d tested)\n",
+        BAUD, max, MSU_MAX_CHAN);
+
+    // live: two pins on the uart TX line.
+    irq_dispatch_init();
+    unsigned pins[] = { 20, 21 };
+    msu_init(&m, pins, 2, BAUD, OS);
+    msu_timer_start(&m);
+    enable_interrupts();
+
+    uart_flush_tx();
+    // let the tail of the last output drain out of the decoder.
+    delay_ms(10);
+    for(unsigned c = 0; c < 2; c++)
+        while(msu_get8_nonblk(&m, c) >= 0)
+            ;
+    uint32_t busy0 = m.busy_cyc, s = cycle_cnt_read();
+    for(unsigned i = 0; i < 256; i++)
+        uart_put8(i);
+    uart_flush_tx();
+    delay_ms(1);
+    uint32_t busy = m.busy_cyc - busy0, elapsed = cycle_cnt_read() - s;
+    msu_timer_stop(&m);
+
+    for(unsigned c = 0; c < 2; c++)
+        for(unsigned i = 0; i < 256; i++) {
+            int x = msu_get8_nonblk(&m, c);
+            if(x != i)
+                panic("chan %d byte %d: got %d\n", c, i, x);
+        }
+    output("live: 2 channels got all 256 bytes; timer mode handler busy %d of %d cycles\n",
+        busy, elapsed);
+    msu_stats_print(&m);
+    output("SUCCESS\n");
+}
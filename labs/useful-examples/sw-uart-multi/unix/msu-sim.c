@@ -0,0 +1,178 @@
+// host test for the <sw-uart-multi.h> decoder: synthesize N uart
+// streams (each with its own baud error, phase, idle gaps and
+// glitches), sample them the way the pi does (GPLEV0 at os*baud, with
+// some tick jitter), run <msu_tick> over the samples and check every
+// channel got back exactly what was sent.
+//
+// usage:
+//      msu-sim <nchan> <baud> <os> <nbytes> [<max baud err %> [<seed>]]
+//
+// exits non-zero on any mismatch.
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define RPI_UNIX
+#define gcc_mb() asm volatile("" ::: "memory")
+#define panic(fmt, args...) \
+    do { fprintf(stderr, "msu-sim: " fmt, ##args); exit(1); } while(0)
+#include "sw-uart-multi.h"
+
+enum { FIRST_PIN = 2, JITTER_PCT = 10, GLITCH_PCT = 12 };
+
+static void die(const char *fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    fprintf(stderr, "msu-sim: ");
+    vfprintf(stderr, fmt, ap);
+    va_end(ap);
+    exit(1);
+}
+
+// reproducible: xorshift32.
+static uint32_t seed = 1;
+static uint32_t rnd(void) {
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    return seed;
+}
+// uniform in [-1, 1].
+static double rnd_pm1(void) {
+    return (rnd() % 2001) / 1000.0 - 1;
+}
+
+/*****************************************************************
+ * one channel's waveform: the times (in our ticks) where the line
+ * changes, starting high.
+ */
+typedef struct {
+    double *t;
+    unsigned n, cap;
+    uint8_t *sent;
+    unsigned nsent;
+} wave_t;
+
+static void edge(wave_t *w, double t) {
+    if(w->n == w->cap) {
+        w->cap = w->cap ? 2 * w->cap : 1024;
+        if(!(w->t = realloc(w->t, w->cap * sizeof *w->t)))
+            die("out of memory\n");
+    }
+    w->t[w->n++] = t;
+}
+
+// <bit> = one sender bit in our ticks.  returns the end time.
+static double gen(wave_t *w, unsigned nbytes, double bit, double t) {
+    unsigned lev = 1;
+    w->sent = malloc(nbytes);
+    for(unsigned i = 0; i < nbytes; i++) {
+        // idle gap: usually none, sometimes a few bits, with a
+        // glitch in the middle of long ones.
+        unsigned gap = rnd() % 4 == 0 ? 1 + rnd() % 6 : 0;
+        if(gap >= 3 && rnd() % 2) {
+            double g = t + gap * bit / 2;
+            edge(w, g);
+            edge(w, g + bit * GLITCH_PCT / 100);
+        }
+        t += gap * bit;
+
+        uint8_t b = rnd();
+        w->sent[w->nsent++] = b;
+        unsigned frame = 1u << 9 | (unsigned)b << 1;
+        for(unsigned k = 0; k < 10; k++, t += bit) {
+            unsigned v = (frame >> k) & 1;
+            if(v != lev) {
+                edge(w, t);
+                lev = v;
+            }
+        }
+    }
+    return t;
+}
+
+int main(int argc, char *argv[]) {
+    if(argc < 5 || argc > 7)
+        die("usage: msu-sim <nchan> <baud> <os> <nbytes> [<max baud err %%> [<seed>]]\n");
+    unsigned nchan = atoi(argv[1]), baud = atoi(argv[2]),
+             os = atoi(argv[3]), nbytes = atoi(argv[4]);
+    double max_err = argc > 5 ? atof(argv[5]) : 2;
+    if(argc > 6 && !(seed = strtoul(argv[6], 0, 0)))
+        die("seed must be non-zero\n");
+    if(nchan > MSU_MAX_CHAN || FIRST_PIN + nchan > 32)
+        die("too many channels: %u\n", nchan);
+
+    unsigned pins[MSU_MAX_CHAN];
+    wave_t w[MSU_MAX_CHAN];
+    memset(w, 0, sizeof w);
+
+    // each sender has its own clock: bit time in our ticks.
+    double end = 0;
+    for(unsigned c = 0; c < nchan; c++) {
+        pins[c] = FIRST_PIN + c;
+        double bit = os * (1 + rnd_pm1() * max_err / 100);
+        double t = gen(&w[c], nbytes, bit, 10 + (rnd() % 1000) / 100.0);
+        if(t > end)
+            end = t;
+    }
+    end += 4 * os;
+
+    static msu_t m;
+    msu_state_init(&m, pins, nchan, os);
+
+    // drain the queues as we go, like a reader on the pi would.
+    unsigned pos[MSU_MAX_CHAN] = {0}, ngot[MSU_MAX_CHAN] = {0};
+    int *got[MSU_MAX_CHAN];
+    for(unsigned c = 0; c < nchan; c++)
+        got[c] = malloc((nbytes + 1) * sizeof **got);
+
+    // sample: tick <i> actually happens at i + jitter.
+    uint32_t lev = m.pins;
+    for(unsigned i = 0; i < end; i++) {
+        double t = i + (rnd() % (JITTER_PCT + 1)) / 100.0;
+        for(unsigned c = 0; c < nchan; c++)
+            for(; pos[c] < w[c].n && w[c].t[pos[c]] <= t; pos[c]++)
+                lev ^= 1u << pins[c];
+        msu_tick(&m, lev);
+
+        for(unsigned c = 0; c < nchan; c++) {
+            int x;
+            while((x = msu_get8_nonblk(&m, c)) >= 0)
+                if(ngot[c] <= nbytes)
+                    got[c][ngot[c]++] = x;
+        }
+    }
+
+    unsigned bad = 0, total = 0, nglitch = 0;
+    for(unsigned c = 0; c < nchan; c++) {
+        msu_chan_stats_t *s = &m.ch[c].st;
+        if(ngot[c] != w[c].nsent) {
+            fprintf(stderr, "chan %u: sent %u bytes, got %u\n",
+                c, w[c].nsent, ngot[c]);
+            bad++;
+        }
+        for(unsigned i = 0; i < w[c].nsent && i < ngot[c]; i++) {
+            if(got[c][i] != w[c].sent[i]) {
+                if(!bad)
+                    fprintf(stderr, "chan %u byte %u: sent %02x, got %02x\n",
+                        c, i, w[c].sent[i], got[c][i]);
+                bad++;
+            }
+        }
+        if(s->nframe_err) {
+            fprintf(stderr, "chan %u: %u framing errors\n", c, s->nframe_err);
+            bad++;
+        }
+        total += w[c].nsent;
+        nglitch += s->nglitch;
+        free(w[c].t);
+        free(w[c].sent);
+        free(got[c]);
+    }
+    printf("msu-sim: %u channels, %u baud x%u, +-%.1f%% baud: %u bytes, "
+        "%u glitches rejected, %u bad\n",
+        nchan, baud, os, max_err, total, nglitch, bad);
+    return bad != 0;
+}
@@ -0,0 +1,105 @@
+// <sw-uart-rx.h>: find the highest baud rate the edge-driven
+// receiver gets without errors, and its CPU use at 230400.
+//
+// jumper the mini-uart TX (pin 14) to pin 21.  for each baud we
+// switch the mini-uart to it, send a queue's worth of bytes
+// back-to-back and compare.  your terminal shows garbage while each
+// test runs: results are printed after switching back to 115200.
+#include "rpi.h"
+#include "cycle-count.h"
+#include "irq-dispatch.h"
+#include "sw-uart-rx.h"
+
+enum {
+    RX_PIN = 21,
+    // the rx queue holds QSIZE-1 and isn't drained during a burst.
+    N = SW_UART_RX_QSIZE - 1,
+    AUX_MU_BAUD = 0x20215068,
+    AUX_CLOCK = 250*1000*1000,
+};
+
+static sw_uart_rx_t rx;
+
+// the mini-uart can only do 250MHz / (8 * (div+1)).  everything per
+// baud is computed here from constants so it folds: there's no
+// libgcc for a runtime divide.
+typedef struct {
+    unsigned baud, actual;
+    uint32_t reg;               // AUX_MU_BAUD value.
+    uint32_t usec_per_bit_q16;  // <BAUD_TO_USEC_Q16>(actual).
+    uint32_t two_bytes_usec;    // 20 bit times.
+} mu_baud_t;
+#define MU_DIV(b) (AUX_CLOCK / (8 * (b)))
+#define MU_ACTUAL(b) (AUX_CLOCK / (8 * MU_DIV(b)))
+#define MU_BAUD(b) {                                    \
+    .baud = (b), .actual = MU_ACTUAL(b),                \
+    .reg = MU_DIV(b) - 1,                               \
+    .usec_per_bit_q16 = BAUD_TO_USEC_Q16(MU_ACTUAL(b)), \
+    .two_bytes_usec = 20 * 1000 * 1000 / MU_ACTUAL(b),  \
+}
+
+static const mu_baud_t mu_115200 = MU_BAUD(115200);
+
+static void mu_set_baud(const mu_baud_t *b) {
+    uart_flush_tx();
+    dev_barrier();
+    PUT32(AUX_MU_BAUD, b->reg);
+    dev_barrier();
+}
+
+// returns number of bytes wrong or missing.
+static unsigned run(const mu_baud_t *b) {
+    mu_set_baud(b);
+    sw_uart_rx_init_helper(&rx, RX_PIN, b->actual,
+        USEC_Q16_TO_CYCLES(b->usec_per_bit_q16));
+
+    uint32_t s = cycle_cnt_read();
+    for(unsigned i = 0; i < N; i++)
+        uart_put8(i);
+    uart_flush_tx();
+    // the last byte's stop bit.
+    delay_us(b->two_bytes_usec);
+    uint32_t elapsed = cycle_cnt_read() - s;
+
+    sw_uart_rx_stop(&rx);
+    mu_set_baud(&mu_115200);
+
+    unsigned nerr = 0;
+    for(unsigned i = 0; i < N; i++)
+        if(sw_uart_rx_get8_nonblk(&rx) != i)
+            nerr++;
+
+    // cpu use is busy / elapsed: raw cycles, since that's a divide.
+    sw_uart_rx_stats_t st = sw_uart_rx_stats(&rx);
+    output("baud=%d (actual %d): %d/%d wrong, %d framing, %d glitch, "
+        "busy %d of %d cycles\n", b->baud, b->actual, nerr, N,
+        st.nframe_err, st.nglitch, (uint32_t)st.busy_cyc, elapsed);
+    return nerr;
+}
+
+void notmain(void) {
+    caches_enable();
+    irq_dispatch_init();
+    enable_interrupts();
+
+    static const mu_baud_t bauds[] = {
+        MU_BAUD(115200), MU_BAUD(230400), MU_BAUD(460800),
+        MU_BAUD(921600), MU_BAUD(1000000), MU_BAUD(1562500),
+        MU_BAUD(1953125), MU_BAUD(2604166), MU_BAUD(3906250),
+    };
+    unsigned max = 0;
+    for(unsigned i = 0; i < sizeof bauds / sizeof bauds[0]; i++) {
+        if(run(&bauds[i]))
+            break;
+        max = bauds[i].baud;
+    }
+    output("max error-free baud: %d\n", max);
+
+    // back-to-back bytes keep the handler busy ~9.5 of every 10 bit
+    // times, so expect busy to be ~95% of elapsed.  the cost is per
+    // byte: at lower traffic scale the cycles/byte by the byte rate.
+    run(&bauds[1]);
+    output("at 230400: %d cycles/byte of handler time\n",
+        (uint32_t)sw_uart_rx_stats(&rx).busy_cyc / N);
+    output("SUCCESS\n");
+}
@@ -0,0 +1,50 @@
+// interrupt-driven uart (<uart-int.h>): echo back everything we
+// receive while the main loop spends most of its time "busy"
+// (delay_ms) and only occasionally drains the RX queue.  with the
+// polled staff <uart_get8> anything more than 8 bytes per busy
+// period would be lost; here it lands in the queue.
+//
+// paste a big chunk of text into the terminal to test.  to run at
+// 230400 set <BAUD> and switch the host side after the
+// "switching baud" message.
+#include "rpi.h"
+#include "irq-dispatch.h"
+#include "uart-int.h"
+
+enum { BAUD = 115200, BUSY_MS = 20, RUN_SEC = 10 };
+
+void notmain(void) {
+    output("switching baud to %d\n", BAUD);
+
+    irq_dispatch_init();
+    uart_int_init(BAUD);
+    rpi_putchar_set(uart_int_putchar);
+    enable_interrupts();
+
+    output("echoing for %d seconds: paste text now\n", RUN_SEC);
+
+    uint32_t s = timer_get_usec(), nbusy = 0;
+    while(timer_get_usec() - s < RUN_SEC * 1000 * 1000) {
+        // simulate other work.
+        delay_ms(BUSY_MS);
+        nbusy++;
+
+        uint8_t buf[256];
+        unsigned n;
+        while((n = uart_read(buf, sizeof buf)) != 0) {
+            unsigned w = 0;
+            // tx can't go faster than rx so this won't spin long.
+            while(w < n)
+                w += uart_write(buf + w, n - w);
+        }
+    }
+    output("\n%d busy periods of %dms\n", nbusy, BUSY_MS);
+    uart_int_stats_print();
+
+    let st = uart_int_stats();
+    if(st.hw_overrun || st.rx_drop)
+        output("ERROR: lost bytes\n");
+    else
+        output("SUCCESS: no bytes lost\n");
+    uart_int_disable();
+}
@@ -0,0 +1,52 @@
+// cheap nanosecond clock: extrapolate from the cycle counter and
+// periodically resync against the 1MHz system timer.
+#ifndef __CLOCK_NS_H__
+#define __CLOCK_NS_H__
+/*
+ * <timer_get_usec> is a device load wrapped in two dev barriers
+ * (tens of cycles plus bus latency) and only has usec resolution.
+ * <clock_now_ns> is a cp15 cycle counter read, a multiply and a
+ * couple of loads:
+ *
+ *     ns = base_ns + ((cycle_cnt_read() - base_cyc) * mult) >> 24
+ *
+ * where <mult> is ns per cycle in Q24 fixed point, measured between
+ * resyncs against <timer_get_usec64>.
+ *
+ * the cycle counter is 32 bits and wraps every 2^32 cycles (~6s at
+ * 700MHz), so <clock_ns_resync> must run more often than that.
+ * <clock_ns_start> does it from a one-shot timer (<timer-oneshot.h>);
+ * otherwise call <clock_ns_resync> yourself.
+ *
+ * each resync re-measures the rate, so a change in cpu frequency is
+ * absorbed within one resync period.  if you change the clock on
+ * purpose, call <clock_ns_recalibrate> right after.
+ *
+ * the clock is monotonic: a resync never moves it backwards, and it
+ * can be read from interrupt handlers.
+ */
+
+// set up from <cpu_cyc_per_usec> and measure the real rate.  enables the cycle counter.
+void clock_ns_init(void);
+
+// resync every <period_usec> (0 = 1 second) from a one-shot timer.
+// requires <oneshot_init>.
+void clock_ns_start(uint32_t period_usec);
+
+// resync base and rate against the system timer now.
+void clock_ns_resync(void);
+
+// the cpu frequency changed: spin briefly to measure the new rate.
+// also updates <cpu_cyc_per_usec> (<cpu-freq.h>).
+void clock_ns_recalibrate(void);
+
+// current time in ns since boot (same epoch as <timer_get_usec64>).
+uint64_t clock_now_ns(void);
+
+// measured cycles per usec (rounded).
+uint32_t clock_ns_cyc_per_usec(void);
+
+// resyncs so far and the largest correction (ns) any made.
+void clock_ns_stats(void);
+
+#endif
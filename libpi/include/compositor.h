@@ -0,0 +1,108 @@
+// dirty-rectangle compositor: a stack of layers over a background,
+// composited into an offscreen back surface and copied to the front
+// (visible) one -- but only where something changed.
+#ifndef __COMPOSITOR_H__
+#define __COMPOSITOR_H__
+/*
+ * redrawing a whole 1920x1080x32 frame is ~8MB of writes; a dashboard
+ * where only a plot and a few numbers change touches a few percent of
+ * that.  so:
+ *   - each layer keeps a short list of dirty rectangles in its own
+ *     coordinates (<layer_damage>: "i redrew this part").  moving,
+ *     showing or hiding a layer damages the screen directly.
+ *   - <comp_frame> moves all of it to screen coordinates, merging
+ *     rectangles that overlap or sit close enough that one copy is
+ *     cheaper than two (the merged box may waste at most ~25%).
+ *   - for each merged rectangle: background, then every visible layer
+ *     bottom to top, into the back surface -- starting at the topmost
+ *     opaque layer that covers the whole rectangle, since nothing
+ *     under it can show.  then that rectangle alone is copied back to
+ *     front, by the cpu or (<comp_dma>) with <dma_blit>.
+ *
+ * layers are same-depth surfaces placed at (x, y).  opaque by
+ * default; <comp_layer_key> makes one pixel value transparent (for
+ * text or sprites), which costs a per-pixel compare.
+ *
+ * stats: pixels composited into back and copied to front, per frame
+ * and in total, against what full-frame redraws would have written.
+ *
+ * usage:
+ *      fb_t *fb = fb_init(1920, 1080, 32);
+ *      // draw into page 1 (off screen), show page 0; never flip.
+ *      static comp_t c;
+ *      comp_init(&c, surface_mk(fb->page[1], ...), surface_mk(fb->page[0], ...), 0);
+ *      static layer_t plot;
+ *      comp_layer_add(&c, &plot, surface_mk(buf, 400, 300, 0, 32), 10, 10);
+ *      while(1) {
+ *          surf_line(&plot.s, ...);
+ *          layer_damage(&plot, (rect_t){ ... });
+ *          comp_frame(&c);
+ *      }
+ */
+#include "surface.h"
+
+#define COMP_MAXDIRTY 32
+#define LAYER_MAXDIRTY 8
+
+typedef struct layer {
+    surface_t s;                // the layer's pixels.
+    int x, y;                   // where its (0,0) goes on screen.
+    unsigned visible_p:1;
+    unsigned key_p:1;           // pixels == <key> are transparent.
+    uint32_t key;
+
+    rect_t dirty[LAYER_MAXDIRTY];   // layer coordinates.
+    unsigned ndirty;
+    struct layer *next;         // the one above.
+} layer_t;
+
+typedef struct {
+    surface_t back, front;
+    uint32_t bg;                // background pixel.
+    unsigned dma_p:1;           // copy back -> front with dma.
+    layer_t *layers;            // bottom first.
+
+    rect_t dirty[COMP_MAXDIRTY];    // screen coordinates.
+    unsigned ndirty;
+
+    // stats: last frame, then totals.
+    uint32_t nframe;
+    uint32_t nrects;
+    uint32_t composited;        // pixels written into back.
+    uint32_t copied;            // pixels written to front.
+    uint32_t usec;
+    uint64_t tot_composited, tot_copied, tot_usec;
+    uint32_t max_copied;
+} comp_t;
+
+// <back> and <front> must be the same size and depth.  the whole
+// screen starts dirty.
+void comp_init(comp_t *c, surface_t back, surface_t front, uint32_t bg);
+
+// copy back -> front with <dma_blit> (calls <dma_init>) or the cpu.
+void comp_dma(comp_t *c, int on);
+
+// put <l> on top, showing <s> at (x, y).
+void comp_layer_add(comp_t *c, layer_t *l, surface_t s, int x, int y);
+void comp_layer_remove(comp_t *c, layer_t *l);
+void comp_layer_move(comp_t *c, layer_t *l, int x, int y);
+void comp_layer_show(comp_t *c, layer_t *l, int on);
+// make pixel value <key> transparent.
+void comp_layer_key(comp_t *c, layer_t *l, uint32_t key);
+
+// <r> (layer coordinates) of <l> changed.
+void layer_damage(layer_t *l, rect_t r);
+static inline void layer_damage_all(layer_t *l) {
+    layer_damage(l, (rect_t){ 0, 0, l->s.w, l->s.h });
+}
+// <r> (screen coordinates) must be redrawn.
+void comp_damage(comp_t *c, rect_t r);
+
+// composite and copy everything damaged since the last frame.
+// returns the number of pixels written to the front surface.
+unsigned comp_frame(comp_t *c);
+
+void comp_stats_print(comp_t *c);
+void comp_stats_reset(comp_t *c);
+
+#endif
@@ -0,0 +1,87 @@
+// cpu cycles per usec, measured at runtime: everything that turns
+// cycles into time (sw-uart bit times, cycle delays, capture stamps)
+// should use <cpu_cyc_per_usec> instead of <CYC_PER_USEC> so it keeps
+// working if the clock is changed (e.g. overclocking through the
+// mailbox).
+#ifndef __CPU_FREQ_H__
+#define __CPU_FREQ_H__
+/*
+ * <cstart> calls <cpu_freq_calibrate> at boot.  after changing the
+ * arm clock call it again (or <clock_ns_recalibrate>, which also
+ * updates this value).
+ *
+ * the conversions below never divide at runtime (no libgcc: see
+ * <udiv.h>): cycles -> time multiplies by reciprocals that
+ * <cpu_freq_set> computes once.
+ *
+ * compile-time fast path: if you know the frequency won't change,
+ * build with -DCPU_CYC_PER_USEC_FIXED=700 and <cpu_cyc_per_usec>
+ * and the reciprocals are constants.  <cpu_freq_calibrate> then
+ * still measures, and panics if the hardware disagrees.
+ */
+
+// how long <cpu_freq_calibrate> measures for: a power of two so
+// the rate is a shift.
+#define CPU_FREQ_CAL_LOG2 8
+#define CPU_FREQ_CAL_USEC (1 << CPU_FREQ_CAL_LOG2)
+
+// the measured value: starts as the nominal <CYC_PER_USEC>.  use
+// <cpu_cyc_per_usec> to read it.
+extern uint32_t cpu_cyc_per_usec_var;
+// set with it: usec per cycle in Q32 (rounded up, so whole usecs
+// convert exactly) and ns per cycle in Q16.
+extern uint32_t cpu_usec_per_cyc_q32_var;
+extern uint32_t cpu_nsec_per_cyc_q16_var;
+
+static inline uint32_t cpu_cyc_per_usec(void) {
+#ifdef CPU_CYC_PER_USEC_FIXED
+    return CPU_CYC_PER_USEC_FIXED;
+#else
+    return cpu_cyc_per_usec_var;
+#endif
+}
+static inline uint32_t cpu_usec_per_cyc_q32(void) {
+#ifdef CPU_CYC_PER_USEC_FIXED
+    return ((1ULL << 32) + CPU_CYC_PER_USEC_FIXED - 1) / CPU_CYC_PER_USEC_FIXED;
+#else
+    return cpu_usec_per_cyc_q32_var;
+#endif
+}
+static inline uint32_t cpu_nsec_per_cyc_q16(void) {
+#ifdef CPU_CYC_PER_USEC_FIXED
+    return ((1000ULL << 16) + CPU_CYC_PER_USEC_FIXED / 2) / CPU_CYC_PER_USEC_FIXED;
+#else
+    return cpu_nsec_per_cyc_q16_var;
+#endif
+}
+
+static inline uint32_t cpu_usec_to_cyc(uint32_t usec) {
+    return usec * cpu_cyc_per_usec();
+}
+static inline uint32_t cpu_cyc_to_usec(uint32_t cyc) {
+    return ((uint64_t)cyc * cpu_usec_per_cyc_q32()) >> 32;
+}
+// cyc per ns is cyc per usec * 2^24/1000 in Q24: the divide is by
+// a constant so it's a multiply.
+static inline uint32_t cpu_nsec_to_cyc(uint32_t nsec) {
+    return ((uint64_t)nsec * ((cpu_cyc_per_usec() << 21) / 125)) >> 24;
+}
+static inline uint32_t cpu_cyc_to_nsec(uint32_t cyc) {
+    return ((uint64_t)cyc * cpu_nsec_per_cyc_q16()) >> 16;
+}
+
+// the old names.
+#define usec_to_cycles(usec) cpu_usec_to_cyc(usec)
+#define nanosec_to_cycles(ns) cpu_nsec_to_cyc(ns)
+#define cycles_to_nanosec(c) cpu_cyc_to_nsec(c)
+
+// measure against the system timer (~CPU_FREQ_CAL_USEC usec with
+// interrupts off), store and return the rounded cycles per usec.
+// enables the cycle counter.  if the counter doesn't move (qemu)
+// the value is left alone.
+uint32_t cpu_freq_calibrate(void);
+
+// publish a value measured elsewhere (<clock-ns.c>).
+void cpu_freq_set(uint32_t cyc_per_usec);
+
+#endif
@@ -3,6 +3,8 @@
 #define __CYCLE_UTIL_H__
 #include "rpi.h"
 #include "cycle-count.h"
+#include "gpio-fast.h"
+#include "cpu-freq.h"
 
 // XXX: should we even give these?
 
@@ -17,38 +19,28 @@ static inline unsigned delay_ncycles(unsigned start, unsigned n) {
     return c;
 }
 
+// delay <usec> since <start> on the cycle counter: finer grained
+// than <delay_us> and uses the measured clock rate.
+static inline unsigned delay_usec_cyc(unsigned start, unsigned usec) {
+    return delay_ncycles(start, cpu_usec_to_cyc(usec));
+}
+
 // write value <v> to GPIO <pin>: return when <ncycles> have passed since
 // time <start>
 //  
-// can make a big difference to make an inlined version of GPIO_WRITE_RAW
-// after you do: if you look at the generated assembly, there's some
-// room for tricks.  also, remove the pin check.
+// uses the inlined <gpio_fast_write>: with a constant pin this is
+// a single store, which makes a big difference for bit-banging.
 static inline unsigned
 write_cyc_until(unsigned pin, unsigned v, unsigned start, unsigned ncycles) {
-    // GPIO_WRITE_RAW(pin,v);
-    gpio_write(pin,v);
+    gpio_fast_write(pin,v);
     return delay_ncycles(start,ncycles);
 }   
 
-// We don't seem to need this, so removing for the moment.  can
-// drop in and experiment.
-//
-// we can't do direct loads and stores when faking things out, 
-// so redefine it when running on Unix
-// #ifdef RPI_UNIX
-#if 0
-#   define GPIO_READ_RAW gpio_read
-#else
-    // trying to eek out what we can in terms of speed so that we
-    // do not get 
-    static inline unsigned GPIO_READ_RAW(unsigned pin) {
-        unsigned GPIO_BASE  = 0x20200000UL;
-    
-        volatile unsigned *gpio_lev0  = (void*)(GPIO_BASE + 0x34);
-        unsigned off = (pin%32);
-        return (*gpio_lev0 >> off) & 1;
-    }
-#endif
+// inlined read: a single load of GPLEV0/1 when <pin> is a constant.
+// see <gpio-fast.h>
+static inline unsigned GPIO_READ_RAW(unsigned pin) {
+    return gpio_fast_read(pin);
+}
 
 // wait until <pin>=<v> or until we spin for <ncycles>
 static inline int 
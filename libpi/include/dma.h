@@ -0,0 +1,197 @@
+// bcm2835 dma controller (ch 4, p38--p62): control-block chains,
+// channel allocation, completion interrupts and the cache maintenance
+// around them, plus blocking memcpy / memset / 2d blit built on top.
+#ifndef __DMA_H__
+#define __DMA_H__
+/*
+ * the engine walks a linked list of 32-byte aligned control blocks
+ * (<dma_cb_t>): each says what to move (TI flags), from/to where (bus
+ * addresses, see <dma_bus_addr>), how much, and the bus address of
+ * the next block (0 = done).
+ *
+ * channels:
+ *   - 0..6 are full channels, 7..14 "lite": half the bandwidth and a
+ *     64k max length per control block.  (15 is elsewhere and unused.)
+ *   - the firmware uses some of them: we only hand out channels in
+ *     DMA_CHAN_MASK (what the firmware reports as free on a pi zero/1).
+ *
+ * 2d: the hardware's 2d mode (TDMODE) is full-channel only and its row
+ * count is easy to get off by one (and emulators differ), so
+ * <dma_blit> chains one control block per row instead: any channel,
+ * and the 32-byte block fetch is noise next to a framebuffer row.
+ *
+ * caches: the dma engine doesn't see the arm's L1 dcache.  before a
+ * transfer the source must be cleaned (dirty lines written back) and
+ * the destination cleaned+invalidated; the cb chain itself is cleaned
+ * by <dma_start>.  the blocking helpers do all of this; with the
+ * low-level api call <dma_cache_clean> / <dma_cache_inv> yourself.
+ * the default ops are the arm1176 range operations and do nothing if
+ * the dcache is off (the default: <caches_enable> only turns on the
+ * icache); install others with <dma_cache_ops_set>.
+ *
+ * addresses: the arm sees ram at 0 and peripherals at 0x20000000;
+ * the dma engine uses vc bus addresses: ram through the L2-coherent
+ * alias 0x40000000, peripherals at 0x7e000000.
+ *
+ * works under qemu (-M raspi0 / raspi1ap), which models this block:
+ * see labs/useful-examples/dma.
+ *
+ * usage (blocking):
+ *      dma_init();
+ *      dma_memcpy(dst, src, n);
+ *
+ * usage (async):
+ *      irq_dispatch_init();
+ *      int ch = dma_chan_alloc(DMA_FULL);
+ *      static dma_cb_t cb;
+ *      dma_cb_memcpy(&cb, dst, src, n);
+ *      dma_cache_clean(src, n); dma_cache_inv(dst, n);
+ *      dma_start(ch, &cb, done_fn, arg);  // done_fn from the irq.
+ *      enable_interrupts();
+ */
+
+enum {
+    DMA_NCHAN       = 15,
+    DMA_NFULL       = 7,            // 0..6 full, 7..14 lite.
+    DMA_CHAN_MASK   = 0x7f35,       // 0,2,4,5,8..14
+    DMA_LITE_MAX    = 0xffff,       // max bytes per cb on a lite channel.
+
+    // transfer information (TI) bits: p51.
+    DMA_TI_INTEN        = 1 << 0,
+    DMA_TI_TDMODE       = 1 << 1,
+    DMA_TI_WAIT_RESP    = 1 << 3,
+    DMA_TI_DEST_INC     = 1 << 4,
+    DMA_TI_DEST_WIDTH   = 1 << 5,   // 128-bit writes.
+    DMA_TI_DEST_DREQ    = 1 << 6,
+    DMA_TI_DEST_IGNORE  = 1 << 7,
+    DMA_TI_SRC_INC      = 1 << 8,
+    DMA_TI_SRC_WIDTH    = 1 << 9,   // 128-bit reads.
+    DMA_TI_SRC_DREQ     = 1 << 10,
+    DMA_TI_SRC_IGNORE   = 1 << 11,
+    DMA_TI_NO_WIDE_BURSTS = 1 << 26,
+
+    // peripheral DREQ numbers for DMA_TI_PERMAP: p61.
+    DMA_DREQ_NONE       = 0,
+    DMA_DREQ_SPI_TX     = 6,
+    DMA_DREQ_SPI_RX     = 7,
+    DMA_DREQ_BSC_TX     = 8,   // bsc slave, not the i2c master.
+    DMA_DREQ_BSC_RX     = 9,
+};
+#define DMA_TI_BURST(n)     ((n) << 12)     // words per burst (0 = single).
+#define DMA_TI_PERMAP(p)    ((p) << 16)
+#define DMA_TI_WAITS(n)     ((n) << 21)
+
+typedef struct dma_cb {
+    uint32_t ti;
+    uint32_t src;           // bus address.
+    uint32_t dst;           // bus address.
+    uint32_t len;           // bytes (2d: ylen << 16 | xlen).
+    uint32_t stride;        // 2d only.
+    uint32_t next;          // bus address of next cb, 0 = last.
+    uint32_t pad[2];
+} __attribute__((aligned(32))) dma_cb_t;
+
+// arm address -> vc bus address.
+static inline uint32_t dma_bus_addr(const volatile void *p) {
+    uint32_t a = (uint32_t)p;
+    if(a >= 0x20000000 && a < 0x21000000)
+        return a - 0x20000000 + 0x7e000000;
+    return a | 0x40000000;
+}
+// and back (for walking a chain).
+static inline void *dma_arm_addr(uint32_t bus) {
+    if(bus >= 0x7e000000 && bus < 0x7f000000)
+        return (void *)(bus - 0x7e000000 + 0x20000000);
+    return (void *)(bus & 0x3fffffff);
+}
+
+/*****************************************************************
+ * cache maintenance.
+ */
+typedef struct {
+    // write dirty lines in [p, p+n) back to memory (before dma reads).
+    void (*clean)(const void *p, unsigned n);
+    // write back and drop lines in [p, p+n) (before dma writes, and
+    // before the cpu reads what it wrote).  we never plain invalidate:
+    // a partial line at either end could hold someone else's data.
+    void (*inv)(const void *p, unsigned n);
+} dma_cache_ops_t;
+
+// 0 restores the defaults.
+void dma_cache_ops_set(const dma_cache_ops_t *ops);
+void dma_cache_clean(const void *p, unsigned n);
+void dma_cache_inv(const void *p, unsigned n);
+
+/*****************************************************************
+ * channels and control blocks.
+ */
+enum { DMA_ANY = 0, DMA_FULL = 1 };
+
+// returns a free channel (full only if <flags> = DMA_FULL), reset and
+// enabled, or -1 if none.
+int dma_chan_alloc(unsigned flags);
+void dma_chan_free(unsigned ch);
+
+static inline int dma_chan_is_lite(unsigned ch) {
+    return ch >= DMA_NFULL;
+}
+
+// fill in a single cb.  <next> is 0.
+void dma_cb_memcpy(dma_cb_t *cb, void *dst, const void *src, unsigned n);
+// <pat> is four copies of the 32-bit fill value, 16-byte aligned:
+// the engine reads it over and over.  <dst> and <n> must be
+// multiples of 4.
+void dma_cb_fill(dma_cb_t *cb, void *dst, const uint32_t *pat, unsigned n);
+// <a> continues with <b> (0 = <a> is last).
+static inline void dma_cb_chain(dma_cb_t *a, dma_cb_t *b) {
+    a->next = b ? dma_bus_addr(b) : 0;
+}
+
+typedef void (*dma_done_t)(unsigned ch, void *arg);
+
+// start the chain at <cb>.  if <done> is non-zero the last cb gets
+// INTEN and <done(ch, arg)> runs from the completion interrupt
+// (uses <irq-dispatch.h>).  the chain must end (no cycles) and must
+// stay untouched until it completes.
+void dma_start(unsigned ch, dma_cb_t *cb, dma_done_t done, void *arg);
+
+// 1 if <ch> is still running its chain.
+int dma_busy(unsigned ch);
+
+// spin until <ch> finishes.  returns 0, or -1 if the engine flagged
+// an error (which is then cleared).  panics after a second.
+int dma_wait(unsigned ch);
+
+// stop <ch> and drop the rest of its chain.
+void dma_abort(unsigned ch);
+
+typedef struct {
+    uint32_t nstart;        // chains started.
+    uint32_t nints;         // completion interrupts.
+    uint32_t nerr;          // errors seen by <dma_wait>.
+} dma_stats_t;
+dma_stats_t dma_stats(unsigned ch);
+
+/*****************************************************************
+ * blocking helpers: use one full channel (allocated by <dma_init>)
+ * and a static cb pool.  they handle cache maintenance.
+ */
+
+// max rows per <dma_blit> chain: taller blits run in several.
+#define DMA_CB_POOL 512
+
+// allocate the helpers' channel.  interrupts not needed.
+void dma_init(void);
+
+void dma_memcpy(void *dst, const void *src, unsigned n);
+// byte fill: the unaligned ends are done by the cpu.
+void dma_memset(void *dst, uint8_t c, unsigned n);
+// copy a <w>-byte by <h>-row rectangle between two surfaces with
+// pitches (bytes per row) <dpitch> and <spitch>.
+void dma_blit(void *dst, unsigned dpitch, const void *src, unsigned spitch,
+              unsigned w, unsigned h);
+// fill a <w>-byte by <h>-row rectangle with the 32-bit <v>: <dst>,
+// <dpitch> and <w> must be multiples of 4.
+void dma_fill2d(void *dst, unsigned dpitch, uint32_t v, unsigned w, unsigned h);
+
+#endif
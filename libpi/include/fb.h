@@ -0,0 +1,90 @@
+// double-buffered hdmi framebuffer: two pages stacked in one virtual
+// framebuffer of w x 2h, draw into the back one, flip by moving the
+// virtual offset.
+#ifndef __FB_H__
+#define __FB_H__
+/*
+ * the display scans out the w x h window of the virtual buffer at
+ * the virtual offset.  page 0 is rows 0..h-1, page 1 rows h..2h-1;
+ * <fb_flip> points the window at the back page (one mailbox round
+ * trip) and the pages swap roles.
+ *
+ * tearing: the firmware latches the new offset at the next vsync.
+ *   - fb_flip(fb, FB_VSYNC) also waits for that vsync (same message),
+ *     so when it returns the new back page is off screen and you can
+ *     draw into it.  no tearing, no half-drawn frames, but the frame
+ *     rate is capped at the display's.
+ *   - fb_flip(fb, FB_NO_VSYNC) returns right away: the old front page
+ *     may still be on screen for up to a frame, so drawing into it
+ *     immediately can show.  use it for benchmarks.
+ * if the firmware doesn't know the vsync tag (old firmware, qemu)
+ * <vsync_p> is cleared and FB_VSYNC flips behave like FB_NO_VSYNC.
+ *
+ * stats per flip: frame time (flip to flip: how long rendering a
+ * frame took, including waiting) and flip latency (how long the
+ * mailbox call took).
+ *
+ * usage:
+ *      fb_t *fb = fb_init(640, 480, 32);
+ *      while(1) {
+ *          draw(fb_back(fb), fb->pitch);
+ *          fb_flip(fb, FB_VSYNC);
+ *      }
+ *
+ * to draw with <surface.h>: surface_t s = fb_back_surface(fb);
+ */
+#include "surface.h"
+
+enum { FB_NO_VSYNC = 0, FB_VSYNC = 1 };
+
+typedef struct {
+    unsigned w, h;              // visible size in pixels.
+    unsigned depth;             // bits per pixel: 16, 24 or 32.
+    unsigned bytes_pp;          // bytes per pixel.
+    unsigned pitch;             // bytes per row (may be > w * bytes_pp).
+    unsigned rgb_p:1;           // pixel order: 1 = rgb, 0 = bgr.
+    unsigned vsync_p:1;         // firmware honors the vsync tag.
+
+    uint8_t *base;              // both pages.
+    uint32_t size;              // bytes.
+    uint8_t *page[2];
+    unsigned front;             // page on screen.
+
+    // stats, in usec.
+    uint32_t nflip;
+    uint32_t last_flip;         // <timer_get_usec> at the last flip.
+    uint32_t frame_usec, frame_max_usec;
+    uint64_t frame_tot_usec;
+    uint32_t flip_usec, flip_max_usec;
+    uint64_t flip_tot_usec;
+} fb_t;
+
+// set up the display at <w> x <h>, <depth> bits per pixel, with a
+// <w> x 2<h> virtual buffer.  both pages are cleared and page 0 is
+// shown.  panics if the firmware won't give us what we asked for.
+fb_t *fb_init(unsigned w, unsigned h, unsigned depth);
+
+// the page to draw into / the one on screen.
+static inline void *fb_back(fb_t *fb) {
+    return fb->page[!fb->front];
+}
+static inline void *fb_front(fb_t *fb) {
+    return fb->page[fb->front];
+}
+// the back page as a <surface_t>: redo after every flip.
+static inline surface_t fb_back_surface(fb_t *fb) {
+    return surface_mk(fb_back(fb), fb->w, fb->h, fb->pitch, fb->depth);
+}
+
+// show the back page.
+void fb_flip(fb_t *fb, unsigned vsync);
+
+// show the window starting at row <y> (0..h) of the 2h-row virtual
+// buffer, no vsync: for scrolling by panning (<fbcons.h>).  doesn't
+// change which page is front, so don't mix with <fb_flip>.
+void fb_set_yoffset(fb_t *fb, unsigned y);
+
+void fb_stats_print(fb_t *fb);
+void fb_stats_reset(fb_t *fb);
+
+#endif
@@ -0,0 +1,94 @@
+// framebuffer text console: 8x8 glyphs (<font8x8.h>) on a surface,
+// so printk shows up on hdmi.  install it with <fbcons_install>
+// (through <rpi_putchar_set>), optionally still echoing to the uart.
+#ifndef __FBCONS_H__
+#define __FBCONS_H__
+/*
+ * glyph cache: the first time a character is drawn in a given
+ * foreground/background pair it is expanded to raw pixels in the
+ * surface's format.  after that a character is 8 rows of 4, 6 or 8
+ * word copies (16, 24, 32bpp) -- no per-pixel bit tests.  a few color
+ * pairs are cached; switching to a new one evicts the least recently
+ * used.
+ *
+ * scrolling never re-renders text.  three ways:
+ *   - FBCONS_SCROLL_CPU: move the text up one line with memmove.
+ *   - FBCONS_SCROLL_DMA: the same with <dma_blit>.
+ *   - FBCONS_SCROLL_PAN (<fbcons_init_fb>): text runs down both pages
+ *     of the framebuffer and we slide the display window down a line
+ *     (<fb_set_yoffset>, one mailbox call).  only when the window hits
+ *     the bottom is the screen copied back to the top: one copy per
+ *     screenful of lines instead of per line.  the console then owns
+ *     the framebuffer: don't <fb_flip> it.
+ *
+ * control characters: \n, \r, \t (8 columns), \b.  anything else
+ * outside printable ascii draws as '?'.
+ *
+ * usage:
+ *      fb_t *fb = fb_init(640, 480, 32);
+ *      static fbcons_t c;
+ *      fbcons_init_fb(&c, fb);
+ *      fbcons_install(&c, 1);      // mirror: uart still gets it.
+ *      printk("hello\n");
+ */
+#include "fb.h"
+#include "font8x8.h"
+
+enum { FBCONS_SCROLL_CPU = 0, FBCONS_SCROLL_DMA, FBCONS_SCROLL_PAN };
+
+// cached color pairs.
+#define FBCONS_NCOLORS 4
+
+typedef struct {
+    uint32_t fg, bg;            // raw pixels.
+    unsigned used_p;
+    uint32_t stamp;             // last use, for eviction.
+    uint32_t valid[(FONT8X8_N + 31) / 32];  // glyph expanded?
+    // up to 8 words per row (32bpp).
+    uint32_t px[FONT8X8_N][FONT8X8_H][8];
+} fbcons_colors_t;
+
+typedef struct {
+    surface_t s;                // pan: both pages.
+    fb_t *fb;                   // pan only.
+    unsigned mode;
+    unsigned cols, rows;        // visible text cells.
+    unsigned col, row;          // cursor.
+    unsigned top;               // pan: first visible pixel row of <s>.
+    unsigned rw;                // words per glyph row.
+
+    fbcons_colors_t colors[FBCONS_NCOLORS];
+    fbcons_colors_t *cur;
+    uint32_t stamp;
+
+    // stats.
+    uint32_t nchars;            // glyphs drawn.
+    uint32_t nscroll;           // lines scrolled.
+    uint32_t nexpand;           // glyphs expanded into the cache.
+    uint32_t nrebase;           // pan: screen copies back to the top.
+} fbcons_t;
+
+// console on <s> (base and pitch 4-byte aligned), scrolling with
+// FBCONS_SCROLL_CPU or FBCONS_SCROLL_DMA (calls <dma_init>).  white on
+// black, cleared.
+void fbcons_init(fbcons_t *c, surface_t s, unsigned mode);
+// console on the whole framebuffer, scrolling by panning.
+void fbcons_init_fb(fbcons_t *c, fb_t *fb);
+
+// raw pixel values (<surface_rgb>) for what's drawn from now on.
+void fbcons_color(fbcons_t *c, uint32_t fg, uint32_t bg);
+
+void fbcons_putc(fbcons_t *c, int ch);
+void fbcons_puts(fbcons_t *c, const char *s);
+// blank the screen, cursor to the top left.
+void fbcons_clear(fbcons_t *c);
+
+// route <rpi_putchar> to <c>; <mirror_p>: pass each character on to
+// the old putchar (the uart) too.  uninstall puts the old one back.
+void fbcons_install(fbcons_t *c, int mirror_p);
+void fbcons_uninstall(void);
+int fbcons_putchar(int ch);
+
+void fbcons_stats_print(fbcons_t *c);
+
+#endif
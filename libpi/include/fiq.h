@@ -0,0 +1,86 @@
+// simple framework for routing one interrupt source to FIQ.
+#ifndef __FIQ_H__
+#define __FIQ_H__
+/*
+ * why: FIQ mode has private (banked) copies of r8-r12, sp and lr,
+ * and the FIQ vector is the last entry in the exception table, so a
+ * handler can live directly at the vector with no branch and keep
+ * its state in registers across interrupts with no loads, stores or
+ * saves.  see 1-fast-dev-int/README.md, step 9.
+ *
+ * the bcm2835 can route exactly one source to FIQ (<IRQ_FIQ_control>,
+ * p116).  sources are numbered as in <irq-dispatch.h>: 0..63 GPU,
+ * 64..71 ARM-local.  all other interrupts still go through the IRQ
+ * slot to <irq_dispatch> so you can use both.
+ *
+ * two kinds of handlers:
+ *   1. asm: <fiq_install_asm> copies your code directly into the FIQ
+ *      slot of <fiq_vec>.  it must be position independent (any
+ *      literal pool must lie between <start> and <end>), must end
+ *      with <subs pc, lr, #4> and can freely use r8-r12 (preload them
+ *      with <fiq_regs_set>).  no stack needed.
+ *   2. C: <fiq_install_c> copies a small trampoline into the slot
+ *      that saves r0-r3,r12,lr on the FIQ stack and calls
+ *      <handler(ctx)>.  r8 holds <ctx> and r9 the handler, so
+ *      r10 and r11 are free as persistent state: declare
+ *          FIQ_REG(count, r10);
+ *      at the top level of the file with the handler and <count>
+ *      lives in banked r10 across interrupts.  the file should
+ *      contain only FIQ code, since gcc won't use r10 in it, and
+ *      r11 can only be used if the file does not use a frame pointer.
+ *
+ * to communicate with the rest of the program use a lock-free queue
+ * (<gen_circular_T> in libc/circular-T.h): the FIQ handler is the
+ * only producer, the main program the only consumer.
+ */
+#include "rpi-interrupts.h"
+#include "rpi-inline-asm.h"
+
+// the banked FIQ registers (plus the FIQ stack pointer).
+typedef struct {
+    uint32_t r8, r9, r10, r11, r12;
+    uint32_t sp;
+} fiq_regs_t;
+
+// switch to FIQ mode and load / store the banked registers.
+// FIQs should be disabled.  defined in <fiq-asm.S>
+void fiq_regs_set(const fiq_regs_t *r);
+void fiq_regs_get(fiq_regs_t *r);
+
+// default FIQ stack (for C handlers).
+#define FIQ_STACK_ADDR INT_STACK_ADDR2
+
+// the FIQ handler type for <fiq_install_c>.
+typedef void (*fiq_handler_t)(void *ctx);
+
+// declare a file-scope variable that lives in banked register <reg>.
+#define FIQ_REG(name, reg) register uint32_t name asm(#reg)
+
+// route interrupt source <src> to FIQ (and disable it as an IRQ).
+void fiq_route(unsigned src);
+// stop routing anything to FIQ.
+void fiq_unroute(void);
+
+// copy [start,end) into the FIQ slot of <fiq_vec> and install
+// <fiq_vec> as the vector table.  does not touch r8-r12: set them
+// with <fiq_regs_set> first.
+void fiq_install_asm(const void *start, const void *end);
+
+// install the C trampoline: <h(ctx)> is called on every FIQ.
+// sets r8=ctx, r9=h and the FIQ stack to <FIQ_STACK_ADDR>; r10-r12
+// are zeroed.
+void fiq_install_c(fiq_handler_t h, void *ctx);
+
+// set / clear the F bit (bit 6) in the cpsr.  returns the old cpsr.
+static inline uint32_t fiq_enable(void) {
+    uint32_t cpsr = cpsr_get();
+    cpsr_set(cpsr & ~(1<<6));
+    return cpsr;
+}
+static inline uint32_t fiq_disable(void) {
+    uint32_t cpsr = cpsr_get();
+    cpsr_set(cpsr | (1<<6));
+    return cpsr;
+}
+
+#endif
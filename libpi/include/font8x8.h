@@ -0,0 +1,11 @@
+// 8x8 bitmap font: printable ascii only.
+#ifndef __FONT8X8_H__
+#define __FONT8X8_H__
+
+// glyph <c> is font8x8[c - FONT8X8_FIRST]: 8 rows top to bottom, bit
+// 0 of each row is the leftmost pixel.
+enum { FONT8X8_FIRST = 0x20, FONT8X8_N = 95, FONT8X8_W = 8, FONT8X8_H = 8 };
+
+extern const uint8_t font8x8[FONT8X8_N][8];
+
+#endif
@@ -0,0 +1,90 @@
+// parallel GPIO bus: treat up to 32 pins as one integer so they
+// change together (one store to set, one to clear) instead of
+// <gpio_write> per pin with skew between them.
+#ifndef __GPIO_BUS_H__
+#define __GPIO_BUS_H__
+/*
+ * bit <i> of a bus value is pin <pins[i]>.  pins must be in bank 0
+ * (0..31) so every pin is in GPSET0/GPCLR0/GPLEV0.
+ *
+ * the pin <-> bit translation is precomputed at <gpio_bus_init>:
+ *   - pins consecutive and ascending (e.g. 16..23): a shift.
+ *   - otherwise: four 256-entry tables per direction, one per byte
+ *     of the value, so a translate is 4 loads and 3 ors regardless
+ *     of how scattered the pins are.
+ *
+ * <gpio_bus_write> does set-then-clear, so bits going high change
+ * one store (a few cycles) before bits going low.
+ *
+ * waveforms: <gpio_wave_compile> turns a table of bus values into
+ * raw (set, clr) pairs and <gpio_wave_play> replays them at fixed
+ * cycle intervals with interrupts off.  deadlines are absolute so
+ * lateness doesn't accumulate.
+ */
+#include "gpio-fast.h"
+
+typedef struct {
+    unsigned n;                 // width in bits.
+    uint8_t pins[32];
+    uint32_t mask;              // all bus pins.
+
+    unsigned contig_p:1;        // pins[i] = shift + i
+    unsigned shift;
+
+    // not contiguous: to_gpio[k][b] = gpio bits for byte <k> = <b>
+    // of a value; from_gpio the reverse.
+    uint32_t to_gpio[4][256];
+    uint32_t from_gpio[4][256];
+} gpio_bus_t;
+
+// <pins[i]> is bit <i>.  does not set pin functions.
+void gpio_bus_init(gpio_bus_t *b, const unsigned *pins, unsigned n);
+
+// make every pin an output / input.
+void gpio_bus_output(const gpio_bus_t *b);
+void gpio_bus_input(const gpio_bus_t *b);
+
+// bus value -> GPSET0/GPCLR0 bits and GPLEV0 -> bus value.
+static inline uint32_t gpio_bus_to_gpio(const gpio_bus_t *b, uint32_t v) {
+    if(b->contig_p)
+        return (v << b->shift) & b->mask;
+    return b->to_gpio[0][v & 0xff]
+         | b->to_gpio[1][(v >> 8) & 0xff]
+         | b->to_gpio[2][(v >> 16) & 0xff]
+         | b->to_gpio[3][v >> 24];
+}
+static inline uint32_t gpio_bus_from_gpio(const gpio_bus_t *b, uint32_t g) {
+    if(b->contig_p)
+        return (g & b->mask) >> b->shift;
+    return b->from_gpio[0][g & 0xff]
+         | b->from_gpio[1][(g >> 8) & 0xff]
+         | b->from_gpio[2][(g >> 16) & 0xff]
+         | b->from_gpio[3][g >> 24];
+}
+
+// drive the bus to <v>: two stores.
+static inline void gpio_bus_write(const gpio_bus_t *b, uint32_t v) {
+    gpio_fast_write_mask(b->mask, gpio_bus_to_gpio(b, v));
+}
+// sample all bus pins at once: one load.
+static inline uint32_t gpio_bus_read(const gpio_bus_t *b) {
+    return gpio_bus_from_gpio(b, gpio_fast_read_all());
+}
+
+/*****************************************************************
+ * waveform replay.
+ */
+typedef struct {
+    uint32_t set, clr;
+} gpio_wave_t;
+
+// translate <n> bus values into raw stores.
+void gpio_wave_compile(const gpio_bus_t *b, gpio_wave_t *w,
+                       const uint32_t *vals, unsigned n);
+
+// output <w[i]> at <i * period_cyc> cycles after the start.  returns
+// the worst lateness (cycles after a deadline that its store
+// started).  interrupts are off while playing.
+uint32_t gpio_wave_play(const gpio_wave_t *w, unsigned n, uint32_t period_cyc);
+
+#endif
@@ -0,0 +1,148 @@
+// inline GPIO fast path: when <pin> is a compile-time constant the
+// register address and bit mask fold away and each call is a single
+// load or store.
+#ifndef __GPIO_FAST_H__
+#define __GPIO_FAST_H__
+/*
+ * <gpio_write> and friends in <gpio.h> are out-of-line calls that
+ * check the pin and then call PUT32/GET32 (more calls).  lab 1
+ * (1-fast-dev-int) showed inlining them is one of the biggest wins.
+ * with a constant pin:
+ *      gpio_fast_on(27);
+ * is one str of 1<<27 to GPSET0.
+ *
+ * rules:
+ *   - no dev_barrier: put one before the first and after the last
+ *     GPIO access in a sequence if you are switching devices.
+ *   - no pin checks at runtime by default.  constant pins >= 54 are
+ *     a compile-time error.  compile with -DGPIO_FAST_CHECK (or
+ *     define it before including) to also check non-constant pins
+ *     and that written pins are outputs.
+ *   - the pin should be configured (<gpio_set_output> etc) with the
+ *     regular routines: that isn't on the fast path.
+ */
+#include "rpi.h"
+#include "gpio.h"
+
+// bcm2835 p90--p99
+enum {
+    GPIO_BASE   = 0x20200000,
+    GPIO_FSEL0  = GPIO_BASE + 0x00,
+    GPIO_SET0   = GPIO_BASE + 0x1c,
+    GPIO_CLR0   = GPIO_BASE + 0x28,
+    GPIO_LEV0   = GPIO_BASE + 0x34,
+    GPIO_EDS0   = GPIO_BASE + 0x40,
+    GPIO_NPINS  = 54,
+};
+
+#define GPIO_FAST_INLINE static inline __attribute__((always_inline))
+
+#ifdef RPI_UNIX
+// fake-pi testing: can't do raw loads and stores, so go through the
+// (faked) regular routines.
+GPIO_FAST_INLINE void gpio_fast_on(unsigned pin) { gpio_set_on(pin); }
+GPIO_FAST_INLINE void gpio_fast_off(unsigned pin) { gpio_set_off(pin); }
+GPIO_FAST_INLINE void gpio_fast_write(unsigned pin, unsigned v) { gpio_write(pin, v); }
+GPIO_FAST_INLINE unsigned gpio_fast_read(unsigned pin) { return gpio_read(pin); }
+GPIO_FAST_INLINE unsigned gpio_fast_event_detected(unsigned pin) { return gpio_event_detected(pin); }
+GPIO_FAST_INLINE void gpio_fast_event_clear(unsigned pin) { gpio_event_clear(pin); }
+GPIO_FAST_INLINE void gpio_fast_write_mask(uint32_t m, uint32_t v) {
+    for(unsigned pin = 0; pin < 32; pin++)
+        if(m & (1u << pin))
+            gpio_write(pin, (v >> pin) & 1);
+}
+GPIO_FAST_INLINE void gpio_fast_on_mask(uint32_t m) { gpio_fast_write_mask(m, ~0); }
+GPIO_FAST_INLINE void gpio_fast_off_mask(uint32_t m) { gpio_fast_write_mask(m, 0); }
+GPIO_FAST_INLINE uint32_t gpio_fast_read_all(void) {
+    uint32_t v = 0;
+    for(unsigned pin = 0; pin < 32; pin++)
+        v |= (uint32_t)gpio_read(pin) << pin;
+    return v;
+}
+#else
+
+// <reg0> is the bank 0 register: bank 1 is the next word.
+#define GPIO_FAST_REG(reg0, pin) \
+    ((volatile uint32_t *)((reg0) + ((pin) / 32) * 4))
+#define GPIO_FAST_BIT(pin) (1u << ((pin) % 32))
+
+// only referenced if a constant pin is out of range: the call
+// survives constant folding and the compile fails.
+void gpio_fast_bad_pin(void)
+    __attribute__((error("gpio-fast.h: constant pin >= 54")));
+
+GPIO_FAST_INLINE void gpio_fast_chk(unsigned pin) {
+    if(__builtin_constant_p(pin) && pin >= GPIO_NPINS)
+        gpio_fast_bad_pin();
+#ifdef GPIO_FAST_CHECK
+    if(pin >= GPIO_NPINS)
+        panic("illegal pin=%d\n", pin);
+#endif
+}
+
+// writes to an input pin silently do nothing: catch it in debug.
+GPIO_FAST_INLINE void gpio_fast_out_chk(unsigned pin) {
+    gpio_fast_chk(pin);
+#ifdef GPIO_FAST_CHECK
+    uint32_t fsel = *(volatile uint32_t *)(GPIO_FSEL0 + (pin / 10) * 4);
+    if(((fsel >> ((pin % 10) * 3)) & 0b111) != GPIO_FUNC_OUTPUT)
+        panic("writing pin=%d, which is not an output\n", pin);
+#endif
+}
+
+/******************************************************************
+ * single pins.
+ */
+GPIO_FAST_INLINE void gpio_fast_on(unsigned pin) {
+    gpio_fast_out_chk(pin);
+    *GPIO_FAST_REG(GPIO_SET0, pin) = GPIO_FAST_BIT(pin);
+}
+GPIO_FAST_INLINE void gpio_fast_off(unsigned pin) {
+    gpio_fast_out_chk(pin);
+    *GPIO_FAST_REG(GPIO_CLR0, pin) = GPIO_FAST_BIT(pin);
+}
+// <v> should be 0 or 1 (any non-zero is 1).
+GPIO_FAST_INLINE void gpio_fast_write(unsigned pin, unsigned v) {
+    if(v)
+        gpio_fast_on(pin);
+    else
+        gpio_fast_off(pin);
+}
+GPIO_FAST_INLINE unsigned gpio_fast_read(unsigned pin) {
+    gpio_fast_chk(pin);
+    return (*GPIO_FAST_REG(GPIO_LEV0, pin) >> (pin % 32)) & 1;
+}
+
+GPIO_FAST_INLINE unsigned gpio_fast_event_detected(unsigned pin) {
+    gpio_fast_chk(pin);
+    return (*GPIO_FAST_REG(GPIO_EDS0, pin) >> (pin % 32)) & 1;
+}
+// write 1 to clear.
+GPIO_FAST_INLINE void gpio_fast_event_clear(unsigned pin) {
+    gpio_fast_chk(pin);
+    *GPIO_FAST_REG(GPIO_EDS0, pin) = GPIO_FAST_BIT(pin);
+}
+
+/******************************************************************
+ * multiple pins in bank 0 (pins 0..31) with one store.  bit <n> of
+ * the mask = pin <n>.  pins not in the mask are untouched.
+ */
+GPIO_FAST_INLINE void gpio_fast_on_mask(uint32_t m) {
+    *(volatile uint32_t *)GPIO_SET0 = m;
+}
+GPIO_FAST_INLINE void gpio_fast_off_mask(uint32_t m) {
+    *(volatile uint32_t *)GPIO_CLR0 = m;
+}
+// pins in <m> take their value from <v>: two stores (set then
+// clear), so pins going high change one store before pins going low.
+GPIO_FAST_INLINE void gpio_fast_write_mask(uint32_t m, uint32_t v) {
+    *(volatile uint32_t *)GPIO_SET0 = v & m;
+    *(volatile uint32_t *)GPIO_CLR0 = ~v & m;
+}
+// all of pins 0..31 in one load.
+GPIO_FAST_INLINE uint32_t gpio_fast_read_all(void) {
+    return *(volatile uint32_t *)GPIO_LEV0;
+}
+#endif
+
+#endif
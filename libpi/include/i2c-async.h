@@ -0,0 +1,157 @@
+// queued, interrupt-driven i2c master (BSC1, pins 2/3): submit
+// transactions and keep computing while the bus runs, instead of
+// blocking in <i2c_read> / <i2c_write> for every byte.
+#ifndef __I2C_ASYNC_H__
+#define __I2C_ASYNC_H__
+/*
+ * a transaction (<i2c_xfer_t>) is an optional write of <nwr> bytes
+ * followed by an optional read of <nrd> bytes from one device.  with
+ * both it's a combined register read: the read follows the write with
+ * a repeated start, no stop in between.  (the bsc has no repeated
+ * start bit: we set up the read while the write is still active, which
+ * is what makes it issue one.  so the write must fit in the 16-byte
+ * fifo.)
+ *
+ * transactions are caller-allocated (no kmalloc) and run in submit
+ * order from the bsc's interrupts:
+ *   - TXW (fifo wants data) while writing,
+ *   - RXR (fifo 3/4 full) while reading,
+ *   - DONE at the end, or on a NACK / clock-stretch timeout.
+ * so a 16-byte fifo means about one interrupt per 12 bytes plus one per
+ * transaction.
+ *
+ * completion: <status> leaves I2C_PENDING (poll it, or
+ * <i2c_xfer_wait>), and <done(x, arg)> runs from the interrupt if
+ * set.  errors:
+ *   - I2C_ERR_NACK: the address or a written byte was not acked.
+ *   - I2C_ERR_CLKT: the slave held SCL low too long (hardware CLKT).
+ *   - I2C_ERR_TIMEOUT: not done <timeout_usec> after it started.
+ *     nothing interrupts us for this one: it's checked by
+ *     <i2c_async_poll> (which <i2c_xfer_wait> calls) and on every bsc
+ *     interrupt.  the transaction is aborted and the queue moves on.
+ * a failed transaction doesn't stop the ones queued behind it.
+ *
+ * usage:
+ *      irq_dispatch_init();
+ *      i2c_async_init(I2C_ASYNC_400KHZ);
+ *      enable_interrupts();
+ *      static i2c_xfer_t x;
+ *      i2c_xfer_reg_read(&x, 0x68, 0x3b, buf, 6);     // mpu6050 accel.
+ *      i2c_submit(&x, 0, 0);
+ *      ... compute ...
+ *      if(i2c_xfer_wait(&x) != I2C_OK) ...
+ */
+
+enum {
+    // bsc clock is the 250MHz core clock / divider.
+    I2C_ASYNC_100KHZ    = 2500,
+    I2C_ASYNC_400KHZ    = 626,
+
+    I2C_ASYNC_FIFO      = 16,
+    I2C_ASYNC_MAX       = 0xffff,       // DLEN is 16 bits.
+    I2C_ASYNC_TIMEOUT_USEC = 20*1000,   // default per-transaction.
+};
+
+enum {
+    I2C_OK              = 0,
+    I2C_PENDING         = 1,    // queued or running.
+    I2C_ERR_NACK        = -1,
+    I2C_ERR_CLKT        = -2,
+    I2C_ERR_TIMEOUT     = -3,
+};
+
+struct i2c_xfer;
+typedef void (*i2c_done_t)(struct i2c_xfer *x, void *arg);
+
+typedef struct i2c_xfer {
+    // filled in by the caller (or the helpers below).
+    uint8_t addr;               // 7-bit.
+    const uint8_t *wr;
+    unsigned nwr;
+    uint8_t *rd;
+    unsigned nrd;
+    uint32_t timeout_usec;
+
+    // results.
+    volatile int status;
+    unsigned nwritten, nread;   // bytes through the fifo.
+    uint32_t usec;              // start to finish.
+
+    // internal.
+    uint8_t reg;                // <i2c_xfer_reg_read>'s register.
+    uint8_t reading_p;
+    uint32_t start_usec;
+    i2c_done_t done;
+    void *arg;
+    struct i2c_xfer *next;
+} i2c_xfer_t;
+
+typedef struct {
+    uint32_t nxfer;             // finished, any status.
+    uint32_t nnack, nclkt, ntimeout;
+    uint32_t nints;
+    uint32_t nbytes;
+    uint64_t irq_cyc;           // cycles in the interrupt handler.
+} i2c_async_stats_t;
+
+// pins 2/3 to alt0, bsc1 to clock divider <div>, register the
+// handler (call <irq_dispatch_init> first).  don't mix with the
+// blocking <i2c.h> calls while transactions are queued: it's the
+// same controller.
+void i2c_async_init(unsigned div);
+
+// write <n> bytes of <wr> / read <n> bytes into <rd> / write <wr>
+// then read <rd> with a repeated start.
+static inline void
+i2c_xfer_init(i2c_xfer_t *x, unsigned addr, const uint8_t *wr, unsigned nwr,
+              uint8_t *rd, unsigned nrd) {
+    memset(x, 0, sizeof *x);
+    x->addr = addr;
+    x->wr = wr;
+    x->nwr = nwr;
+    x->rd = rd;
+    x->nrd = nrd;
+    x->timeout_usec = I2C_ASYNC_TIMEOUT_USEC;
+}
+static inline void
+i2c_xfer_write(i2c_xfer_t *x, unsigned addr, const uint8_t *wr, unsigned n) {
+    i2c_xfer_init(x, addr, wr, n, 0, 0);
+}
+static inline void
+i2c_xfer_read(i2c_xfer_t *x, unsigned addr, uint8_t *rd, unsigned n) {
+    i2c_xfer_init(x, addr, 0, 0, rd, n);
+}
+// the common case: read <n> bytes starting at register <reg>.
+static inline void
+i2c_xfer_reg_read(i2c_xfer_t *x, unsigned addr, uint8_t reg, uint8_t *rd, unsigned n) {
+    i2c_xfer_init(x, addr, 0, 1, rd, n);
+    x->reg = reg;
+    x->wr = &x->reg;
+}
+
+// queue <x>.  <done(x, arg)> (may be 0) runs from the interrupt
+// handler once it finishes.  <x> must not be queued already.
+// callable from a <done> callback.
+void i2c_submit(i2c_xfer_t *x, i2c_done_t done, void *arg);
+
+// 1 if <x> finished (any status).
+static inline int i2c_xfer_done_p(i2c_xfer_t *x) {
+    return x->status != I2C_PENDING;
+}
+
+// check the running transaction's timeout.  call this now and then if
+// you only poll <status>.
+void i2c_async_poll(void);
+
+// spin until <x> finishes (interrupts must be on); returns its status.
+int i2c_xfer_wait(i2c_xfer_t *x);
+
+// transactions queued or running.
+unsigned i2c_async_pending(void);
+
+const char *i2c_status_str(int status);
+
+i2c_async_stats_t i2c_async_stats(void);
+void i2c_async_stats_print(const char *msg);
+
+#endif
@@ -0,0 +1,70 @@
+// reusable GPIO interrupt latency + throughput benchmark.
+#ifndef __INT_BENCH_H__
+#define __INT_BENCH_H__
+/*
+ * generalizes <test_cost> in 1-fast-dev-int/code/gpio-int.c so that
+ * different handler implementations can be compared on the same
+ * report.  needs a loopback jumper between <out_pin> and <in_pin>.
+ *
+ * latency: for <ntrials> rising and falling edges, measure the
+ * cycles from writing <out_pin> until the handler has bumped
+ * <int_bench_nedges>.  reports min / median / p99 / max and a cycle
+ * histogram.
+ *
+ * throughput: toggle <out_pin> <ntoggles> times at a decreasing
+ * period (increasing rate) and count how many edges the handler saw.
+ * once the handler (plus its entry/exit) can't keep up, edges merge
+ * in the GPIO event register and are lost.  reports the shortest
+ * period with no lost edges.
+ *
+ * a variant supplies <setup> / <teardown>: <setup> must install its
+ * handler, enable rising and falling edge interrupts on <in_pin> and
+ * enable interrupts (IRQ or FIQ).  the handler must clear the event
+ * and increment <int_bench_nedges> once per edge.
+ */
+
+// every handler increments this once per edge.
+extern volatile uint32_t int_bench_nedges;
+
+typedef struct {
+    const char *name;
+    void (*setup)(unsigned in_pin);
+    void (*teardown)(unsigned in_pin);
+} int_bench_variant_t;
+
+typedef struct {
+    unsigned out_pin, in_pin;
+    unsigned ntrials;           // latency: number of rising+falling pairs.
+    unsigned ntoggles;          // throughput: edges per rate.
+    unsigned verbose_p:1;       // print histogram + per-rate table.
+} int_bench_cfg_t;
+
+// default: 2000 latency pairs, 2000 edges per rate, verbose.
+int_bench_cfg_t int_bench_cfg_mk(unsigned out_pin, unsigned in_pin);
+
+typedef struct {
+    const char *name;
+
+    // latency in cycles.  the mean is <sum> / <nedges>: we don't
+    // divide on the pi (no libgcc).
+    uint32_t min, median, p99, max;
+    uint32_t sum, nedges;
+
+    // smallest toggle period (cycles per edge) with no lost edges
+    // and the cycles <ntoggles> edges actually took at it; 0 if
+    // every rate lost edges.
+    uint32_t lossless_period;
+    uint32_t lossless_elapsed;
+    // lost edges at the fastest rate we tried.
+    uint32_t lost_at_max;
+} int_bench_result_t;
+
+// run latency and throughput for one variant.
+int_bench_result_t int_bench_run(const int_bench_cfg_t *c,
+                                 const int_bench_variant_t *v);
+
+// run all <n> variants and print a summary table.
+void int_bench_compare(const int_bench_cfg_t *c,
+                       const int_bench_variant_t *v, unsigned n);
+
+#endif
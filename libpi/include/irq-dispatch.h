@@ -0,0 +1,89 @@
+// vectored IRQ dispatcher: drivers register a handler per interrupt
+// source rather than everyone polling every device in <int_vector>.
+#ifndef __IRQ_DISPATCH_H__
+#define __IRQ_DISPATCH_H__
+/*
+ * interrupt numbers:
+ *   - 0..63: the GPU peripheral interrupts (bcm2835 p113).  bit <n>
+ *     of <IRQ_pending_1> is irq <n>, bit <n> of <IRQ_pending_2> is
+ *     irq <32+n>.
+ *   - 64..71: the ARM-local interrupts in bits 0..7 of
+ *     <IRQ_basic_pending> (ARM timer, mailbox, doorbells, ...).
+ *
+ * priority: when several sources are pending we use CLZ to pick
+ * the highest numbered one first: ARM-local (64..71) > pending 2
+ * (32..63) > pending 1 (0..31).  all pending sources are handled
+ * before we return.
+ *
+ * handlers run in IRQ mode with interrupts off.  each must clear
+ * its source or it will be called again as soon as we return.
+ *
+ * usage:
+ *      irq_dispatch_init();
+ *      irq_register(IRQ_GPIO0, my_gpio_handler, 0);
+ *      enable_interrupts();
+ */
+#include "rpi-interrupts.h"
+
+enum {
+    // bcm2835 p113: the ones we are likely to use.
+    IRQ_SYS_TIMER1  = 1,
+    IRQ_SYS_TIMER3  = 3,
+    IRQ_DMA0        = 16,   // dma channel <n> is 16+n, n=0..12
+    IRQ_AUX         = 29,   // mini-uart, spi1, spi2
+    IRQ_I2C_SPI_SLV = 43,
+    IRQ_PWA0        = 45,
+    IRQ_PWA1        = 46,
+    IRQ_SMI         = 48,
+    IRQ_GPIO0       = 49,
+    IRQ_GPIO1       = 50,
+    IRQ_GPIO2       = 51,
+    IRQ_GPIO3       = 52,
+    IRQ_I2C         = 53,
+    IRQ_SPI         = 54,
+    IRQ_PCM         = 55,
+    IRQ_UART        = 57,   // pl011
+
+    // ARM-local: bits 0..7 of <IRQ_basic_pending>
+    IRQ_BASIC       = 64,
+    IRQ_ARM_TIMER   = IRQ_BASIC + 0,
+    IRQ_ARM_MAILBOX = IRQ_BASIC + 1,
+    IRQ_ARM_DOORBELL0 = IRQ_BASIC + 2,
+    IRQ_ARM_DOORBELL1 = IRQ_BASIC + 3,
+
+    IRQ_NUM         = 72,
+};
+
+typedef void (*irq_handler_t)(unsigned irq, void *arg);
+
+// disable all sources, clear the handler table and install
+// <irq_dispatch_vec> as the exception vector.  interrupts must
+// be off (the caller enables them).
+void irq_dispatch_init(void);
+
+// register <h> for source <irq> and enable the source.  can be
+// called at any time: we disable interrupts while updating the
+// table.  replaces any previous handler.
+void irq_register(unsigned irq, irq_handler_t h, void *arg);
+
+// disable source <irq> and remove its handler.
+void irq_unregister(unsigned irq);
+
+// number of times <irq>'s handler has run.
+unsigned irq_count(unsigned irq);
+
+// number of interrupts with no handler.
+unsigned irq_spurious(void);
+
+// print the non-zero counters.
+void irq_stats(void);
+
+// enable/disable a source at the interrupt controller without
+// touching the handler table.
+void irq_enable(unsigned irq);
+void irq_disable(unsigned irq);
+
+// called from <irq_dispatch_asm>: <pc> is the interrupted pc.
+void irq_dispatch(uint32_t pc);
+
+#endif
@@ -0,0 +1,78 @@
+// GPIO logic analyzer: sample a mask of pins (GPIO 0..31) in a
+// tight loop and record (cycle stamp, level) on every change.
+#ifndef __LA_CAPTURE_H__
+#define __LA_CAPTURE_H__
+/*
+ * the loop is one GPLEV0 load, an and and a compare per sample,
+ * unrolled 4x; the cycle counter is only read when something
+ * changes (so a stamp is late by at most one sample period) and
+ * for the timeout check once per 4 samples.  interrupts are off for
+ * the whole capture.
+ *
+ * <buf> is a ring (<n> a power of two) so changes before the trigger
+ * are kept too: we record from the start, and stop <npost> samples
+ * after the trigger, or after <timeout_cyc> cycles.  the result
+ * is the last <min(n, total)> samples.
+ *
+ * memory: each change is 8 bytes, so a 1MB buffer holds 128k edges:
+ * e.g. ~11s of 115200 baud uart traffic on one pin.  the stream
+ * (<la_stream>) is typically 3-4 bytes per edge.
+ *
+ * to use: capture, then <la_stream> and on unix
+ *      my-install la-capture.bin > log
+ *      la2vcd log > out.vcd
+ * (see labs/useful-examples/logic-analyzer).
+ */
+#include "la-format.h"
+
+typedef struct {
+    uint32_t cyc;       // cycle counter when the change was seen.
+    uint32_t lev;       // GPLEV0 & mask.
+} la_sample_t;
+
+typedef struct {
+    uint32_t mask;                  // pins to sample.
+
+    // trigger on the first sample with (lev & trig_mask) == trig_val.
+    // trig_mask = 0: trigger immediately.
+    uint32_t trig_mask, trig_val;
+
+    // samples to take after the trigger: 0 (or too big) = <n>-1.
+    unsigned npost;
+    // stop this many cycles after the trigger (or the start, if it
+    // never triggers).  must be < 2^31.
+    uint32_t timeout_cyc;
+
+    la_sample_t *buf;
+    unsigned n;                     // power of two.
+} la_cfg_t;
+
+typedef struct {
+    unsigned total;         // changes seen (including the first sample).
+    unsigned first;         // logical index of the oldest sample kept.
+    unsigned nkept;         // min(total, n)
+    unsigned trigger;       // logical index of the trigger sample.
+    unsigned triggered_p:1,
+             timed_out_p:1;
+
+    uint32_t elapsed_cyc;   // first sample to end of capture.
+    uint32_t nloop;         // unrolled iterations (4 samples each).
+} la_capture_t;
+
+// run one capture.  interrupts are disabled while it runs.
+la_capture_t la_capture(const la_cfg_t *c);
+
+// the <i>th kept sample, 0 = oldest.
+static inline la_sample_t *la_sample(const la_cfg_t *c, const la_capture_t *cap, unsigned i) {
+    return &c->buf[(cap->first + i) & (c->n - 1)];
+}
+
+// send the capture as <LA:> lines (<la-format.h>) via <rpi_putchar>.
+void la_stream(const la_cfg_t *c, const la_capture_t *cap);
+
+// print a summary: edges, duration, and samples taken and cycles
+// elapsed (their ratio is the sample period, if there weren't many
+// changes).
+void la_report(const la_cfg_t *c, const la_capture_t *cap);
+
+#endif
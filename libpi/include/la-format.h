@@ -0,0 +1,92 @@
+// logic-analyzer capture formats shared by the pi (<la-capture.h>)
+// and the unix tools that read captures.  only needs <stdint.h>
+// types: no pi or libc calls, so unix code can include it directly.
+#ifndef __LA_FORMAT_H__
+#define __LA_FORMAT_H__
+
+/*
+ * 1. the stream the pi sends over the uart.  so it can share the
+ *    uart with printk output (and go through my-install), the bytes
+ *    are sent as hex in lines:
+ *          LA:<up to LA_LINE_BYTES bytes in hex>\n
+ *    the bytes (all integers little-endian):
+ *          la_stream_hdr_t
+ *          <nsamples - 1> records, each:
+ *              varint(cycles since previous sample)
+ *              varint(level XOR previous level)
+ *          uint32 fnv-1a hash of every byte above.
+ *    the first sample is in the header.  a change of one pin a few
+ *    usec after the last is usually 3-4 bytes instead of 8.
+ *
+ * 2. a flat file the unix tools produce so decoders can mmap it
+ *    and index it directly:
+ *          la_file_hdr_t
+ *          <nsamples> la_file_rec_t
+ *    cycle stamps are unwrapped to 64 bits.
+ */
+
+#define LA_STREAM_MAGIC 0x3143414c      // "LAC1"
+#define LA_FILE_MAGIC   0x3152414c      // "LAR1"
+#define LA_LINE_PREFIX  "LA:"
+#define LA_LINE_BYTES   32
+
+typedef struct {
+    uint32_t magic;         // LA_STREAM_MAGIC
+    uint32_t mask;          // pins sampled (bit n = GPIO n)
+    uint32_t cyc_per_usec;  // to convert cycle stamps to time.
+    uint32_t nsamples;      // including the first.
+    uint32_t trigger;       // index of the trigger sample, ~0 if none.
+    uint32_t cyc0;          // first sample: cycle stamp
+    uint32_t lev0;          //   and level.
+} la_stream_hdr_t;
+
+typedef struct {
+    uint32_t magic;         // LA_FILE_MAGIC
+    uint32_t mask;
+    uint32_t cyc_per_usec;
+    uint32_t trigger;
+    uint64_t nsamples;
+} la_file_hdr_t;
+
+typedef struct {
+    uint64_t cyc;           // cycles since the first sample.
+    uint32_t lev;
+    uint32_t _pad;
+} la_file_rec_t;
+
+// LEB128: 7 bits per byte, high bit set = more.  returns the
+// number of bytes written (at most 5).
+static inline unsigned la_varint_put(uint8_t *p, uint32_t v) {
+    unsigned n = 0;
+    while(v >= 0x80) {
+        p[n++] = (v & 0x7f) | 0x80;
+        v >>= 7;
+    }
+    p[n++] = v;
+    return n;
+}
+
+// decode one varint from [*p, end): returns 0 if truncated.
+static inline int la_varint_get(const uint8_t **p, const uint8_t *end, uint32_t *v) {
+    uint32_t x = 0;
+    for(unsigned shift = 0; *p < end && shift < 35; shift += 7) {
+        uint8_t b = *(*p)++;
+        x |= (uint32_t)(b & 0x7f) << shift;
+        if(!(b & 0x80)) {
+            *v = x;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// fnv-1a over bytes.
+#define LA_HASH_INIT 2166136261u
+static inline uint32_t la_hash(uint32_t h, const void *data, unsigned n) {
+    const uint8_t *p = data;
+    for(unsigned i = 0; i < n; i++)
+        h = (h ^ p[i]) * 16777619u;
+    return h;
+}
+
+#endif
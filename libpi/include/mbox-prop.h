@@ -0,0 +1,197 @@
+// mailbox property messages without hand-counted offsets: append
+// typed tags to a builder, send them all in one round trip, then read
+// each tag's result (and whether the firmware handled it) through the
+// handle its append returned.
+#ifndef __MBOX_PROP_H__
+#define __MBOX_PROP_H__
+/*
+ * every <mbox_send> is a full round trip to the gpu firmware (tens
+ * to hundreds of usec), so batch: one message with ten tags costs
+ * about the same as one with a single tag.
+ *
+ * tags are processed in order, so e.g. "set virtual offset" then
+ * "wait for vsync" does what it says.
+ *
+ * per-tag status: the firmware sets bit 31 of a tag's
+ * request/response word when it handled the tag; unknown tags are
+ * left alone.  <mbox_prop_ok> checks that.
+ *
+ * usage:
+ *      static mbox_prop_t m;      // 4KB: not on the stack.
+ *      mbox_prop_init(&m);
+ *      int t = mbox_prop_get_temp(&m);
+ *      int c = mbox_prop_get_clock(&m, MBOX_CLK_ARM);
+ *      if(mbox_prop_send(&m) < 0) ...
+ *      if(mbox_prop_ok(&m, t))
+ *          output("temp=%dmC\n", mbox_prop_u32(&m, t, 1));
+ */
+#include "mbox.h"
+
+// message size in words (4KB) and max tags per message.
+#define MBOX_PROP_WORDS 1024
+#define MBOX_PROP_MAXTAGS 64
+
+// property tags: firmware wiki "Mailbox property interface".
+enum {
+    MBOX_TAG_GET_FW_REV         = 0x00000001,
+    MBOX_TAG_GET_BOARD_MODEL    = 0x00010001,
+    MBOX_TAG_GET_BOARD_REV      = 0x00010002,
+    MBOX_TAG_GET_BOARD_SERIAL   = 0x00010004,
+    MBOX_TAG_GET_ARM_MEMORY     = 0x00010005,
+    MBOX_TAG_GET_VC_MEMORY      = 0x00010006,
+    MBOX_TAG_GET_CLOCK_RATE     = 0x00030002,
+    MBOX_TAG_GET_VOLTAGE        = 0x00030003,
+    MBOX_TAG_GET_MAX_CLOCK_RATE = 0x00030004,
+    MBOX_TAG_GET_TEMP           = 0x00030006,
+    MBOX_TAG_GET_MAX_TEMP       = 0x0003000a,
+    MBOX_TAG_SET_CLOCK_RATE     = 0x00038002,
+
+    MBOX_TAG_ALLOC_FB           = 0x00040001,
+    MBOX_TAG_BLANK_SCREEN       = 0x00040002,
+    MBOX_TAG_GET_PHYS_WH        = 0x00040003,
+    MBOX_TAG_GET_PITCH          = 0x00040008,
+    MBOX_TAG_SET_PHYS_WH        = 0x00048003,
+    MBOX_TAG_SET_VIRT_WH        = 0x00048004,
+    MBOX_TAG_SET_DEPTH          = 0x00048005,
+    MBOX_TAG_SET_PIXEL_ORDER    = 0x00048006,
+    MBOX_TAG_SET_VIRT_OFFSET    = 0x00048009,
+    MBOX_TAG_SET_VSYNC          = 0x0004800e,
+
+    // bit 31 of a tag's request/response word.
+    MBOX_TAG_RESPONSE           = 1u << 31,
+};
+
+// clock ids for the clock tags.
+enum {
+    MBOX_CLK_EMMC = 1, MBOX_CLK_UART, MBOX_CLK_ARM, MBOX_CLK_CORE,
+    MBOX_CLK_V3D, MBOX_CLK_H264, MBOX_CLK_ISP, MBOX_CLK_SDRAM,
+    MBOX_CLK_PIXEL, MBOX_CLK_PWM,
+};
+
+typedef struct {
+    uint32_t msg[MBOX_PROP_WORDS] __attribute__((aligned(16)));
+    unsigned n;                         // words used (no end tag).
+    unsigned ntags;
+    uint16_t off[MBOX_PROP_MAXTAGS];    // word index of each tag's id.
+    uint32_t status;                    // msg[1] after the send.
+} mbox_prop_t;
+
+// start an empty message.
+void mbox_prop_init(mbox_prop_t *m);
+
+// append tag <id> with <nreq> request words from <req> and room for
+// <nresp> response words.  returns the tag's handle.
+int mbox_prop_tag(mbox_prop_t *m, uint32_t id, const uint32_t *req,
+                  unsigned nreq, unsigned nresp);
+
+// send everything in one round trip.  returns -1 if the firmware
+// rejected the message, else the number of tags it did not handle
+// (0 = all good).
+int mbox_prop_send(mbox_prop_t *m);
+
+// after the send: did the firmware handle tag <h>?
+int mbox_prop_ok(mbox_prop_t *m, int h);
+// tag <h>'s value buffer and response length in bytes.
+uint32_t *mbox_prop_val(mbox_prop_t *m, int h);
+unsigned mbox_prop_len(mbox_prop_t *m, int h);
+// word <i> of tag <h>'s response.
+static inline uint32_t mbox_prop_u32(mbox_prop_t *m, int h, unsigned i) {
+    return mbox_prop_val(m, h)[i];
+}
+// panic naming every tag the firmware did not handle.
+void mbox_prop_check(mbox_prop_t *m, const char *msg);
+
+/*****************************************************************
+ * typed tags.  the result layout is noted for each: read it with
+ * <mbox_prop_u32>.
+ */
+#define MBOX_PROP_ARGS(...) \
+    (const uint32_t[]){ __VA_ARGS__ }, sizeof((uint32_t[]){ __VA_ARGS__ }) / 4
+
+// -> [0] revision.
+static inline int mbox_prop_get_fw_rev(mbox_prop_t *m) {
+    return mbox_prop_tag(m, MBOX_TAG_GET_FW_REV, 0, 0, 1);
+}
+// -> [0] model.
+static inline int mbox_prop_get_board_model(mbox_prop_t *m) {
+    return mbox_prop_tag(m, MBOX_TAG_GET_BOARD_MODEL, 0, 0, 1);
+}
+// -> [0] revision.
+static inline int mbox_prop_get_board_rev(mbox_prop_t *m) {
+    return mbox_prop_tag(m, MBOX_TAG_GET_BOARD_REV, 0, 0, 1);
+}
+// -> [0] low, [1] high 32 bits.
+static inline int mbox_prop_get_board_serial(mbox_prop_t *m) {
+    return mbox_prop_tag(m, MBOX_TAG_GET_BOARD_SERIAL, 0, 0, 2);
+}
+// -> [0] base, [1] size in bytes.
+static inline int mbox_prop_get_arm_memory(mbox_prop_t *m) {
+    return mbox_prop_tag(m, MBOX_TAG_GET_ARM_MEMORY, 0, 0, 2);
+}
+static inline int mbox_prop_get_vc_memory(mbox_prop_t *m) {
+    return mbox_prop_tag(m, MBOX_TAG_GET_VC_MEMORY, 0, 0, 2);
+}
+// -> [0] clock id, [1] rate in Hz.
+static inline int mbox_prop_get_clock(mbox_prop_t *m, uint32_t clk) {
+    return mbox_prop_tag(m, MBOX_TAG_GET_CLOCK_RATE, MBOX_PROP_ARGS(clk), 2);
+}
+static inline int mbox_prop_get_max_clock(mbox_prop_t *m, uint32_t clk) {
+    return mbox_prop_tag(m, MBOX_TAG_GET_MAX_CLOCK_RATE, MBOX_PROP_ARGS(clk), 2);
+}
+// -> [0] clock id, [1] rate actually set.
+static inline int mbox_prop_set_clock(mbox_prop_t *m, uint32_t clk, uint32_t hz) {
+    return mbox_prop_tag(m, MBOX_TAG_SET_CLOCK_RATE, MBOX_PROP_ARGS(clk, hz, 0), 2);
+}
+// <id> 0 = core.  -> [0] id, [1] (voltage - 1.2V) in 0.025V steps.
+static inline int mbox_prop_get_voltage(mbox_prop_t *m, uint32_t id) {
+    return mbox_prop_tag(m, MBOX_TAG_GET_VOLTAGE, MBOX_PROP_ARGS(id), 2);
+}
+// soc temperature.  -> [0] 0, [1] millidegrees C.
+static inline int mbox_prop_get_temp(mbox_prop_t *m) {
+    return mbox_prop_tag(m, MBOX_TAG_GET_TEMP, MBOX_PROP_ARGS(0), 2);
+}
+static inline int mbox_prop_get_max_temp(mbox_prop_t *m) {
+    return mbox_prop_tag(m, MBOX_TAG_GET_MAX_TEMP, MBOX_PROP_ARGS(0), 2);
+}
+
+// framebuffer.  the set tags respond with what was actually set.
+// -> [0] width, [1] height.
+static inline int mbox_prop_get_phys_wh(mbox_prop_t *m) {
+    return mbox_prop_tag(m, MBOX_TAG_GET_PHYS_WH, 0, 0, 2);
+}
+static inline int mbox_prop_set_phys_wh(mbox_prop_t *m, uint32_t w, uint32_t h) {
+    return mbox_prop_tag(m, MBOX_TAG_SET_PHYS_WH, MBOX_PROP_ARGS(w, h), 2);
+}
+static inline int mbox_prop_set_virt_wh(mbox_prop_t *m, uint32_t w, uint32_t h) {
+    return mbox_prop_tag(m, MBOX_TAG_SET_VIRT_WH, MBOX_PROP_ARGS(w, h), 2);
+}
+// -> [0] bits per pixel (0: unsupported).
+static inline int mbox_prop_set_depth(mbox_prop_t *m, uint32_t bpp) {
+    return mbox_prop_tag(m, MBOX_TAG_SET_DEPTH, MBOX_PROP_ARGS(bpp), 1);
+}
+// <rgb> 1 = rgb, 0 = bgr.  -> [0] order.
+static inline int mbox_prop_set_pixel_order(mbox_prop_t *m, uint32_t rgb) {
+    return mbox_prop_tag(m, MBOX_TAG_SET_PIXEL_ORDER, MBOX_PROP_ARGS(rgb), 1);
+}
+// -> [0] x, [1] y.
+static inline int mbox_prop_set_virt_offset(mbox_prop_t *m, uint32_t x, uint32_t y) {
+    return mbox_prop_tag(m, MBOX_TAG_SET_VIRT_OFFSET, MBOX_PROP_ARGS(x, y), 2);
+}
+// -> [0] bus address, [1] size in bytes.
+static inline int mbox_prop_alloc_fb(mbox_prop_t *m, uint32_t align) {
+    return mbox_prop_tag(m, MBOX_TAG_ALLOC_FB, MBOX_PROP_ARGS(align), 2);
+}
+// -> [0] bytes per row.
+static inline int mbox_prop_get_pitch(mbox_prop_t *m) {
+    return mbox_prop_tag(m, MBOX_TAG_GET_PITCH, 0, 0, 1);
+}
+// wait for the next vsync.
+static inline int mbox_prop_wait_vsync(mbox_prop_t *m) {
+    return mbox_prop_tag(m, MBOX_TAG_SET_VSYNC, MBOX_PROP_ARGS(0), 1);
+}
+// <on> 1 = blank.  -> [0] state.
+static inline int mbox_prop_blank_screen(mbox_prop_t *m, uint32_t on) {
+    return mbox_prop_tag(m, MBOX_TAG_BLANK_SCREEN, MBOX_PROP_ARGS(on), 1);
+}
+
+#endif
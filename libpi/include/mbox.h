@@ -0,0 +1,33 @@
+// arm <-> videocore mailbox 0: send a message buffer to the gpu
+// firmware and wait for its reply.
+#ifndef __MBOX_H__
+#define __MBOX_H__
+/*
+ * the property channel (MBOX_CH_PROP) is how we ask the firmware for
+ * a framebuffer, clock rates, temperature, ...: see
+ *   https://github.com/raspberrypi/firmware/wiki/Mailbox-property-interface
+ *
+ * a message is a 16-byte aligned buffer of u32s:
+ *      [0] total size in bytes
+ *      [1] 0 (request); the firmware writes 0x80000000 on success
+ *      tags: id, value buffer size, request/response size, value...
+ *      0 (end tag)
+ * and is updated in place with the response.  <mbox_send> does the
+ * cache maintenance and the arm <-> bus address translation.
+ */
+
+enum {
+    MBOX_CH_FB      = 1,        // old framebuffer interface.
+    MBOX_CH_PROP    = 8,        // property tags, arm -> vc.
+
+    MBOX_REQUEST    = 0,
+    MBOX_SUCCESS    = 0x80000000,
+    MBOX_ERROR      = 0x80000001,
+};
+
+// send <msg> on channel <ch> and spin until the reply comes back.
+// returns msg[1] (MBOX_SUCCESS if the firmware parsed it: individual
+// tags can still fail).  panics if there's no reply in a second.
+uint32_t mbox_send(unsigned ch, volatile uint32_t *msg);
+
+#endif
@@ -0,0 +1,172 @@
+// simple go-style bounded channels for rpi-threads.
+#ifndef __RPI_CHAN_H__
+#define __RPI_CHAN_H__
+/*
+ * each channel is a <gen_circular_T> queue (libc/circular-T.h) plus
+ * a small type-independent header at offset 0 so that <chan_select>
+ * can wait on several channels with different element types.
+ *
+ * usage:
+ *      // make a channel type <u32_chan_t> holding 8 uint32_t's
+ *      // with routines prefixed by <u32ch>
+ *      gen_chan_T(u32ch, u32_chan_t, uint32_t, 8)
+ *
+ *      static u32_chan_t c;
+ *      u32ch_init(&c, "c");
+ *      u32ch_send(&c, 10);
+ *      uint32_t x = u32ch_recv(&c);
+ *
+ * blocking:
+ *   - <send> / <recv> do not spin: if they can't make progress they
+ *     park the current thread at the back of the run queue with
+ *     <rpi_yield> so the other threads (which are the only ones that
+ *     can fill or drain the channel) get to run.
+ *   - if there are no other threads, the only thing that can make
+ *     progress is an interrupt handler: we call <rpi_wait> if
+ *     interrupts are on, and panic with a deadlock otherwise.
+ *
+ * zero-copy: make the element type a pointer, eg:
+ *      gen_chan_T(pkt_ch, pkt_chan_t, struct pkt *, 16)
+ *   a send just moves the pointer; ownership of what it points to
+ *   moves with it.  a common pattern is a pair of channels: one
+ *   carrying full buffers downstream, one returning empty ones.
+ *
+ * restrictions:
+ *   - threads are not pre-emptive so any number of threads can send
+ *     and receive on the same channel.
+ *   - an interrupt handler can use a channel as long as it is the only
+ *     sender (or the only receiver) and it only calls the non-blocking
+ *     <_try_send> / <_try_recv>.
+ *   - as with <gen_circular_T>, a channel of size <N> holds at most
+ *     <N-1> elements.
+ */
+#include "rpi.h"
+#include "rpi-thread.h"
+#include "circular-T.h"
+
+// type independent channel state: must be the first field
+// of every generated channel type.
+typedef struct chan_hdr {
+    const char *name;
+
+    // type-erased non-blocking send and receive so <chan_select>
+    // can work across channel types.  return 1 on success, 0
+    // otherwise.
+    int (*try_send)(struct chan_hdr *h, const void *e);
+    int (*try_recv)(struct chan_hdr *h, void *e);
+
+    // statistics.
+    unsigned nsend, nrecv;
+    // number of times a send or recv had to block.
+    unsigned nblock_send, nblock_recv;
+} chan_hdr_t;
+
+// block the current thread because a channel operation on <h> could
+// not make progress.  increments <*nblocked>.
+void chan_block(chan_hdr_t *h, unsigned *nblocked);
+
+// print channel statistics.
+void chan_stats(chan_hdr_t *h);
+
+/*****************************************************************
+ * select over multiple channels.
+ */
+
+typedef enum { CHAN_SEND = 1, CHAN_RECV = 2 } chan_dir_t;
+
+// one arm of a select:
+//  - <ch>: the channel (pass &c->hdr or use <chan_case_send> and
+//    <chan_case_recv> below).
+//  - <dir>: send or receive.
+//  - <e>: for send, points to the element to send; for receive,
+//    points to where to store the element.
+typedef struct {
+    chan_hdr_t *ch;
+    chan_dir_t dir;
+    void *e;
+} chan_case_t;
+
+#define chan_case_send(_c, _eptr) \
+    ((chan_case_t){ .ch = &(_c)->hdr, .dir = CHAN_SEND, .e = (void*)(_eptr) })
+#define chan_case_recv(_c, _eptr) \
+    ((chan_case_t){ .ch = &(_c)->hdr, .dir = CHAN_RECV, .e = (_eptr) })
+
+// non-blocking: returns the index of the case that fired or -1 if
+// none could.  we rotate the starting case between calls so that
+// one always-ready channel doesn't starve the others.
+int chan_try_select(chan_case_t *cases, unsigned n);
+
+// blocking: returns the index of the case that fired.
+int chan_select(chan_case_t *cases, unsigned n);
+
+/*****************************************************************
+ * generate a channel type.
+ *
+ *  - pfx: prepended to all routines.
+ *  - CH_T: name of the channel type.
+ *  - E_T: element type.
+ *  - N: static size of the underlying circular queue.
+ */
+#define gen_chan_T(pfx, CH_T, E_T, N)                           \
+    gen_circular_T(pfx ## _cq, pfx ## _cq_t, E_T, N)            \
+                                                                \
+    typedef struct {                                            \
+        /* must be first: <chan_select> uses it. */             \
+        chan_hdr_t hdr;                                         \
+        pfx ## _cq_t q;                                         \
+    } CH_T;                                                     \
+                                                                \
+    /* non-blocking send: returns 0 if full. */                 \
+    static inline int pfx ## _try_send(CH_T *c, E_T e) {        \
+        if(!pfx ## _cq_push(&c->q, e))                          \
+            return 0;                                           \
+        c->hdr.nsend++;                                         \
+        return 1;                                               \
+    }                                                           \
+    /* non-blocking recv: returns 0 if empty. */                \
+    static inline int pfx ## _try_recv(CH_T *c, E_T *e) {       \
+        if(!pfx ## _cq_pop_nonblk(&c->q, e))                    \
+            return 0;                                           \
+        c->hdr.nrecv++;                                         \
+        return 1;                                               \
+    }                                                           \
+    /* blocking send. */                                        \
+    static inline void pfx ## _send(CH_T *c, E_T e) {           \
+        while(!pfx ## _try_send(c, e))                          \
+            chan_block(&c->hdr, &c->hdr.nblock_send);           \
+    }                                                           \
+    /* blocking recv. */                                        \
+    static inline E_T pfx ## _recv(CH_T *c) {                   \
+        E_T e;                                                  \
+        while(!pfx ## _try_recv(c, &e))                         \
+            chan_block(&c->hdr, &c->hdr.nblock_recv);           \
+        return e;                                               \
+    }                                                           \
+    static inline int pfx ## _empty(CH_T *c) {                  \
+        return pfx ## _cq_empty(&c->q);                         \
+    }                                                           \
+    static inline int pfx ## _full(CH_T *c) {                   \
+        return pfx ## _cq_full(&c->q);                          \
+    }                                                           \
+                                                                \
+    /* type-erased wrappers used by <chan_select> */            \
+    static int pfx ## _hdr_try_send(chan_hdr_t *h, const void *e) { \
+        return pfx ## _try_send((CH_T *)h, *(E_T *)e);          \
+    }                                                           \
+    static int pfx ## _hdr_try_recv(chan_hdr_t *h, void *e) {   \
+        return pfx ## _try_recv((CH_T *)h, (E_T *)e);           \
+    }                                                           \
+                                                                \
+    /* initialize in place: channels can be big, so we */       \
+    /* don't return them by value. */                           \
+    static inline void pfx ## _init(CH_T *c, const char *name) {\
+        memset(c, 0, sizeof *c);                                \
+        c->q.fence = 0x12345678;                                \
+        c->q.errors_fatal_p = 1;                                \
+        c->hdr.name = name;                                     \
+        c->hdr.try_send = pfx ## _hdr_try_send;                 \
+        c->hdr.try_recv = pfx ## _hdr_try_recv;                 \
+        assert(pfx ## _empty(c));                               \
+    }
+
+#endif
@@ -20,6 +20,10 @@
 #   define INT_STACK_ADDR2      0xA000000  
 #endif
 
+// bytes reserved after the FIQ vector for a handler copied there
+// (see <fiq.h>)
+#define FIQ_MAX_CODE 512
+
 // free MB we can use.
 #define FREE_MB            0x6000000
 
@@ -31,6 +35,7 @@
 .globl fn_name;             \
 fn_name:
 
+// nominal: the measured value is <cpu_cyc_per_usec> in <cpu-freq.h>.
 #define CYC_PER_USEC 700
 #define PI_MHz  (700*1000*1000UL)
 
@@ -43,13 +48,7 @@ fn_name:
 #define UNDEF_MODE      0b11011
 #define SYS_MODE        0b11111
 
-
-// 1.4285714285714286 nanosecond per cycle: we don't have fp so
-// use 142857 and then divide by 100000
-// 
-#define cycles_to_nanosec(c) (((c) * 142857UL) / 100000UL)
-
-// if we overclock, will have to change this stuff.
-#define usec_to_cycles(usec) ((usec) * CYC_PER_USEC)
+// cycles <-> time conversions use the measured clock: see
+// <usec_to_cycles> and friends in <cpu-freq.h>.
 
 #endif
@@ -69,4 +69,12 @@ static inline uint32_t cpsr_int_reset(uint32_t cpsr) {
     else
         return cpsr_int_enable();
 }
+
+// sleep until an interrupt is pending.  on the arm1176 "wait for
+// interrupt" is a cp15 c7 operation, not the v7 wfi instruction.  wakes even
+// if interrupts are disabled in the cpsr.
+static inline void cpu_wait_for_int(void) {
+    asm volatile("mcr p15, 0, %0, c7, c0, 4" :: "r"(0) : "memory");
+}
+
 #endif
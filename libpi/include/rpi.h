@@ -111,6 +111,10 @@ uint32_t timer_get_usec(void) ;
 // no memory barrier.
 uint32_t timer_get_usec_raw(void);
 
+// full 64-bit time in usec: does not wrap (for ~500k years).
+// does a memory barrier.
+uint64_t timer_get_usec64(void);
+
 /****************************************************************************
  * Reboot the pi smoothly.
  */
@@ -273,6 +277,7 @@ int memiszero(const void *_p, unsigned n);
 
 #include "gpio.h"
 #include "rpi-constants.h"
+#include "cpu-freq.h"
 // any extra prototypes you want to add
 #include "your-prototypes.h"
 
@@ -0,0 +1,98 @@
+// simple earliest-deadline-first (EDF) real-time class.
+#ifndef __RT_SCHED_H__
+#define __RT_SCHED_H__
+/*
+ * periodic real-time tasks declare a period and a budget (worst case
+ * execution time).  each period a new job is released with deadline
+ * <release + deadline_usec> (deadline_usec defaults to the period).
+ *
+ * how it runs:
+ *   - the next release time across all tasks is programmed into a
+ *     system-timer compare channel (see <sys-timer.h>).
+ *   - when it fires, the interrupt handler <rt_sched_int> releases
+ *     all jobs that are due and runs the ready jobs in EDF order
+ *     (earliest absolute deadline first) until none are ready, then
+ *     re-arms the timer for the next release.
+ *   - jobs run to completion (non-preemptive EDF) in interrupt
+ *     context with interrupts off: keep them short and don't block.
+ *   - best-effort code (<notmain> or rpi-threads) runs whenever no
+ *     real-time job is ready: since the timer interrupt pre-empts it,
+ *     best-effort threads don't have to yield for the real-time
+ *     tasks to meet their deadlines.
+ *
+ * accounting:
+ *   - a job misses if it completes after its deadline, or if it has
+ *     not even started when the next job of the same task is
+ *     released (we drop the old job: "skipped").
+ *   - a job overruns if it runs longer than its budget.
+ *   - utilization (sum of budget/period) over 1 means the set is
+ *     not schedulable; we warn but admit the task anyway so overload
+ *     can be measured.
+ *
+ * all times are in microseconds (the system-timer resolution).
+ */
+#include "sys-timer.h"
+
+typedef void (*rt_job_t)(void *arg);
+
+typedef struct rt_task {
+    const char *name;
+    rt_job_t fn;
+    void *arg;
+
+    uint32_t period_usec;
+    uint32_t budget_usec;
+    uint32_t deadline_usec;     // relative to release.
+    uint32_t util_ppt;          // budget/period in parts per 1000, rounded up.
+
+    // current job.
+    uint32_t release;           // absolute release time.
+    uint32_t deadline;          // absolute deadline.
+    uint32_t next_release;      // absolute time of next release.
+    unsigned ready:1;           // released and not yet run.
+
+    // statistics.
+    unsigned njobs;             // number of jobs released.
+    unsigned ndone;             // number of jobs that ran.
+    unsigned nmiss;             // finished late or skipped.
+    unsigned nskip;             // dropped before they ran.
+    unsigned noverrun;          // ran longer than budget.
+    uint32_t max_exec;          // longest job execution time.
+    uint32_t max_resp;          // longest release-to-completion time.
+
+    struct rt_task *next;
+} rt_task_t;
+
+// add a periodic task: its first job is released <period_usec>
+// after <rt_sched_start>.  deadline = period.
+rt_task_t *rt_task_add(const char *name, rt_job_t fn, void *arg,
+    uint32_t period_usec, uint32_t budget_usec);
+
+// same, but with an explicit relative deadline <= period.
+rt_task_t *rt_task_add_deadline(const char *name, rt_job_t fn, void *arg,
+    uint32_t period_usec, uint32_t budget_usec, uint32_t deadline_usec);
+
+// start releasing jobs using system-timer compare channel <chan>
+// (SYS_TIMER_CHAN1 or SYS_TIMER_CHAN3).  the caller must have
+// installed an interrupt vector that calls <rt_sched_int> and
+// must enable interrupts.
+void rt_sched_start(unsigned chan);
+
+// stop releasing jobs.
+void rt_sched_stop(void);
+
+// stop and remove all tasks so a new task set can be added.
+void rt_sched_reset(void);
+
+// call from the interrupt handler: returns 1 if the interrupt
+// was ours (and was handled), 0 otherwise.
+int rt_sched_int(void);
+
+// utilization of all tasks in parts per thousand: the sum of the
+// per-task shares computed by <rt_task_add>, so no divide here.
+unsigned rt_sched_util_ppt(void);
+
+// print per-task statistics and the total jobs and misses.
+void rt_sched_report(void);
+
+#endif
@@ -0,0 +1,85 @@
+// asynchronous SPI0 master: queue transfers with <spi_submit> and get
+// a callback when each one finishes, instead of spinning in
+// <spi_n_transfer> for the whole transfer.
+#ifndef __SPI_ASYNC_H__
+#define __SPI_ASYNC_H__
+/*
+ * two engines (pick one at <spi_async_init>):
+ *   - SPI_ASYNC_DMA: two dma channels (<dma.h>) move the bytes: tx
+ *     memory -> FIFO paced by the spi TX DREQ, FIFO -> rx memory paced
+ *     by RX DREQ.  the cpu only runs at the start and end of each
+ *     transfer (one interrupt: rx channel done).
+ *   - SPI_ASYNC_IRQ: the spi's own interrupts (RXR: rx fifo 3/4 full,
+ *     DONE: tx fifo empty) and the cpu copies bytes in the handler.
+ *     no dma needed, but an interrupt every ~12 bytes.
+ *
+ * queue: up to SPI_ASYNC_QSIZE transfers can be pending.  they run in
+ * order, back to back: the next one is started from the previous
+ * one's completion interrupt.  chip select is dropped at the end of
+ * every transfer (so each queued transfer is its own CS frame) and
+ * the clock divider / chip can differ from one transfer to the next.
+ *
+ * buffers: <rx> or <tx> may be 0 (rx: throw away what comes back, tx:
+ * send zeros).  both must stay untouched until the callback runs.
+ * dma mode does the cache maintenance.
+ *
+ * usage:
+ *      irq_dispatch_init();
+ *      spi_async_init(SPI_ASYNC_DMA);
+ *      spi_t s = spi_async_dev(SPI_CE0, 32);
+ *      enable_interrupts();
+ *      spi_submit(s, rx, tx, n, done_fn, arg);   // done_fn from the irq.
+ *      ...
+ *      spi_async_wait();                         // or check the flag.
+ *
+ * spi mode 0 (CPOL=CPHA=0), chip selects active low.
+ */
+#include "spi.h"
+
+// pending transfers (including the one running).
+#define SPI_ASYNC_QSIZE 16
+// max bytes per transfer: the spi's DLEN is 16 bits.
+#define SPI_ASYNC_MAX 0xffff
+
+enum { SPI_ASYNC_DMA = 1, SPI_ASYNC_IRQ = 2 };
+
+// <rx>, <n> and <arg> as passed to <spi_submit>.
+typedef void (*spi_done_t)(uint8_t *rx, unsigned n, void *arg);
+
+typedef struct {
+    uint32_t nsubmit;       // transfers queued.
+    uint32_t ndone;         // transfers finished.
+    uint32_t nfull;         // <spi_submit> calls refused: queue full.
+    uint32_t nints;         // interrupts taken.
+    uint64_t nbytes;        // bytes moved.
+    uint64_t irq_cyc;       // cycles in our interrupt handlers.
+} spi_async_stats_t;
+
+// set the SPI0 pins (7..11) to alt0 and, for SPI_ASYNC_DMA, allocate
+// two dma channels.  needs <irq_dispatch_init>.  can be called
+// again (with nothing pending) to switch engines.
+void spi_async_init(unsigned mode);
+
+// a <spi_t> for <spi_submit> without going through <spi_n_init>:
+// <chip> is SPI_CE0 or SPI_CE1 (or 0 / 1), clock is 250MHz / <div>
+// (<div> even, 2..65534).
+spi_t spi_async_dev(unsigned chip, unsigned div);
+
+// queue a transfer of <n> bytes on <s>'s chip at <s>'s divider.
+// returns 1 if queued, 0 if the queue is full.  <done> (may be 0)
+// runs from the interrupt handler when the transfer completes.
+// callable from a <done> callback.
+int spi_submit(spi_t s, uint8_t *rx, const uint8_t *tx, unsigned n,
+               spi_done_t done, void *arg);
+
+// number of transfers queued or running.
+unsigned spi_async_pending(void);
+
+// spin until the queue is empty (interrupts must be on).  panics if
+// nothing finishes for a second.
+void spi_async_wait(void);
+
+spi_async_stats_t spi_async_stats(void);
+void spi_async_stats_print(const char *msg);
+
+#endif
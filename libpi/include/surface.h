@@ -0,0 +1,181 @@
+// 2d raster primitives on a <surface_t>: a w x h block of 16, 24 or
+// 32 bit pixels with a pitch, backed by the framebuffer or any
+// memory.  spans, lines (bresenham and antialiased), rectangles,
+// circles and clipped blits.
+#ifndef __SURFACE_H__
+#define __SURFACE_H__
+/*
+ * everything is drawn in rows: a horizontal span is the unit of
+ * work, and the long middle of a span is filled with 8-register STM
+ * bursts (<surface-asm.S>: 32 bytes per store instruction) rather
+ * than pixel at a time.  24bpp repeats every 3 words, so it uses
+ * 6-register (two-period) bursts.
+ *
+ * pixels are raw values in the surface's format (<surface_rgb>
+ * makes one): 32bpp is the word as-is, 24bpp the low three bytes in
+ * memory order, 16bpp rgb565.
+ *
+ * clipping: every primitive clips to the surface's clip rectangle
+ * (the whole surface unless <surface_clip> narrows it), so anything
+ * can be drawn anywhere.
+ *
+ * on the host: define RPI_UNIX and compile <surface.c> as-is (the
+ * bursts fall back to C) -- see labs/useful-examples/raster/unix,
+ * which checks every primitive against a pixel-at-a-time reference.
+ *
+ * usage:
+ *      fb_t *fb = fb_init(640, 480, 32);
+ *      surface_t s = fb_back_surface(fb);
+ *      surf_fill_rect(&s, 10, 10, 100, 50, surface_rgb(&s, 255, 0, 0));
+ *      surf_line_aa(&s, 0, 0, 639, 479, surface_rgb(&s, 255, 255, 255));
+ */
+#ifdef RPI_UNIX
+#   include <stdint.h>
+#   include <stdio.h>
+#   include <stdlib.h>
+#   include <string.h>
+#   ifndef panic
+#       define panic(fmt, args...) \
+            do { fprintf(stderr, "PANIC: " fmt, ##args); exit(1); } while(0)
+#   endif
+#else
+#   include "rpi.h"
+#endif
+
+typedef struct {
+    int x, y;
+    int w, h;
+} rect_t;
+
+static inline int rect_empty(rect_t r) {
+    return r.w <= 0 || r.h <= 0;
+}
+static inline unsigned rect_area(rect_t r) {
+    return rect_empty(r) ? 0 : (unsigned)r.w * r.h;
+}
+// intersection (w or h <= 0 if none).
+static inline rect_t rect_and(rect_t a, rect_t b) {
+    int x0 = a.x > b.x ? a.x : b.x, y0 = a.y > b.y ? a.y : b.y;
+    int x1 = a.x + a.w < b.x + b.w ? a.x + a.w : b.x + b.w;
+    int y1 = a.y + a.h < b.y + b.h ? a.y + a.h : b.y + b.h;
+    return (rect_t){ x0, y0, x1 - x0, y1 - y0 };
+}
+// bounding box.
+static inline rect_t rect_or(rect_t a, rect_t b) {
+    if(rect_empty(a))
+        return b;
+    if(rect_empty(b))
+        return a;
+    int x0 = a.x < b.x ? a.x : b.x, y0 = a.y < b.y ? a.y : b.y;
+    int x1 = a.x + a.w > b.x + b.w ? a.x + a.w : b.x + b.w;
+    int y1 = a.y + a.h > b.y + b.h ? a.y + a.h : b.y + b.h;
+    return (rect_t){ x0, y0, x1 - x0, y1 - y0 };
+}
+// is <b> inside <a>?
+static inline int rect_contains(rect_t a, rect_t b) {
+    return b.x >= a.x && b.y >= a.y
+        && b.x + b.w <= a.x + a.w && b.y + b.h <= a.y + a.h;
+}
+
+typedef struct {
+    uint8_t *p;                 // pixel (0,0).
+    unsigned w, h;
+    unsigned pitch;             // bytes per row.
+    unsigned depth;             // bits per pixel: 16, 24, 32.
+    unsigned bytes_pp;
+    // clip: [cx0, cx1) x [cy0, cy1), inside the surface.
+    int cx0, cy0, cx1, cy1;
+} surface_t;
+
+// a surface over <p>.  <pitch> 0 = packed rows.
+surface_t surface_mk(void *p, unsigned w, unsigned h, unsigned pitch,
+                     unsigned depth);
+
+// the <r> sub-rectangle of <s> as its own surface (clipped to <s>).
+surface_t surface_sub(const surface_t *s, rect_t r);
+
+// restrict drawing to <r> (intersected with the surface); and back
+// to the whole surface.
+void surface_clip(surface_t *s, rect_t r);
+void surface_unclip(surface_t *s);
+
+static inline uint8_t *surface_row(const surface_t *s, int y) {
+    return s->p + (unsigned)y * s->pitch;
+}
+
+// 8-bit r, g, b -> a raw pixel.
+static inline uint32_t
+surface_rgb(const surface_t *s, unsigned r, unsigned g, unsigned b) {
+    if(s->depth == 16)
+        return (r >> 3) << 11 | (g >> 2) << 5 | b >> 3;
+    return r << 16 | g << 8 | b;
+}
+
+/*****************************************************************
+ * single pixels (clipped): slow, use for one-offs.
+ */
+static inline int surface_in_clip(const surface_t *s, int x, int y) {
+    return x >= s->cx0 && x < s->cx1 && y >= s->cy0 && y < s->cy1;
+}
+
+// no clipping.
+static inline void surface_put_raw(const surface_t *s, int x, int y, uint32_t c) {
+    uint8_t *p = surface_row(s, y) + x * s->bytes_pp;
+    switch(s->bytes_pp) {
+    case 4: *(uint32_t *)p = c; break;
+    case 2: *(uint16_t *)p = c; break;
+    default: p[0] = c; p[1] = c >> 8; p[2] = c >> 16; break;
+    }
+}
+static inline uint32_t surface_get_raw(const surface_t *s, int x, int y) {
+    const uint8_t *p = surface_row(s, y) + x * s->bytes_pp;
+    switch(s->bytes_pp) {
+    case 4: return *(const uint32_t *)p;
+    case 2: return *(const uint16_t *)p;
+    default: return p[0] | p[1] << 8 | p[2] << 16;
+    }
+}
+
+static inline void surf_pixel(const surface_t *s, int x, int y, uint32_t c) {
+    if(surface_in_clip(s, x, y))
+        surface_put_raw(s, x, y, c);
+}
+
+/*****************************************************************
+ * primitives.  rectangles are x, y, w, h; spans are [x0, x1).
+ */
+void surf_hspan(const surface_t *s, int x0, int x1, int y, uint32_t c);
+void surf_vspan(const surface_t *s, int x, int y0, int y1, uint32_t c);
+
+void surf_fill_rect(const surface_t *s, int x, int y, int w, int h, uint32_t c);
+// one-pixel outline.
+void surf_rect(const surface_t *s, int x, int y, int w, int h, uint32_t c);
+void surf_clear(const surface_t *s, uint32_t c);
+
+// bresenham: both endpoints included.
+void surf_line(const surface_t *s, int x0, int y0, int x1, int y1, uint32_t c);
+// antialiased (wu): blends <c> over what's there by pixel coverage.
+void surf_line_aa(const surface_t *s, int x0, int y0, int x1, int y1, uint32_t c);
+
+// midpoint circle: outline / filled (spans).
+void surf_circle(const surface_t *s, int cx, int cy, int r, uint32_t c);
+void surf_fill_circle(const surface_t *s, int cx, int cy, int r, uint32_t c);
+
+// copy the <w> x <h> rectangle at (sx, sy) in <src> to (dx, dy) in
+// <dst>, clipped to both.  same depth; the two may overlap only if
+// they're the same surface with dy != sy or no overlap at all.
+void surf_blit(const surface_t *dst, int dx, int dy,
+               const surface_t *src, int sx, int sy, int w, int h);
+
+// blend <c> into pixel (x, y) with weight <a> (0..255).  clipped.
+void surf_blend(const surface_t *s, int x, int y, uint32_t c, unsigned a);
+
+/*****************************************************************
+ * span fill bursts: <surface-asm.S> on the pi, C on the host.
+ */
+// <n> >= 1 blocks of 32 bytes of <v>.  <p> word aligned.
+void surface_stm8(uint32_t *p, unsigned n, uint32_t v);
+// <n> >= 1 blocks of 24 bytes: <pat>[0..2] twice.
+void surface_stm6(uint32_t *p, unsigned n, const uint32_t *pat);
+
+#endif
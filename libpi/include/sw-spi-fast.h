@@ -0,0 +1,179 @@
+// fast bit-banged spi master: pins, mode and clock delay are compile
+// time constants, so every bit is a few raw GPSET0/GPCLR0 stores and
+// one GPLEV0 load, fully unrolled over the byte.
+#ifndef __SW_SPI_FAST_H__
+#define __SW_SPI_FAST_H__
+/*
+ * staff-sw-spi.o does each bit as out-of-line <gpio_write> /
+ * <gpio_read> calls (each a call plus pin checks plus PUT32/GET32)
+ * with the pins coming from the <spi_t> at runtime.  here, with
+ * constant pins (see <gpio-fast.h>) a bit in mode 0 is:
+ *      str mosi-bit -> GPSET0 or GPCLR0   (address picked by the data bit)
+ *      str sck-bit  -> GPSET0             (leading edge)
+ *      ldr GPLEV0                          (sample miso)
+ *      str sck-bit  -> GPCLR0             (trailing edge)
+ * and <sw_spi_byte> does eight of those back to back.
+ *
+ * two ways to use it:
+ *   - <gen_sw_spi(name, mosi, miso, sck, mode, delay)> makes
+ *     <name_init>, <name_xfer8> and <name_transfer> for one device.
+ *   - call <sw_spi_byte> directly with constant arguments.
+ * <delay> is extra cycles per half clock period (0 = as fast as the
+ * stores go: check your device's max clock).  miso = SW_SPI_NO_PIN for
+ * write-only devices.
+ *
+ * chip select is yours: <gpio_fast_off(ce)> before, <gpio_fast_on(ce)>
+ * after.
+ *
+ * parallel: <sw_spi_par_t> clocks one shared SCK and drives up to 32
+ * MOSI pins at once (one device each, or several lanes of one
+ * device), optionally sampling one MISO pin per lane.  the data is
+ * transposed into per-bit GPSET0 masks with <gpio-bus.h>, so the bit
+ * loop costs the same for 1 lane or 32.  mode 0 only.
+ *
+ * bank 0 pins (0..31) only.
+ *
+ * usage:
+ *      gen_sw_spi(flash, 10, 9, 11, SW_SPI_MODE0, 0)
+ *      ...
+ *      flash_init();
+ *      gpio_fast_off(8);
+ *      flash_transfer(rx, tx, n);
+ *      gpio_fast_on(8);
+ */
+#include "gpio-fast.h"
+#include "gpio-bus.h"
+#include "cycle-util.h"
+
+// bit 1 = CPOL (clock idles high), bit 0 = CPHA (sample on the
+// trailing edge).
+enum {
+    SW_SPI_MODE0 = 0,
+    SW_SPI_MODE1 = 1,
+    SW_SPI_MODE2 = 2,
+    SW_SPI_MODE3 = 3,
+
+    SW_SPI_NO_PIN = 0xff,
+};
+
+GPIO_FAST_INLINE void sw_spi_delay(unsigned cyc) {
+    if(cyc)
+        delay_ncycles(cycle_cnt_read(), cyc);
+}
+
+#ifndef RPI_UNIX
+// one bit out on <mosi>, one in from <miso>.  everything but <b>
+// should be a constant.
+GPIO_FAST_INLINE unsigned
+sw_spi_bit(unsigned mosi, unsigned miso, unsigned sck, unsigned mode,
+           unsigned delay, unsigned b) {
+    volatile uint32_t *set = (void *)GPIO_SET0;
+    volatile uint32_t *clr = (void *)GPIO_CLR0;
+    volatile uint32_t *lev = (void *)GPIO_LEV0;
+    uint32_t ck = GPIO_FAST_BIT(sck);
+
+    // leading edge: idle -> active; trailing: back to idle.
+    volatile uint32_t *lead = mode & 2 ? clr : set;
+    volatile uint32_t *trail = mode & 2 ? set : clr;
+    unsigned r = 0;
+
+    gpio_fast_chk(mosi);
+    gpio_fast_chk(sck);
+    if(!(mode & 1)) {
+        // data out before the leading edge, sample on it.
+        *(b ? set : clr) = GPIO_FAST_BIT(mosi);
+        sw_spi_delay(delay);
+        *lead = ck;
+        if(miso != SW_SPI_NO_PIN)
+            r = (*lev >> miso) & 1;
+        sw_spi_delay(delay);
+        *trail = ck;
+    } else {
+        // data out on the leading edge, sample on the trailing.
+        *lead = ck;
+        *(b ? set : clr) = GPIO_FAST_BIT(mosi);
+        sw_spi_delay(delay);
+        *trail = ck;
+        if(miso != SW_SPI_NO_PIN)
+            r = (*lev >> miso) & 1;
+        sw_spi_delay(delay);
+    }
+    return r;
+}
+
+// msb first.  written out rather than a loop so it's unrolled at any
+// -O level.
+GPIO_FAST_INLINE uint8_t
+sw_spi_byte(unsigned mosi, unsigned miso, unsigned sck, unsigned mode,
+            unsigned delay, uint8_t b) {
+#   define SW_SPI_BIT(i) \
+        (sw_spi_bit(mosi, miso, sck, mode, delay, b & (1 << (i))) << (i))
+    unsigned r = SW_SPI_BIT(7);
+    r |= SW_SPI_BIT(6);
+    r |= SW_SPI_BIT(5);
+    r |= SW_SPI_BIT(4);
+    r |= SW_SPI_BIT(3);
+    r |= SW_SPI_BIT(2);
+    r |= SW_SPI_BIT(1);
+    r |= SW_SPI_BIT(0);
+#   undef SW_SPI_BIT
+    return r;
+}
+#endif
+
+// pins to outputs / input and the clock to its idle level.
+static inline void
+sw_spi_pins_init(unsigned mosi, unsigned miso, unsigned sck, unsigned mode) {
+    if(mosi >= 32 || sck >= 32 || (miso >= 32 && miso != SW_SPI_NO_PIN))
+        panic("sw-spi: pins must be 0..31\n");
+    gpio_set_output(mosi);
+    gpio_set_output(sck);
+    gpio_write(sck, (mode & 2) != 0);
+    if(miso != SW_SPI_NO_PIN)
+        gpio_set_input(miso);
+}
+
+// <name>_transfer: <rx> (may be 0) gets what came back while <tx> (0 =
+// send zeros) went out.
+#define gen_sw_spi(name, mosi, miso, sck, mode, delay)                  \
+    static inline void name ## _init(void) {                            \
+        sw_spi_pins_init(mosi, miso, sck, mode);                        \
+    }                                                                   \
+    static inline uint8_t name ## _xfer8(uint8_t b) {                   \
+        return sw_spi_byte(mosi, miso, sck, mode, delay, b);            \
+    }                                                                   \
+    static inline void                                                  \
+    name ## _transfer(uint8_t *rx, const uint8_t *tx, unsigned n) {     \
+        dev_barrier();                                                  \
+        for(unsigned i = 0; i < n; i++) {                               \
+            uint8_t c = sw_spi_byte(mosi, miso, sck, mode, delay,       \
+                                    tx ? tx[i] : 0);                    \
+            if(rx)                                                      \
+                rx[i] = c;                                              \
+        }                                                               \
+        dev_barrier();                                                  \
+    }
+
+/*****************************************************************
+ * parallel lanes: <sw-spi-fast.c>
+ */
+typedef struct {
+    unsigned n;             // lanes.
+    unsigned sck;
+    unsigned miso_p:1;      // sample miso?
+    unsigned delay;         // extra cycles per half clock.
+    gpio_bus_t mosi;        // bit <i> = lane <i>.
+    gpio_bus_t miso;
+} sw_spi_par_t;
+
+// lane <i> drives <mosi[i]> and (if <miso> is non-zero) samples
+// <miso[i]>.  sets the pin functions.
+void sw_spi_par_init(sw_spi_par_t *p, unsigned sck, const unsigned *mosi,
+                     const unsigned *miso, unsigned n, unsigned delay);
+
+// <n> bytes on every lane: lane <i> sends <tx[i]> (0: zeros) and
+// receives into <rx[i]> (<rx> or <rx[i]> 0: dropped).
+void sw_spi_par_transfer(sw_spi_par_t *p, uint8_t **rx,
+                         const uint8_t **tx, unsigned n);
+
+#endif
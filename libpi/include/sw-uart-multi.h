@@ -0,0 +1,210 @@
+// multi-channel software uart receiver (msu): one periodic sampler
+// receives on up to MSU_MAX_CHAN bank-0 pins at once, all at the
+// same baud rate.
+#ifndef __SW_UART_MULTI_H__
+#define __SW_UART_MULTI_H__
+/*
+ * every tick reads GPLEV0 once (all 32 pins) and hands it to
+ * <msu_tick>; ticks run at <os> times the baud rate.
+ *
+ * bit-sliced: the per-tick work that touches every channel is done
+ * with 32-bit masks, one bit per pin:
+ *   - <idle>: channels waiting for a start bit.  a start is
+ *     idle & prev & ~lev: all channels in three ands.
+ *   - <phase[k]>: receiving channels whose next bit center lands on
+ *     ticks with (tick % os) == k.  a channel whose start edge was
+ *     seen on tick <t> samples on ticks t + os/2 + i*os.
+ * so on a tick only the channels in <phase[k]> do any per-channel
+ * work (shift in one bit), and each channel does that once per bit
+ * time, not once per tick.  idle lines cost nothing.
+ *
+ * the start edge is only known to within one tick, so samples land
+ * 0 to 1/os of a bit after the centers.  by the stop bit (9.5 bits
+ * in) that leaves, for os=4, about 2.5% for a sender faster than us
+ * and 5% for a slower one.
+ *
+ * <msu_tick> only needs the sampled levels, so it is the same code
+ * on the pi and in the host simulator (labs/useful-examples/
+ * sw-uart-multi/unix).  the drivers in <sw-uart-multi.c>:
+ *   - <msu_poll>: a busy loop with absolute cycle-counter deadlines.
+ *   - <msu_timer_start>: the arm timer interrupt at os*baud (through
+ *     <irq-dispatch.h>), so the cpu can do other work.
+ *
+ * usage:
+ *      #include "sw-uart.h"                // <BAUD_TO_CYCLES>
+ *      static msu_t m;
+ *      unsigned pins[] = { 20, 21, 22 };
+ *      msu_init(&m, pins, 3, 115200, 4);
+ *      msu_timer_start(&m);                 // or: msu_poll(&m, ncyc)
+ *      ...
+ *      int c = msu_get8_nonblk(&m, 1);      // channel 1 = pin 21.
+ */
+#include "circular-T.h"
+
+#define MSU_MAX_CHAN 16
+#define MSU_MAX_OS 16
+// per-channel receive queue: power of two.
+#define MSU_QSIZE 256
+
+gen_circular_T(msu_q, msu_q_t, uint8_t, MSU_QSIZE)
+
+typedef struct {
+    uint32_t nbytes;        // good bytes.
+    uint32_t nframe_err;    // stop bit low.
+    uint32_t nglitch;       // start bit gone by its center.
+    uint32_t ndrop;         // queue full.
+} msu_chan_stats_t;
+
+typedef struct {
+    uint8_t pin;
+    uint8_t nbit;           // bits sampled so far in this frame.
+    uint8_t shift;          // data bits, lsb first.
+    msu_q_t q;
+    msu_chan_stats_t st;
+} msu_chan_t;
+
+typedef struct {
+    // bit-sliced state: bit <p> is the channel on pin <p>.
+    uint32_t pins;
+    uint32_t idle;
+    uint32_t prev;
+    uint32_t phase[MSU_MAX_OS];
+
+    unsigned os;            // ticks per bit.
+    unsigned k;             // current tick % os.
+
+    unsigned nchan;
+    uint8_t pin2chan[32];
+    msu_chan_t ch[MSU_MAX_CHAN];
+
+    // driver info.
+    uint32_t baud;
+    uint32_t tick_cyc;      // cycles per tick (<msu_poll>).
+    uint32_t timer_load;    // apb cycles per tick (<msu_timer_start>).
+    uint32_t nticks;
+    uint32_t nlate;         // ticks that started a full tick late.
+    uint64_t busy_cyc;      // cycles inside <msu_tick>.
+} msu_t;
+
+// set up the decoder state only: no hardware.  channel <i> is pin
+// <pins[i]>.  <os> is ticks per bit (>= 3, <= MSU_MAX_OS).
+static inline void
+msu_state_init(msu_t *m, const unsigned *pins, unsigned n, unsigned os) {
+    if(n == 0 || n > MSU_MAX_CHAN)
+        panic("msu: %d channels: must be 1..%d\n", n, MSU_MAX_CHAN);
+    if(os < 3 || os > MSU_MAX_OS)
+        panic("msu: oversample %d: must be 3..%d\n", os, MSU_MAX_OS);
+
+    memset(m, 0, sizeof *m);
+    m->os = os;
+    m->nchan = n;
+    for(unsigned i = 0; i < n; i++) {
+        unsigned p = pins[i];
+        if(p >= 32)
+            panic("msu: pin %d: must be in bank 0\n", p);
+        if(m->pins & (1u << p))
+            panic("msu: pin %d used twice\n", p);
+        m->pins |= 1u << p;
+        m->pin2chan[p] = i;
+        m->ch[i].pin = p;
+        m->ch[i].q = msu_q_mk();
+    }
+    // lines idle high: don't take the first sample as a falling edge.
+    m->idle = m->prev = m->pins;
+}
+
+// channel <c> finished its frame (or gave up): wait for a start.
+static inline void msu_chan_idle(msu_t *m, msu_chan_t *c, uint32_t bit) {
+    m->phase[m->k] &= ~bit;
+    m->idle |= bit;
+    c->nbit = 0;
+    c->shift = 0;
+}
+
+// one sample of all pins.
+static inline void msu_tick(msu_t *m, uint32_t lev) {
+    unsigned k = m->k;
+
+    // every idle channel whose line just fell starts a frame.
+    uint32_t start = m->idle & m->prev & ~lev;
+    m->prev = lev;
+    if(start) {
+        m->idle &= ~start;
+        unsigned at = k + m->os / 2;
+        if(at >= m->os)
+            at -= m->os;
+        m->phase[at] |= start;
+    }
+
+    // channels at a bit center on this tick.
+    uint32_t act = m->phase[k];
+    while(act) {
+        unsigned p = 31 - __builtin_clz(act);
+        uint32_t bit = 1u << p;
+        act &= ~bit;
+
+        msu_chan_t *c = &m->ch[m->pin2chan[p]];
+        unsigned b = (lev >> p) & 1;
+        unsigned n = c->nbit++;
+
+        if(n == 0) {
+            // start bit: must still be low at its center.
+            if(b) {
+                c->st.nglitch++;
+                msu_chan_idle(m, c, bit);
+            }
+        } else if(n <= 8) {
+            c->shift = (c->shift >> 1) | (b << 7);
+        } else {
+            if(!b)
+                c->st.nframe_err++;
+            else if(!msu_q_push(&c->q, c->shift))
+                c->st.ndrop++;
+            else
+                c->st.nbytes++;
+            msu_chan_idle(m, c, bit);
+        }
+    }
+    m->k = k + 1 == m->os ? 0 : k + 1;
+}
+
+// next byte from channel <chan> or -1.
+static inline int msu_get8_nonblk(msu_t *m, unsigned chan) {
+    uint8_t c;
+    if(!msu_q_pop_nonblk(&m->ch[chan].q, &c))
+        return -1;
+    return c;
+}
+
+/*****************************************************************
+ * pi drivers: <sw-uart-multi.c>
+ */
+
+// the arm timer counts the 250MHz apb clock.
+#define MSU_APB_CLOCK (250*1000*1000)
+
+// <msu_state_init> plus: pins to pulled-up inputs, tick period from
+// <baud> and <cpu_cyc_per_usec>.  a macro so the divides fold when
+// <baud> and <os> are constants (no libgcc: see <udiv.h>); needs
+// <BAUD_TO_CYCLES> from <sw-uart.h>.
+#define msu_init(m, pins, n, baud, os)                              \
+    msu_init_helper(m, pins, n, baud, os,                           \
+        BAUD_TO_CYCLES((baud) * (os)), MSU_APB_CLOCK / ((baud) * (os)))
+void msu_init_helper(msu_t *m, const unsigned *pins, unsigned n,
+              unsigned baud, unsigned os,
+              uint32_t tick_cyc, uint32_t timer_load);
+
+// sample for <ncycles> in a busy loop.  run with interrupts off if
+// you can: a tick more than a tick late counts in <nlate> (the
+// samples catch up, but a late bit center is a likely bad byte).
+void msu_poll(msu_t *m, uint32_t ncycles);
+
+// sample from the arm timer interrupt (irq-dispatch: call
+// <irq_dispatch_init> first).  the arm timer counts the 250MHz apb
+// clock, so the tick is rounded to 4ns.
+void msu_timer_start(msu_t *m);
+void msu_timer_stop(msu_t *m);
+
+void msu_stats_print(msu_t *m);
+
+#endif
@@ -0,0 +1,101 @@
+// interrupt-driven software uart receiver: an async falling-edge
+// interrupt on the RX pin catches the start bit and the handler
+// samples the rest of the byte, so the CPU is free between bytes
+// (unlike <sw_uart_get8_timeout>, which spins waiting for one).
+#ifndef __SW_UART_RX_H__
+#define __SW_UART_RX_H__
+/*
+ * the handler:
+ *   1. reads the cycle counter and backs off <lat_cyc> (the
+ *      edge-to-handler latency) to estimate when the edge happened.
+ *   2. spins to the precomputed center of the start bit, each data
+ *      bit and the stop bit (<off[]>, computed once at init) and
+ *      samples GPLEV0.  a high start bit is a glitch, a low stop bit
+ *      a framing error.
+ *   3. clears the pin's event (the data bits' falling edges set it
+ *      again) and pushes the byte into <q>.
+ * it returns in the middle of the stop bit, so back-to-back bytes
+ * leave half a bit for the return and the next interrupt.
+ *
+ * the CPU is busy for ~9.5 bit times per byte received: at 230400
+ * that is ~41usec per byte, with the rest free.  <sw_uart_rx_stats>
+ * reports the cycles spent in the handler so you can see the
+ * utilization at your traffic rate.
+ *
+ * limits:
+ *   - RX pin must be in bank 0 (0..31).
+ *   - uses <irq-dispatch.h> for <IRQ_GPIO0>, which has one handler:
+ *     one receiver at a time, and nothing else using GPIO interrupts.
+ *     call <irq_dispatch_init> first.
+ *   - other interrupts delay the start-bit handling: at high baud
+ *     rates keep handlers short or the byte is lost.
+ *
+ * usage:
+ *      irq_dispatch_init();
+ *      sw_uart_rx_t rx;
+ *      sw_uart_rx_init(&rx, 21, 230400);
+ *      enable_interrupts();
+ *      ...
+ *      int c = sw_uart_rx_get8_nonblk(&rx);  // -1 if nothing.
+ */
+#include "sw-uart.h"
+#include "circular-T.h"
+
+// received-byte queue size: must be a power of two.
+#define SW_UART_RX_QSIZE 256
+
+// default cycles from the edge to the first instruction of our
+// handler through <irq-dispatch.h> (see labs/useful-examples/int-bench).
+// only has to be within a fraction of a bit, but matters at high
+// baud rates.
+#define SW_UART_RX_LAT_CYC 150
+
+gen_circular_T(sw_rxq, sw_rxq_t, uint8_t, SW_UART_RX_QSIZE)
+
+typedef struct {
+    uint32_t nbytes;        // good bytes received.
+    uint32_t nframe_err;    // stop bit was low: byte dropped.
+    uint32_t nglitch;       // start bit gone by its center.
+    uint32_t ndrop;         // good bytes lost because <q> was full.
+    uint64_t busy_cyc;      // total cycles in the handler.
+} sw_uart_rx_stats_t;
+
+typedef struct {
+    uint8_t pin;
+    uint32_t baud;
+    uint32_t cyc_per_bit;
+    uint32_t lat_cyc;
+    uint32_t off[10];       // start center, 8 data centers, stop center.
+    sw_rxq_t q;
+    sw_uart_rx_stats_t st;
+} sw_uart_rx_t;
+
+// setup <pin> as a pulled-up input with async falling-edge
+// interrupts and register the handler.  interrupts should be off.
+void sw_uart_rx_init_helper(sw_uart_rx_t *r, unsigned pin,
+                            unsigned baud, unsigned cyc_per_bit);
+
+// do the division at the callsite, as <sw_uart_init>.
+#define sw_uart_rx_init(r, pin, baud) \
+    sw_uart_rx_init_helper(r, pin, baud, BAUD_TO_CYCLES(baud))
+
+// change the edge-to-handler latency estimate (cycles).
+void sw_uart_rx_set_latency(sw_uart_rx_t *r, unsigned lat_cyc);
+
+// turn off the edge interrupt and unregister.  queued bytes stay.
+void sw_uart_rx_stop(sw_uart_rx_t *r);
+
+// returns the next byte or -1 if none.
+int sw_uart_rx_get8_nonblk(sw_uart_rx_t *r);
+
+// like <sw_uart_get8_timeout>: -1 if nothing after <timeout_usec>.
+// interrupts must be on.
+int sw_uart_rx_get8_timeout(sw_uart_rx_t *r, uint32_t timeout_usec);
+
+// copy up to <n> queued bytes to <buf>, returns number copied.
+unsigned sw_uart_rx_read(sw_uart_rx_t *r, void *buf, unsigned n);
+
+sw_uart_rx_stats_t sw_uart_rx_stats(sw_uart_rx_t *r);
+void sw_uart_rx_stats_print(sw_uart_rx_t *r);
+
+#endif
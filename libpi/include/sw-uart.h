@@ -1,5 +1,6 @@
 #ifndef __SW_UART_H__
 #define __SW_UART_H__
+#include "cpu-freq.h"
 
 // engler, cs140e: a simple software uart interface that bit-bangs
 // the uart protocol on two client-specified GPIO pins at a 
@@ -63,10 +64,15 @@ sw_uart_t sw_uart_init_helper(
 // hardware does provide).
 // we need to dthis 
 //
-// NOTE: if you overclock the pi (or somehow you have a batch
-// that doesn't run at 700mz by default) you'd have to change 
-// the 700 in <BAUD_TO_CYCLES> 
-#define BAUD_TO_CYCLES(baud) ((700*1000*1000UL)/baud)
+// the cycles per usec is measured at boot (<cpu-freq.h>) so this
+// survives overclocking.  the divide is only of constants (usec
+// per bit in Q16) so <baud> must still be one: the runtime part is
+// a multiply by <cpu_cyc_per_usec>.  the two halves are split out
+// so a table of constant bauds can store the first.
+#define BAUD_TO_USEC_Q16(baud) ((uint32_t)((1000*1000ULL << 16) / (baud)))
+#define USEC_Q16_TO_CYCLES(q) \
+    ((uint32_t)(((uint64_t)cpu_cyc_per_usec() * (q)) >> 16))
+#define BAUD_TO_CYCLES(baud) USEC_Q16_TO_CYCLES(BAUD_TO_USEC_Q16(baud))
 #define BAUD_TO_USEC(baud) ((1000*1000UL)/baud)
 
 // do division at the callsite so gcc can strength reduce.
@@ -0,0 +1,72 @@
+#ifndef __SYS_TIMER_H__
+#define __SYS_TIMER_H__
+/*
+ * bcm2835 system timer: ch 12, p172--174.  a free running 1MHz
+ * 64-bit counter (CHI:CLO) and four 32-bit compare registers.
+ * when CLO == C<n>, bit <n> is set in CS and IRQ <n> (p113) fires
+ * if enabled.  writing 1<<n to CS clears the match.
+ *
+ * NOTE: the GPU uses compare channels 0 and 2, so the ARM can
+ * only use channels 1 and 3.
+ *
+ * NOTE: a compare only fires on equality, so if you set a compare
+ * value that has already passed it won't fire until CLO wraps
+ * (~71 minutes).  check the time after arming.
+ */
+#include "rpi-interrupts.h"
+
+enum {
+    SYS_TIMER_BASE  = 0x20003000,
+    SYS_TIMER_CS    = SYS_TIMER_BASE + 0x00,
+    SYS_TIMER_CLO   = SYS_TIMER_BASE + 0x04,
+    SYS_TIMER_CHI   = SYS_TIMER_BASE + 0x08,
+    SYS_TIMER_C0    = SYS_TIMER_BASE + 0x0c,
+    SYS_TIMER_C1    = SYS_TIMER_BASE + 0x10,
+    SYS_TIMER_C2    = SYS_TIMER_BASE + 0x14,
+    SYS_TIMER_C3    = SYS_TIMER_BASE + 0x18,
+};
+
+// the compare channels the ARM can use.
+enum { SYS_TIMER_CHAN1 = 1, SYS_TIMER_CHAN3 = 3 };
+
+static inline void sys_timer_chan_chk(unsigned chan) {
+    if(chan != SYS_TIMER_CHAN1 && chan != SYS_TIMER_CHAN3)
+        panic("illegal system timer channel %d: must be 1 or 3\n", chan);
+}
+
+// set compare channel <chan> to fire at absolute time <usec>.
+static inline void sys_timer_compare_set(unsigned chan, uint32_t usec) {
+    PUT32(SYS_TIMER_C0 + chan*4, usec);
+}
+
+// 1 if channel <chan> has matched and not been cleared.
+static inline int sys_timer_matched(unsigned chan) {
+    return (GET32(SYS_TIMER_CS) >> chan) & 1;
+}
+
+// clear the match on <chan> (and so its interrupt).
+static inline void sys_timer_clear(unsigned chan) {
+    PUT32(SYS_TIMER_CS, 1 << chan);
+}
+
+// route channel <chan> matches to the interrupt controller.
+// IRQ <n> is bit <n> in <IRQ_Enable_1> (p113, p116).
+static inline void sys_timer_int_enable(unsigned chan) {
+    sys_timer_chan_chk(chan);
+    dev_barrier();
+    PUT32(IRQ_Enable_1, 1 << chan);
+    dev_barrier();
+}
+static inline void sys_timer_int_disable(unsigned chan) {
+    sys_timer_chan_chk(chan);
+    dev_barrier();
+    PUT32(IRQ_Disable_1, 1 << chan);
+    dev_barrier();
+}
+
+// 1 if the interrupt controller has a pending interrupt for <chan>.
+static inline int sys_timer_int_pending(unsigned chan) {
+    return (GET32(IRQ_pending_1) >> chan) & 1;
+}
+
+#endif
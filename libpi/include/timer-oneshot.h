@@ -0,0 +1,77 @@
+// one-shot timers: call <fn(arg)> at an absolute 64-bit deadline
+// using a system timer compare channel instead of polling.
+#ifndef __TIMER_ONESHOT_H__
+#define __TIMER_ONESHOT_H__
+/*
+ * any number of timers share one compare channel (<sys-timer.h>):
+ * pending timers are kept in a list sorted by deadline and the
+ * channel is always armed for the earliest one.  the compare
+ * register only holds the low 32 bits of the time, so deadlines
+ * more than ~35 minutes out are reached in several hops.
+ *
+ * callbacks run in the interrupt handler (IRQ mode, interrupts
+ * off): keep them short.  a callback can re-arm its own timer.
+ *
+ * timers are caller-allocated (no kmalloc): a <oneshot_t> must
+ * stay live until it fires or is cancelled.
+ *
+ * uses the dispatcher (<irq-dispatch.h>), so call
+ * <irq_dispatch_init> first.  <rt-sched.h> can use the other
+ * channel.
+ *
+ * usage:
+ *      irq_dispatch_init();
+ *      oneshot_init(SYS_TIMER_CHAN3);
+ *      enable_interrupts();
+ *      oneshot_t t;
+ *      oneshot_arm_in(&t, 1000, my_fn, my_arg);  // in 1ms.
+ */
+#include "sys-timer.h"
+
+typedef void (*oneshot_fn_t)(void *arg);
+
+typedef struct oneshot {
+    uint64_t deadline;          // absolute, in <timer_get_usec64> usec.
+    oneshot_fn_t fn;
+    void *arg;
+    struct oneshot *next;
+    unsigned armed_p:1;
+} oneshot_t;
+
+// claim compare channel <chan> (1 or 3) and register the handler.
+// interrupts must be off.
+void oneshot_init(unsigned chan);
+
+// call <fn(arg)> once the time is >= <deadline_usec>.  if the
+// deadline already passed, it fires on the next interrupt.  <t>
+// must not already be armed.
+void oneshot_arm(oneshot_t *t, uint64_t deadline_usec, oneshot_fn_t fn, void *arg);
+
+// call <fn(arg)> <usec> from now.
+static inline void
+oneshot_arm_in(oneshot_t *t, uint32_t usec, oneshot_fn_t fn, void *arg) {
+    oneshot_arm(t, timer_get_usec64() + usec, fn, arg);
+}
+
+// remove <t>: returns 1 if it was pending, 0 if it already fired
+// (or was never armed).
+int oneshot_cancel(oneshot_t *t);
+
+// 1 if <t> is waiting to fire.
+static inline int oneshot_pending(oneshot_t *t) {
+    gcc_mb();
+    return t->armed_p;
+}
+
+// sleep until <deadline_usec>.  if interrupts are on and
+// <oneshot_init> was called, the cpu waits for the interrupt
+// (<cpu_wait_for_int>) instead of polling the timer.
+void oneshot_sleep_until(uint64_t deadline_usec);
+static inline void oneshot_sleep_us(uint32_t usec) {
+    oneshot_sleep_until(timer_get_usec64() + usec);
+}
+
+// number of timer interrupts and callbacks so far.
+void oneshot_stats(void);
+
+#endif
@@ -0,0 +1,82 @@
+// interrupt-driven mini-uart driver: RX and TX go through circular
+// queues so we don't drop bytes while doing other work.
+#ifndef __UART_INT_H__
+#define __UART_INT_H__
+/*
+ * the staff <uart.o> routines are polled: if you don't call
+ * <uart_get8> often enough the 8-byte RX fifo overruns and bytes
+ * are silently dropped (e.g., the lidar in 4-lidar-I).  here:
+ *   - RX interrupt: drain the whole RX fifo into <rx> on every
+ *     interrupt and count hardware overruns.
+ *   - TX interrupt: enabled only while <tx> has data; each
+ *     interrupt tops the 8-byte TX fifo back up.
+ *
+ * uses the dispatcher (<irq-dispatch.h>) for <IRQ_AUX>, so call
+ * <irq_dispatch_init> first.  interrupts must be off during
+ * <uart_int_init>.
+ *
+ * usage:
+ *      irq_dispatch_init();
+ *      uart_int_init(230400);
+ *      rpi_putchar_set(uart_int_putchar);   // optional: printk via tx.
+ *      enable_interrupts();
+ *      ...
+ *      n = uart_read(buf, sizeof buf);      // never blocks.
+ *
+ * NOTE: changing the baud rate means the host side has to match.
+ */
+
+// RX and TX queue size: at 230400 baud we get ~23 bytes/ms so the
+// RX queue holds ~90ms of data.  must be a power of two.
+#define UART_QSIZE 2048
+
+// the mini-uart runs at AUX_CLOCK / (8 * (reg + 1)).
+#define UART_INT_AUX_CLOCK (250*1000*1000)
+// the baud register for <baud>: a macro so the divide is done at
+// the call site, where a constant <baud> folds (there's no libgcc
+// for a runtime divide).
+#define UART_INT_BAUD_REG(baud) (UART_INT_AUX_CLOCK / (8 * (baud)) - 1)
+
+// (re)initialize the mini-uart at <baud> (a constant) and register
+// the interrupt handler.  any pending TX is flushed first.
+#define uart_int_init(baud) \
+    uart_int_init_helper(baud, UART_INT_BAUD_REG(baud))
+void uart_int_init_helper(unsigned baud, unsigned baud_reg);
+
+// stop interrupts and go back to polled mode (staff <uart.o>).
+// flushes the TX queue first.
+void uart_int_disable(void);
+
+// non-blocking: copy up to <n> received bytes into <buf>, returns
+// the number copied.
+unsigned uart_read(void *buf, unsigned n);
+// non-blocking: queue up to <n> bytes from <buf>, returns the
+// number queued.
+unsigned uart_write(const void *buf, unsigned n);
+
+// bytes available to read / space available to write.
+unsigned uart_rx_avail(void);
+unsigned uart_tx_space(void);
+
+// blocking compatibility shims with the same semantics as
+// <uart_get8>, <uart_put8>, <uart_flush_tx> in <rpi.h>.  they wait
+// for an interrupt, so interrupts must be enabled.
+int uart_int_get8(void);
+int uart_int_put8(uint8_t c);
+void uart_int_flush_tx(void);
+
+// install with <rpi_putchar_set> so printk goes through the TX queue.
+int uart_int_putchar(int c);
+
+typedef struct {
+    uint32_t nints;         // interrupts taken.
+    uint32_t nrx, ntx;      // bytes received / transmitted.
+    uint32_t hw_overrun;    // RX fifo overruns (bytes lost in hardware).
+    uint32_t rx_drop;       // bytes lost because <rx> was full.
+    uint32_t rx_max;        // high water mark of <rx>.
+} uart_int_stats_t;
+
+uart_int_stats_t uart_int_stats(void);
+void uart_int_stats_print(void);
+
+#endif
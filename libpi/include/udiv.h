@@ -0,0 +1,19 @@
+// slow unsigned divide that doesn't need libgcc.
+#ifndef __UDIV_H__
+#define __UDIV_H__
+/*
+ * the arm1176 has no divide instruction and we don't link libgcc, so
+ * a '/' or '%' by anything gcc can't fold is a call to
+ * __aeabi_uidiv / __aeabi_uldivmod that won't link.  (32-bit divides
+ * by a constant are fine: gcc turns them into a multiply.)
+ *
+ * hot paths should shift or multiply by a reciprocal instead; this
+ * is for computing that reciprocal when the rate is measured
+ * (<cpu_freq_set>, <clock_ns_resync>).  it's a 64-step shift and
+ * subtract, so ~a usec: don't use it per sample.
+ */
+
+// <n> / <d>.  panics if <d> is 0.
+uint64_t udiv64(uint64_t n, uint64_t d);
+
+#endif
@@ -0,0 +1,202 @@
+// cycle-counter nanosecond clock: see <clock-ns.h>
+#include "rpi.h"
+#include "rpi-inline-asm.h"
+#include "cycle-count.h"
+#include "timer-oneshot.h"
+#include "clock-ns.h"
+#include "cpu-freq.h"
+#include "udiv.h"
+
+enum {
+    // <mult> is ns per cycle << MULT_SHIFT.
+    MULT_SHIFT = 24,
+    // how long <clock_ns_recalibrate> spins.
+    CAL_USEC = 1000,
+    DEFAULT_PERIOD_USEC = 1000*1000,
+};
+
+// what readers use.  <seq> is odd while a resync is updating the
+// rest: readers retry if it was odd or changed under them.
+static struct {
+    volatile uint32_t seq;
+    uint64_t base_ns;
+    uint32_t base_cyc;
+    uint32_t mult;
+} ck;
+
+// the raw (unslewed) last sync point, to measure the rate.
+static uint64_t sync_usec;
+static uint32_t sync_cyc;
+
+static oneshot_t tick;
+static uint32_t tick_period;
+static unsigned nresync, nrecal, nstale;
+static uint32_t max_corr_ns;
+
+// read the cycle counter right as the system timer ticks over so
+// that both halves are (nearly) the same instant.  costs up to 1usec.
+static void sample(uint64_t *usec, uint32_t *cyc) {
+    uint64_t u0 = timer_get_usec64();
+    uint32_t lo = u0, u;
+    while((u = timer_get_usec_raw()) == lo)
+        ;
+    *cyc = cycle_cnt_read();
+    *usec = u0 + (u - lo);
+}
+
+// <cpu-freq.h>'s ns per cycle (Q16) as a <mult>: no divide.
+static uint32_t nominal_mult(void) {
+    return cpu_nsec_per_cyc_q16() << (MULT_SHIFT - 16);
+}
+
+static inline uint64_t extrapolate(uint32_t cyc) {
+    return ck.base_ns + (((uint64_t)(cyc - ck.base_cyc) * ck.mult) >> MULT_SHIFT);
+}
+
+// interrupts must be off.
+static void set(uint64_t base_ns, uint32_t base_cyc, uint32_t mult) {
+    ck.seq++;
+    gcc_mb();
+    ck.base_ns = base_ns;
+    ck.base_cyc = base_cyc;
+    ck.mult = mult;
+    gcc_mb();
+    ck.seq++;
+}
+
+uint64_t clock_now_ns(void) {
+    uint32_t s;
+    uint64_t ns;
+    do {
+        s = ck.seq;
+        gcc_mb();
+        ns = extrapolate(cycle_cnt_read());
+        gcc_mb();
+    } while((s & 1) || s != ck.seq);
+    return ns;
+}
+
+void clock_ns_recalibrate(void) {
+    uint32_t cpsr = cpsr_int_disable();
+    uint64_t u0, u1;
+    uint32_t c0, c1;
+    sample(&u0, &c0);
+    while(timer_get_usec64() - u0 < CAL_USEC)
+        ;
+    sample(&u1, &c1);
+
+    // a cycle counter that doesn't count (e.g. qemu): keep the rate
+    // we had (nominal the first time), as <cpu_freq_calibrate> does.
+    // rates are measured with <udiv64> (no libgcc): once per
+    // resync, never per read.
+    int stalled = c1 == c0;
+    uint32_t mult;
+    if(!stalled)
+        mult = udiv64((u1 - u0) * 1000 << MULT_SHIFT, c1 - c0);
+    else if(ck.mult)
+        mult = ck.mult;
+    else
+        mult = nominal_mult();
+
+    // stay monotonic: never move back from what we'd report now.
+    uint64_t ns = u1 * 1000;
+    if(ck.mult) {
+        uint64_t ext = extrapolate(c1);
+        if(ext > ns)
+            ns = ext;
+    }
+    set(ns, c1, mult);
+    sync_usec = u1;
+    sync_cyc = c1;
+    nrecal++;
+    cpsr_int_reset(cpsr);
+
+    // the frequency may have changed: tell everyone else.
+    if(!stalled)
+        cpu_freq_set(clock_ns_cyc_per_usec());
+}
+
+void clock_ns_init(void) {
+    cycle_cnt_init();
+    uint32_t cpsr = cpsr_int_disable();
+    set(timer_get_usec64() * 1000, cycle_cnt_read(), nominal_mult());
+    cpsr_int_reset(cpsr);
+    clock_ns_recalibrate();
+}
+
+void clock_ns_resync(void) {
+    if(!ck.mult)
+        panic("clock_ns_init not called\n");
+
+    uint32_t cpsr = cpsr_int_disable();
+    uint64_t u;
+    uint32_t c;
+    sample(&u, &c);
+
+    // the cycle counter wraps after 2^32 cycles: if more time than
+    // that went by, (c - sync_cyc) is garbage and so is the rate.  a
+    // counter that isn't running (qemu) gives no rate either.
+    uint64_t dusec = u - sync_usec;
+    uint64_t dns = dusec * 1000;
+    uint32_t dcyc = c - sync_cyc;
+    uint64_t wrap_cyc = 7 * ((uint64_t)1 << 32) / 8;
+    if(dusec * cpu_cyc_per_usec() >= wrap_cyc || !dcyc) {
+        nstale++;
+        cpsr_int_reset(cpsr);
+        clock_ns_recalibrate();
+        return;
+    }
+
+    uint32_t mult = udiv64(dns << MULT_SHIFT, dcyc);
+
+    uint64_t ns = u * 1000;
+    uint64_t ext = extrapolate(c);
+    uint32_t corr = ext > ns ? ext - ns : ns - ext;
+    if(corr > max_corr_ns)
+        max_corr_ns = corr;
+
+    // we ran fast: jumping back to <ns> would break monotonicity,
+    // so hold at <ext> and run slow enough to lose the error over
+    // about one more period.
+    uint32_t m = mult;
+    if(ext > ns) {
+        uint64_t err = ext - ns;
+        if(err < dns / 2)
+            m = mult - udiv64(mult * err, dns);
+        ns = ext;
+    }
+    set(ns, c, m);
+    sync_usec = u;
+    sync_cyc = c;
+    nresync++;
+    cpsr_int_reset(cpsr);
+}
+
+static void clock_ns_tick(void *arg) {
+    clock_ns_resync();
+    oneshot_arm(&tick, tick.deadline + tick_period, clock_ns_tick, 0);
+}
+
+void clock_ns_start(uint32_t period_usec) {
+    if(!period_usec)
+        period_usec = DEFAULT_PERIOD_USEC;
+    if(!ck.mult)
+        clock_ns_init();
+    // leave margin for frequency going up.
+    if((uint64_t)period_usec * clock_ns_cyc_per_usec() > (1u << 31))
+        panic("resync period %dusec too long: cycle counter will wrap\n",
+            period_usec);
+
+    oneshot_cancel(&tick);
+    tick_period = period_usec;
+    oneshot_arm_in(&tick, period_usec, clock_ns_tick, 0);
+}
+
+uint32_t clock_ns_cyc_per_usec(void) {
+    return udiv64(((uint64_t)1000 << MULT_SHIFT) + ck.mult / 2, ck.mult);
+}
+
+void clock_ns_stats(void) {
+    output("clock_ns: %d cyc/usec, resyncs=%d recalibrations=%d stale=%d max correction=%dns\n",
+        clock_ns_cyc_per_usec(), nresync, nrecal, nstale, max_corr_ns);
+}
@@ -0,0 +1,234 @@
+// dirty-rectangle compositor: see <compositor.h>
+#include "rpi.h"
+#include "dma.h"
+#include "compositor.h"
+
+static rect_t screen(comp_t *c) {
+    return (rect_t){ 0, 0, c->back.w, c->back.h };
+}
+static rect_t layer_rect(layer_t *l) {
+    return (rect_t){ l->x, l->y, l->s.w, l->s.h };
+}
+
+// add <r> to the <n>-entry list <d>, merging where the bounding box
+// wastes at most ~25% over the two, or with the cheapest entry when
+// the list is full.  a merged box can swallow more: start over.
+static void dirty_add(rect_t *d, unsigned *n, unsigned max, rect_t r) {
+    if(rect_empty(r))
+        return;
+again:
+    for(unsigned i = 0; i < *n; i++) {
+        rect_t u = rect_or(d[i], r);
+        if(rect_area(u) * 4 <= (rect_area(d[i]) + rect_area(r)) * 5) {
+            d[i] = d[--*n];
+            r = u;
+            goto again;
+        }
+    }
+    if(*n < max) {
+        d[(*n)++] = r;
+        return;
+    }
+    unsigned best = 0, best_grow = ~0;
+    for(unsigned i = 0; i < *n; i++) {
+        unsigned grow = rect_area(rect_or(d[i], r)) - rect_area(d[i]);
+        if(grow < best_grow) {
+            best_grow = grow;
+            best = i;
+        }
+    }
+    r = rect_or(d[best], r);
+    d[best] = d[--*n];
+    goto again;
+}
+
+void comp_init(comp_t *c, surface_t back, surface_t front, uint32_t bg) {
+    if(back.w != front.w || back.h != front.h || back.depth != front.depth)
+        panic("comp: back %dx%dx%d != front %dx%dx%d\n",
+            back.w, back.h, back.depth, front.w, front.h, front.depth);
+    memset(c, 0, sizeof *c);
+    c->back = back;
+    c->front = front;
+    surface_unclip(&c->back);
+    surface_unclip(&c->front);
+    c->bg = bg;
+    comp_damage(c, screen(c));
+}
+
+void comp_dma(comp_t *c, int on) {
+    if(on)
+        dma_init();
+    c->dma_p = on != 0;
+}
+
+void comp_damage(comp_t *c, rect_t r) {
+    dirty_add(c->dirty, &c->ndirty, COMP_MAXDIRTY, rect_and(r, screen(c)));
+}
+
+void layer_damage(layer_t *l, rect_t r) {
+    rect_t all = { 0, 0, l->s.w, l->s.h };
+    dirty_add(l->dirty, &l->ndirty, LAYER_MAXDIRTY, rect_and(r, all));
+}
+
+void comp_layer_add(comp_t *c, layer_t *l, surface_t s, int x, int y) {
+    if(s.depth != c->back.depth)
+        panic("comp: layer depth %d, screen %d\n", s.depth, c->back.depth);
+    memset(l, 0, sizeof *l);
+    l->s = s;
+    l->x = x;
+    l->y = y;
+    l->visible_p = 1;
+
+    layer_t **p = &c->layers;
+    while(*p)
+        p = &(*p)->next;
+    *p = l;
+    comp_damage(c, layer_rect(l));
+}
+
+void comp_layer_remove(comp_t *c, layer_t *l) {
+    for(layer_t **p = &c->layers; *p; p = &(*p)->next)
+        if(*p == l) {
+            *p = l->next;
+            if(l->visible_p)
+                comp_damage(c, layer_rect(l));
+            return;
+        }
+    panic("comp: layer %p not in the stack\n", l);
+}
+
+void comp_layer_move(comp_t *c, layer_t *l, int x, int y) {
+    if(l->x == x && l->y == y)
+        return;
+    if(l->visible_p)
+        comp_damage(c, layer_rect(l));
+    l->x = x;
+    l->y = y;
+    if(l->visible_p)
+        comp_damage(c, layer_rect(l));
+}
+
+void comp_layer_show(comp_t *c, layer_t *l, int on) {
+    if(l->visible_p == (on != 0))
+        return;
+    l->visible_p = on != 0;
+    comp_damage(c, layer_rect(l));
+}
+
+void comp_layer_key(comp_t *c, layer_t *l, uint32_t key) {
+    l->key_p = 1;
+    l->key = key;
+    if(l->visible_p)
+        comp_damage(c, layer_rect(l));
+}
+
+// copy <o> (screen coordinates) of <l> into back, skipping key pixels.
+static void blit_key(comp_t *c, layer_t *l, rect_t o) {
+    for(int y = o.y; y < o.y + o.h; y++)
+        for(int x = o.x; x < o.x + o.w; x++) {
+            uint32_t v = surface_get_raw(&l->s, x - l->x, y - l->y);
+            if(v != l->key)
+                surface_put_raw(&c->back, x, y, v);
+        }
+}
+
+// redraw <r> in back.  returns pixels written.
+static unsigned composite(comp_t *c, rect_t r) {
+    // the topmost opaque layer covering all of <r>: start there.
+    layer_t *start = 0;
+    for(layer_t *l = c->layers; l; l = l->next)
+        if(l->visible_p && !l->key_p && rect_contains(layer_rect(l), r))
+            start = l;
+
+    unsigned n = 0;
+    if(!start) {
+        start = c->layers;
+        if(c->dma_p && c->back.bytes_pp == 4)
+            dma_fill2d(surface_row(&c->back, r.y) + r.x * 4, c->back.pitch,
+                c->bg, r.w * 4, r.h);
+        else
+            surf_fill_rect(&c->back, r.x, r.y, r.w, r.h, c->bg);
+        n += rect_area(r);
+    }
+    for(layer_t *l = start; l; l = l->next) {
+        if(!l->visible_p)
+            continue;
+        rect_t o = rect_and(r, layer_rect(l));
+        if(rect_empty(o))
+            continue;
+        if(l->key_p)
+            blit_key(c, l, o);
+        else
+            surf_blit(&c->back, o.x, o.y, &l->s, o.x - l->x, o.y - l->y, o.w, o.h);
+        n += rect_area(o);
+    }
+    return n;
+}
+
+static void copy_front(comp_t *c, rect_t r) {
+    if(!c->dma_p) {
+        surf_blit(&c->front, r.x, r.y, &c->back, r.x, r.y, r.w, r.h);
+        return;
+    }
+    unsigned off = r.x * c->back.bytes_pp;
+    dma_blit(surface_row(&c->front, r.y) + off, c->front.pitch,
+             surface_row(&c->back, r.y) + off, c->back.pitch,
+             r.w * c->back.bytes_pp, r.h);
+}
+
+unsigned comp_frame(comp_t *c) {
+    uint32_t start = timer_get_usec();
+
+    // layer damage -> screen damage.
+    for(layer_t *l = c->layers; l; l = l->next) {
+        if(l->visible_p)
+            for(unsigned i = 0; i < l->ndirty; i++) {
+                rect_t r = l->dirty[i];
+                r.x += l->x;
+                r.y += l->y;
+                comp_damage(c, r);
+            }
+        l->ndirty = 0;
+    }
+
+    unsigned composited = 0, copied = 0;
+    for(unsigned i = 0; i < c->ndirty; i++) {
+        rect_t r = c->dirty[i];
+        composited += composite(c, r);
+        copy_front(c, r);
+        copied += rect_area(r);
+    }
+
+    c->nframe++;
+    c->nrects = c->ndirty;
+    c->ndirty = 0;
+    c->composited = composited;
+    c->copied = copied;
+    c->tot_composited += composited;
+    c->tot_copied += copied;
+    if(copied > c->max_copied)
+        c->max_copied = copied;
+    c->usec = timer_get_usec() - start;
+    c->tot_usec += c->usec;
+    return copied;
+}
+
+void comp_stats_print(comp_t *c) {
+    if(!c->nframe) {
+        output("comp: no frames\n");
+        return;
+    }
+    // totals, not averages: dividing by <nframe> is a runtime divide
+    // (no libgcc).  the 32-bit totals wrap after ~14000 full frames.
+    unsigned full = c->back.w * c->back.h;
+    output("comp: %d frames of %d pixels: front %d pixels total max %d, back %d total, %dusec total%s\n",
+        c->nframe, full, (uint32_t)c->tot_copied, c->max_copied,
+        (uint32_t)c->tot_composited, (uint32_t)c->tot_usec,
+        c->dma_p ? " (dma)" : "");
+}
+
+void comp_stats_reset(comp_t *c) {
+    c->nframe = 0;
+    c->max_copied = 0;
+    c->tot_composited = c->tot_copied = c->tot_usec = 0;
+}
@@ -0,0 +1,57 @@
+// runtime cycles per usec: see <cpu-freq.h>
+#include "rpi.h"
+#include "rpi-inline-asm.h"
+#include "cycle-count.h"
+#include "cpu-freq.h"
+#include "udiv.h"
+
+uint32_t cpu_cyc_per_usec_var = CYC_PER_USEC;
+uint32_t cpu_usec_per_cyc_q32_var = ((1ULL << 32) + CYC_PER_USEC - 1) / CYC_PER_USEC;
+uint32_t cpu_nsec_per_cyc_q16_var = ((1000ULL << 16) + CYC_PER_USEC / 2) / CYC_PER_USEC;
+
+// cycle count right as the system timer reaches <usec>, so the
+// usec and the cycle count are (nearly) the same instant.
+static uint32_t sample_at(uint32_t usec) {
+    while((int32_t)(timer_get_usec_raw() - usec) < 0)
+        ;
+    return cycle_cnt_read();
+}
+
+void cpu_freq_set(uint32_t cyc_per_usec) {
+    if(!cyc_per_usec)
+        panic("cycles per usec = 0\n");
+#ifdef CPU_CYC_PER_USEC_FIXED
+    // within 1%: anything more and the compile-time value is wrong.
+    if(cyc_per_usec * 100 < CPU_CYC_PER_USEC_FIXED * 99
+    || cyc_per_usec * 100 > CPU_CYC_PER_USEC_FIXED * 101)
+        panic("measured %d cycles/usec, compiled for %d\n",
+            cyc_per_usec, CPU_CYC_PER_USEC_FIXED);
+#endif
+    cpu_cyc_per_usec_var = cyc_per_usec;
+    // the only divides: once per measurement, not per conversion.
+    cpu_usec_per_cyc_q32_var =
+        udiv64((1ULL << 32) + cyc_per_usec - 1, cyc_per_usec);
+    cpu_nsec_per_cyc_q16_var =
+        udiv64((1000ULL << 16) + cyc_per_usec / 2, cyc_per_usec);
+}
+
+uint32_t cpu_freq_calibrate(void) {
+    cycle_cnt_init();
+
+    uint32_t cpsr = cpsr_int_disable();
+    // exactly CPU_FREQ_CAL_USEC ticks apart.
+    uint32_t u0 = timer_get_usec() + 1;
+    uint32_t c0 = sample_at(u0);
+    uint32_t c1 = sample_at(u0 + CPU_FREQ_CAL_USEC);
+    cpsr_int_reset(cpsr);
+
+    // a cycle counter that doesn't count (e.g. qemu, which ignores
+    // the arm1176 c15 registers): keep the nominal value.
+    if(c1 == c0)
+        return cpu_cyc_per_usec_var;
+
+    // power-of-two window: rounded divide is a shift.
+    uint32_t half = CPU_FREQ_CAL_USEC / 2;
+    cpu_freq_set((c1 - c0 + half) >> CPU_FREQ_CAL_LOG2);
+    return cpu_cyc_per_usec_var;
+}
@@ -1,5 +1,6 @@
 #include "rpi.h"
 #include "cycle-count.h"
+#include "cpu-freq.h"
 #include "memmap.h"
 // #include "redzone.h"
 
@@ -67,6 +68,10 @@ void _cstart() {
     // i don't think any downside.
     cycle_cnt_init();
 
+    // measure the real clock rate so cycle-based timing is right
+    // even if the pi is overclocked (see <cpu-freq.h>).  ~256usec.
+    cpu_freq_calibrate();
+
     // hack to catch errors where they write to the first
     // 4k of memory.
     // redzone_init();
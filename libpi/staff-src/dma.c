@@ -0,0 +1,360 @@
+// bcm2835 dma driver: see <dma.h>
+#include "rpi.h"
+#include "rpi-inline-asm.h"
+#include "irq-dispatch.h"
+#include "dma.h"
+
+// bcm2835 p39--p48.
+enum {
+    DMA_BASE        = 0x20007000,
+    DMA_INT_STATUS  = DMA_BASE + 0xfe0,
+    DMA_ENABLE      = DMA_BASE + 0xff0,
+
+    // per-channel registers: DMA_BASE + ch * 0x100 + off.
+    DMA_CS          = 0x00,
+    DMA_CONBLK_AD   = 0x04,
+    DMA_DEBUG       = 0x20,
+
+    CS_ACTIVE       = 1 << 0,
+    CS_END          = 1 << 1,
+    CS_INT          = 1 << 2,
+    CS_ERROR        = 1 << 8,
+    CS_PRIORITY     = 8 << 16,
+    CS_PANIC_PRIORITY = 15 << 20,
+    CS_WAIT_WRITES  = 1 << 28,
+    CS_RESET        = 1u << 31,
+
+    // write 1 to clear.
+    DEBUG_ERRORS    = 0b111,
+
+    // channels 11..14 share one interrupt.
+    DMA_SHARED_IRQ  = IRQ_DMA0 + 11,
+
+    DMA_TIMEOUT_USEC = 1000*1000,
+
+    // the helpers: 128-bit reads and writes, 4-word bursts.
+    TI_COPY = DMA_TI_SRC_INC | DMA_TI_DEST_INC | DMA_TI_SRC_WIDTH
+            | DMA_TI_DEST_WIDTH | DMA_TI_WAIT_RESP | DMA_TI_BURST(4),
+    TI_FILL = DMA_TI_DEST_INC | DMA_TI_SRC_WIDTH | DMA_TI_DEST_WIDTH
+            | DMA_TI_WAIT_RESP | DMA_TI_BURST(4),
+};
+
+static inline uint32_t reg(unsigned ch, unsigned off) {
+    return DMA_BASE + ch * 0x100 + off;
+}
+static inline unsigned chan_irq(unsigned ch) {
+    return ch < 11 ? IRQ_DMA0 + ch : DMA_SHARED_IRQ;
+}
+
+static struct {
+    unsigned used_p:1;
+    dma_done_t done;
+    void *arg;
+    dma_stats_t st;
+} chans[DMA_NCHAN];
+
+// bit <i> = handler registered for IRQ_DMA0 + i.
+static uint32_t irq_on;
+
+/*****************************************************************
+ * cache maintenance: arm1176 trm 3-71, range operations take the
+ * (inclusive) addresses of the first and last lines.
+ */
+static int dcache_on(void) {
+    uint32_t r;
+    asm volatile("mrc p15, 0, %0, c1, c0, 0" : "=r"(r));
+    return (r >> 2) & 1;
+}
+static void dcache_clean_range(const void *p, unsigned n) {
+    if(!n || !dcache_on())
+        return;
+    uint32_t s = (uint32_t)p & ~31, e = ((uint32_t)p + n - 1) & ~31;
+    asm volatile("mcrr p15, 0, %0, %1, c12" :: "r"(e), "r"(s) : "memory");
+    asm volatile("mcr p15, 0, %0, c7, c10, 4" :: "r"(0) : "memory");
+}
+static void dcache_clean_inv_range(const void *p, unsigned n) {
+    if(!n || !dcache_on())
+        return;
+    uint32_t s = (uint32_t)p & ~31, e = ((uint32_t)p + n - 1) & ~31;
+    asm volatile("mcrr p15, 0, %0, %1, c14" :: "r"(e), "r"(s) : "memory");
+    asm volatile("mcr p15, 0, %0, c7, c10, 4" :: "r"(0) : "memory");
+}
+
+static const dma_cache_ops_t default_ops = {
+    .clean = dcache_clean_range,
+    .inv = dcache_clean_inv_range,
+};
+static const dma_cache_ops_t *ops = &default_ops;
+
+void dma_cache_ops_set(const dma_cache_ops_t *o) {
+    ops = o ? o : &default_ops;
+}
+void dma_cache_clean(const void *p, unsigned n) {
+    ops->clean(p, n);
+}
+void dma_cache_inv(const void *p, unsigned n) {
+    ops->inv(p, n);
+}
+
+/*****************************************************************
+ * channels.
+ */
+static void chan_reset(unsigned ch) {
+    dev_barrier();
+    PUT32(reg(ch, DMA_CS), CS_RESET);
+    PUT32(reg(ch, DMA_DEBUG), DEBUG_ERRORS);
+    dev_barrier();
+}
+
+int dma_chan_alloc(unsigned flags) {
+    unsigned n = flags & DMA_FULL ? DMA_NFULL : DMA_NCHAN;
+    for(unsigned ch = 0; ch < n; ch++) {
+        if(!(DMA_CHAN_MASK & (1 << ch)) || chans[ch].used_p)
+            continue;
+        memset(&chans[ch], 0, sizeof chans[ch]);
+        chans[ch].used_p = 1;
+
+        dev_barrier();
+        PUT32(DMA_ENABLE, GET32(DMA_ENABLE) | 1 << ch);
+        chan_reset(ch);
+        return ch;
+    }
+    return -1;
+}
+
+void dma_chan_free(unsigned ch) {
+    if(ch >= DMA_NCHAN || !chans[ch].used_p)
+        panic("freeing dma channel %d: not allocated\n", ch);
+    chan_reset(ch);
+    chans[ch].used_p = 0;
+}
+
+static void dma_irq(unsigned irq, void *arg) {
+    dev_barrier();
+    uint32_t pend = GET32(DMA_INT_STATUS);
+    for(unsigned ch = 0; ch < DMA_NCHAN; ch++) {
+        if(!(pend & (1 << ch)) || chan_irq(ch) != irq)
+            continue;
+        // clear INT but don't pause it if a new chain is running.
+        uint32_t cs = GET32(reg(ch, DMA_CS));
+        PUT32(reg(ch, DMA_CS), CS_INT | (cs & CS_ACTIVE));
+        dev_barrier();
+
+        chans[ch].st.nints++;
+        // <done> may start the next chain on <ch>.
+        dma_done_t done = chans[ch].done;
+        void *a = chans[ch].arg;
+        chans[ch].done = 0;
+        if(done)
+            done(ch, a);
+        dev_barrier();
+    }
+}
+
+void dma_cb_memcpy(dma_cb_t *cb, void *dst, const void *src, unsigned n) {
+    *cb = (dma_cb_t){
+        .ti = TI_COPY,
+        .src = dma_bus_addr(src),
+        .dst = dma_bus_addr(dst),
+        .len = n,
+    };
+}
+
+void dma_cb_fill(dma_cb_t *cb, void *dst, const uint32_t *pat, unsigned n) {
+    if((uint32_t)pat % 16)
+        panic("dma fill pattern %p: must be 16-byte aligned\n", pat);
+    *cb = (dma_cb_t){
+        .ti = TI_FILL,
+        .src = dma_bus_addr(pat),
+        .dst = dma_bus_addr(dst),
+        .len = n,
+    };
+}
+
+void dma_start(unsigned ch, dma_cb_t *cb, dma_done_t done, void *arg) {
+    if(ch >= DMA_NCHAN || !chans[ch].used_p)
+        panic("dma channel %d not allocated\n", ch);
+    if((uint32_t)cb % 32)
+        panic("dma cb %p: must be 32-byte aligned\n", cb);
+    if(dma_busy(ch))
+        panic("dma channel %d is busy\n", ch);
+
+    // interrupt on the last block (only), and write the chain out of
+    // the dcache so the engine sees it.
+    dma_cb_t *last = cb;
+    while(1) {
+        last->ti &= ~DMA_TI_INTEN;
+        if(!last->next)
+            break;
+        dma_cache_clean(last, sizeof *last);
+        last = dma_arm_addr(last->next);
+    }
+    if(done) {
+        last->ti |= DMA_TI_INTEN;
+        // first use of this irq: register here so there's no init
+        // order to get wrong.
+        unsigned irq = chan_irq(ch);
+        if(!(irq_on & (1 << (irq - IRQ_DMA0)))) {
+            irq_on |= 1 << (irq - IRQ_DMA0);
+            irq_register(irq, dma_irq, 0);
+        }
+    }
+    dma_cache_clean(last, sizeof *last);
+
+    chans[ch].done = done;
+    chans[ch].arg = arg;
+    chans[ch].st.nstart++;
+
+    dev_barrier();
+    PUT32(reg(ch, DMA_CS), CS_END | CS_INT);
+    PUT32(reg(ch, DMA_CONBLK_AD), dma_bus_addr(cb));
+    PUT32(reg(ch, DMA_CS),
+        CS_ACTIVE | CS_PRIORITY | CS_PANIC_PRIORITY | CS_WAIT_WRITES);
+    dev_barrier();
+}
+
+int dma_busy(unsigned ch) {
+    dev_barrier();
+    int busy = GET32(reg(ch, DMA_CS)) & CS_ACTIVE;
+    dev_barrier();
+    return busy;
+}
+
+int dma_wait(unsigned ch) {
+    uint32_t s = timer_get_usec();
+    while(dma_busy(ch))
+        if(timer_get_usec() - s > DMA_TIMEOUT_USEC)
+            panic("dma channel %d: still running after %dusec (cb=%x)\n",
+                ch, DMA_TIMEOUT_USEC, GET32(reg(ch, DMA_CONBLK_AD)));
+
+    dev_barrier();
+    uint32_t cs = GET32(reg(ch, DMA_CS));
+    uint32_t dbg = GET32(reg(ch, DMA_DEBUG));
+    int err = (cs & CS_ERROR) || (dbg & DEBUG_ERRORS);
+    if(err) {
+        PUT32(reg(ch, DMA_DEBUG), DEBUG_ERRORS);
+        chans[ch].st.nerr++;
+    }
+    dev_barrier();
+    return err ? -1 : 0;
+}
+
+void dma_abort(unsigned ch) {
+    chans[ch].done = 0;
+    chan_reset(ch);
+}
+
+dma_stats_t dma_stats(unsigned ch) {
+    return chans[ch].st;
+}
+
+/*****************************************************************
+ * blocking helpers.
+ */
+static int hch = -1;
+static dma_cb_t pool[DMA_CB_POOL];
+static uint32_t fill_pat[4] __attribute__((aligned(32)));
+
+void dma_init(void) {
+    if(hch >= 0)
+        return;
+    if((hch = dma_chan_alloc(DMA_FULL)) < 0)
+        panic("no free full dma channel\n");
+}
+
+static void run(dma_cb_t *cb) {
+    if(hch < 0)
+        panic("dma_init not called\n");
+    dma_start(hch, cb, 0, 0);
+    if(dma_wait(hch) < 0)
+        panic("dma error on channel %d\n", hch);
+}
+
+void dma_memcpy(void *dst, const void *src, unsigned n) {
+    if(!n)
+        return;
+    dma_cache_clean(src, n);
+    dma_cache_inv(dst, n);
+    dma_cb_memcpy(&pool[0], dst, src, n);
+    run(&pool[0]);
+}
+
+static void set_pat(uint32_t v) {
+    for(unsigned i = 0; i < 4; i++)
+        fill_pat[i] = v;
+    dma_cache_clean(fill_pat, sizeof fill_pat);
+}
+
+void dma_memset(void *dst, uint8_t c, unsigned n) {
+    uint8_t *p = dst;
+
+    // cpu does the bytes before and after the aligned middle.
+    while(n && (uint32_t)p % 4) {
+        *p++ = c;
+        n--;
+    }
+    unsigned mid = n & ~3;
+    for(unsigned i = mid; i < n; i++)
+        p[i] = c;
+    if(!mid)
+        return;
+
+    set_pat(c * 0x01010101);
+    dma_cache_inv(p, mid);
+    dma_cb_fill(&pool[0], p, fill_pat, mid);
+    run(&pool[0]);
+}
+
+void dma_blit(void *dst, unsigned dpitch, const void *src, unsigned spitch,
+              unsigned w, unsigned h) {
+    uint8_t *d = dst;
+    const uint8_t *s = src;
+
+    if(!w || !h)
+        return;
+    // no gaps between rows: one block.
+    if(dpitch == w && spitch == w) {
+        dma_memcpy(dst, src, w * h);
+        return;
+    }
+    while(h) {
+        unsigned n = h < DMA_CB_POOL ? h : DMA_CB_POOL;
+        for(unsigned i = 0; i < n; i++) {
+            dma_cache_clean(s, w);
+            dma_cache_inv(d, w);
+            dma_cb_memcpy(&pool[i], d, s, w);
+            dma_cb_chain(&pool[i], i + 1 < n ? &pool[i+1] : 0);
+            d += dpitch;
+            s += spitch;
+        }
+        run(&pool[0]);
+        h -= n;
+    }
+}
+
+void dma_fill2d(void *dst, unsigned dpitch, uint32_t v, unsigned w, unsigned h) {
+    if((uint32_t)dst % 4 || dpitch % 4 || w % 4)
+        panic("dma_fill2d: dst=%p, pitch=%d, w=%d must be multiples of 4\n",
+            dst, dpitch, w);
+    uint8_t *d = dst;
+    if(!w || !h)
+        return;
+
+    set_pat(v);
+    if(dpitch == w) {
+        w *= h;
+        dpitch = 0;
+        h = 1;
+    }
+    while(h) {
+        unsigned n = h < DMA_CB_POOL ? h : DMA_CB_POOL;
+        for(unsigned i = 0; i < n; i++) {
+            dma_cache_inv(d, w);
+            dma_cb_fill(&pool[i], d, fill_pat, w);
+            dma_cb_chain(&pool[i], i + 1 < n ? &pool[i+1] : 0);
+            d += dpitch;
+        }
+        run(&pool[0]);
+        h -= n;
+    }
+}
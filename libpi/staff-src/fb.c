@@ -0,0 +1,129 @@
+// double-buffered framebuffer: see <fb.h>
+#include "rpi.h"
+#include "mbox-prop.h"
+#include "fb.h"
+
+// gpu bus address -> arm physical.
+enum { BUS_MASK = 0x3fffffff };
+
+static fb_t fb;
+static mbox_prop_t m;
+
+static void fb_check(int ok, const char *what, uint32_t got, uint32_t want) {
+    if(!ok)
+        panic("fb_init: %s: asked for %d, firmware gave %d\n", what, want, got);
+}
+
+fb_t *fb_init(unsigned w, unsigned h, unsigned depth) {
+    if(depth != 16 && depth != 24 && depth != 32)
+        panic("fb_init: depth %d: must be 16, 24 or 32\n", depth);
+    if(!w || !h)
+        panic("fb_init: %dx%d\n", w, h);
+
+    // all at once: the firmware won't set the display up piecemeal.
+    mbox_prop_init(&m);
+    int phys = mbox_prop_set_phys_wh(&m, w, h);
+    int virt = mbox_prop_set_virt_wh(&m, w, 2*h);
+    int dep = mbox_prop_set_depth(&m, depth);
+    int order = mbox_prop_set_pixel_order(&m, 1);
+    mbox_prop_set_virt_offset(&m, 0, 0);
+    int alloc = mbox_prop_alloc_fb(&m, 16);
+    int pitch = mbox_prop_get_pitch(&m);
+    mbox_prop_send(&m);
+    mbox_prop_check(&m, "fb_init");
+
+    fb_check(mbox_prop_u32(&m, phys, 0) == w && mbox_prop_u32(&m, phys, 1) == h,
+        "physical width", mbox_prop_u32(&m, phys, 0), w);
+    fb_check(mbox_prop_u32(&m, virt, 0) == w && mbox_prop_u32(&m, virt, 1) == 2*h,
+        "virtual height", mbox_prop_u32(&m, virt, 1), 2*h);
+    fb_check(mbox_prop_u32(&m, dep, 0) == depth,
+        "depth", mbox_prop_u32(&m, dep, 0), depth);
+    if(!mbox_prop_u32(&m, alloc, 0))
+        panic("fb_init: firmware did not allocate a buffer\n");
+
+    memset(&fb, 0, sizeof fb);
+    fb.w = w;
+    fb.h = h;
+    fb.depth = depth;
+    fb.bytes_pp = depth / 8;
+    fb.rgb_p = mbox_prop_u32(&m, order, 0) == 1;
+    fb.vsync_p = 1;
+    fb.base = (void *)(mbox_prop_u32(&m, alloc, 0) & BUS_MASK);
+    fb.size = mbox_prop_u32(&m, alloc, 1);
+    fb.pitch = mbox_prop_u32(&m, pitch, 0);
+    if(fb.pitch < w * fb.bytes_pp || fb.pitch * 2 * h > fb.size)
+        panic("fb_init: pitch %d / size %d don't fit %dx%dx%d\n",
+            fb.pitch, fb.size, w, 2*h, depth);
+    fb.page[0] = fb.base;
+    fb.page[1] = fb.base + fb.pitch * h;
+    fb.front = 0;
+
+    memset(fb.base, 0, fb.pitch * 2 * h);
+    fb.last_flip = timer_get_usec();
+    return &fb;
+}
+
+void fb_flip(fb_t *f, unsigned vsync) {
+    unsigned back = !f->front;
+    vsync = vsync && f->vsync_p;
+
+    // processed in order: the offset is set, then we wait.
+    mbox_prop_init(&m);
+    int off = mbox_prop_set_virt_offset(&m, 0, back * f->h);
+    int vs = vsync ? mbox_prop_wait_vsync(&m) : -1;
+
+    uint32_t s = timer_get_usec();
+    mbox_prop_send(&m);
+    uint32_t e = timer_get_usec();
+    if(!mbox_prop_ok(&m, off) || mbox_prop_u32(&m, off, 1) != back * f->h)
+        panic("fb_flip: asked for y offset %d, got %d\n",
+            back * f->h, mbox_prop_u32(&m, off, 1));
+    if(vsync && !mbox_prop_ok(&m, vs)) {
+        output("fb: firmware ignored the vsync tag: flips may tear\n");
+        f->vsync_p = 0;
+    }
+    f->front = back;
+
+    f->nflip++;
+    f->flip_usec = e - s;
+    f->flip_tot_usec += f->flip_usec;
+    if(f->flip_usec > f->flip_max_usec)
+        f->flip_max_usec = f->flip_usec;
+    f->frame_usec = e - f->last_flip;
+    f->frame_tot_usec += f->frame_usec;
+    if(f->frame_usec > f->frame_max_usec)
+        f->frame_max_usec = f->frame_usec;
+    f->last_flip = e;
+}
+
+void fb_set_yoffset(fb_t *f, unsigned y) {
+    if(y > f->h)
+        panic("fb_set_yoffset: %d > %d\n", y, f->h);
+    mbox_prop_init(&m);
+    int off = mbox_prop_set_virt_offset(&m, 0, y);
+    mbox_prop_send(&m);
+    if(!mbox_prop_ok(&m, off) || mbox_prop_u32(&m, off, 1) != y)
+        panic("fb_set_yoffset: asked for %d, got %d\n",
+            y, mbox_prop_u32(&m, off, 1));
+}
+
+void fb_stats_print(fb_t *f) {
+    if(!f->nflip) {
+        output("fb: no flips\n");
+        return;
+    }
+    // totals, not averages: dividing by <nflip> is a runtime divide
+    // (no libgcc).  32-bit usec totals wrap after ~71 minutes.
+    output("fb: %dx%dx%d pitch=%d, %d flips: frames %dusec total max %dusec, flips %dusec total max %dusec%s\n",
+        f->w, f->h, f->depth, f->pitch, f->nflip,
+        (uint32_t)f->frame_tot_usec, f->frame_max_usec,
+        (uint32_t)f->flip_tot_usec, f->flip_max_usec,
+        f->vsync_p ? "" : " (no vsync)");
+}
+
+void fb_stats_reset(fb_t *f) {
+    f->nflip = 0;
+    f->frame_max_usec = f->flip_max_usec = 0;
+    f->frame_tot_usec = f->flip_tot_usec = 0;
+    f->last_flip = timer_get_usec();
+}
@@ -0,0 +1,220 @@
+// framebuffer text console: see <fbcons.h>
+#include "rpi.h"
+#include "dma.h"
+#include "fbcons.h"
+
+// glyph cell.  a power of two so cells from pixels is a shift, not
+// a divide (no libgcc).
+enum { GW = FONT8X8_W, GH = FONT8X8_H, GW_LOG2 = 3, GH_LOG2 = 3 };
+_Static_assert(GW == 1 << GW_LOG2 && GH == 1 << GH_LOG2,
+    "fbcons: glyph cell must be a power of two");
+
+static void init(fbcons_t *c, surface_t s, unsigned mode, unsigned h) {
+    if(((uintptr_t)s.p | s.pitch) % 4)
+        panic("fbcons: surface %p / pitch %d not word aligned\n", s.p, s.pitch);
+    memset(c, 0, sizeof *c);
+    c->s = s;
+    c->mode = mode;
+    c->cols = s.w >> GW_LOG2;
+    c->rows = h >> GH_LOG2;
+    if(!c->cols || !c->rows)
+        panic("fbcons: %dx%d is too small\n", s.w, h);
+    // 8 pixels of 2, 3 or 4 bytes.
+    c->rw = 2 * s.bytes_pp;
+    if(mode == FBCONS_SCROLL_DMA)
+        dma_init();
+    fbcons_color(c, surface_rgb(&s, 255, 255, 255), 0);
+    fbcons_clear(c);
+}
+
+void fbcons_init(fbcons_t *c, surface_t s, unsigned mode) {
+    if(mode == FBCONS_SCROLL_PAN)
+        panic("fbcons: panning needs the framebuffer: use fbcons_init_fb\n");
+    init(c, s, mode, s.h);
+}
+
+void fbcons_init_fb(fbcons_t *c, fb_t *fb) {
+    surface_t s = surface_mk(fb->base, fb->w, 2 * fb->h, fb->pitch, fb->depth);
+    init(c, s, FBCONS_SCROLL_PAN, fb->h);
+    c->fb = fb;
+    fb_set_yoffset(fb, 0);
+}
+
+void fbcons_color(fbcons_t *c, uint32_t fg, uint32_t bg) {
+    fbcons_colors_t *k, *lru = &c->colors[0];
+    for(k = c->colors; k < &c->colors[FBCONS_NCOLORS]; k++) {
+        if(k->used_p && k->fg == fg && k->bg == bg)
+            goto found;
+        if(!k->used_p || (lru->used_p && k->stamp < lru->stamp))
+            lru = k;
+    }
+    k = lru;
+    k->fg = fg;
+    k->bg = bg;
+    k->used_p = 1;
+    memset(k->valid, 0, sizeof k->valid);
+found:
+    k->stamp = ++c->stamp;
+    c->cur = k;
+}
+
+// glyph <g> in the current colors, expanding it on first use.
+static const uint32_t *glyph(fbcons_t *c, unsigned g) {
+    fbcons_colors_t *k = c->cur;
+    if(!(k->valid[g / 32] & (1u << (g % 32)))) {
+        surface_t t = surface_mk(k->px[g], GW, GH, sizeof k->px[g][0], c->s.depth);
+        for(unsigned y = 0; y < GH; y++)
+            for(unsigned x = 0; x < GW; x++)
+                surface_put_raw(&t, x, y, (font8x8[g][y] >> x) & 1 ? k->fg : k->bg);
+        k->valid[g / 32] |= 1u << (g % 32);
+        c->nexpand++;
+    }
+    return k->px[g][0];
+}
+
+// <rw> is a constant at each call: the row copy unrolls to ldm/stm.
+static inline __attribute__((always_inline)) void
+blit_glyph(uint8_t *dst, unsigned pitch, const uint32_t *src, unsigned rw) {
+    for(unsigned y = 0; y < GH; y++, dst += pitch, src += 8) {
+        uint32_t *d = (void *)dst;
+        for(unsigned i = 0; i < rw; i++)
+            d[i] = src[i];
+    }
+}
+
+static void draw(fbcons_t *c, int ch, unsigned col, unsigned row) {
+    if(ch < FONT8X8_FIRST || ch >= FONT8X8_FIRST + FONT8X8_N)
+        ch = '?';
+    const uint32_t *g = glyph(c, ch - FONT8X8_FIRST);
+    uint8_t *dst = surface_row(&c->s, c->top + row * GH) + col * c->rw * 4;
+    switch(c->rw) {
+    case 8: blit_glyph(dst, c->s.pitch, g, 8); break;
+    case 6: blit_glyph(dst, c->s.pitch, g, 6); break;
+    default: blit_glyph(dst, c->s.pitch, g, 4); break;
+    }
+    c->nchars++;
+}
+
+// clear <h> pixel rows of <s> from <y>, the full text width.
+static void clear_rows(fbcons_t *c, unsigned y, unsigned h) {
+    unsigned w = c->cols * GW;
+    uint32_t bg = c->cur->bg;
+    if(c->mode == FBCONS_SCROLL_DMA && c->s.bytes_pp == 4)
+        dma_fill2d(surface_row(&c->s, y), c->s.pitch, bg, w * 4, h);
+    else
+        surf_fill_rect(&c->s, 0, y, w, h, bg);
+}
+
+// move <n> pixel rows at <sy> up to <dy>.
+static void move_up(fbcons_t *c, unsigned dy, unsigned sy, unsigned n) {
+    if(c->mode == FBCONS_SCROLL_DMA)
+        dma_blit(surface_row(&c->s, dy), c->s.pitch,
+                 surface_row(&c->s, sy), c->s.pitch,
+                 c->cols * GW * c->s.bytes_pp, n);
+    else
+        surf_blit(&c->s, 0, dy, &c->s, 0, sy, c->cols * GW, n);
+}
+
+static void scroll(fbcons_t *c) {
+    unsigned last = (c->rows - 1) * GH;
+    c->nscroll++;
+
+    if(c->mode != FBCONS_SCROLL_PAN) {
+        move_up(c, 0, GH, last);
+        clear_rows(c, last, GH);
+        return;
+    }
+
+    // pan: slide down a line; at the bottom, copy the window's lines
+    // (less the one scrolling off) back to the top.
+    unsigned h = c->fb->h;
+    if(c->top + h + GH <= c->s.h)
+        c->top += GH;
+    else {
+        move_up(c, 0, c->top + GH, last);
+        c->top = 0;
+        c->nrebase++;
+    }
+    // the new line and any leftover pixel rows under it.
+    clear_rows(c, c->top + last, h - last);
+    fb_set_yoffset(c->fb, c->top);
+}
+
+static void newline(fbcons_t *c) {
+    c->col = 0;
+    if(c->row + 1 < c->rows)
+        c->row++;
+    else
+        scroll(c);
+}
+
+void fbcons_putc(fbcons_t *c, int ch) {
+    switch(ch) {
+    case '\n': newline(c); return;
+    case '\r': c->col = 0; return;
+    case '\b': if(c->col) c->col--; return;
+    case '\t':
+        do {
+            fbcons_putc(c, ' ');
+        } while(c->col % 8);
+        return;
+    }
+    if(c->col >= c->cols)
+        newline(c);
+    draw(c, ch, c->col++, c->row);
+}
+
+void fbcons_puts(fbcons_t *c, const char *s) {
+    while(*s)
+        fbcons_putc(c, *s++);
+}
+
+void fbcons_clear(fbcons_t *c) {
+    c->top = 0;
+    c->col = c->row = 0;
+    surf_fill_rect(&c->s, 0, 0, c->s.w, c->s.h, c->cur->bg);
+    if(c->fb)
+        fb_set_yoffset(c->fb, 0);
+}
+
+/*****************************************************************
+ * printk hookup.
+ */
+static fbcons_t *cons;
+static rpi_putchar_t old_putchar;
+static int mirror_p, busy;
+
+int fbcons_putchar(int ch) {
+    // a panic from inside the console only goes to the old one.
+    if(mirror_p || busy)
+        old_putchar(ch);
+    if(!busy) {
+        busy = 1;
+        fbcons_putc(cons, ch);
+        busy = 0;
+    }
+    return ch;
+}
+
+void fbcons_install(fbcons_t *c, int mirror) {
+    cons = c;
+    mirror_p = mirror;
+    rpi_putchar_t old = rpi_putchar_set(fbcons_putchar);
+    if(old != fbcons_putchar)
+        old_putchar = old;
+}
+
+void fbcons_uninstall(void) {
+    if(old_putchar)
+        rpi_putchar_set(old_putchar);
+    cons = 0;
+}
+
+void fbcons_stats_print(fbcons_t *c) {
+    static const char *mode[] = { "cpu", "dma", "pan" };
+    output("fbcons: %dx%d cells, %d chars, %d glyphs expanded, %d lines scrolled (%s",
+        c->cols, c->rows, c->nchars, c->nexpand, c->nscroll, mode[c->mode]);
+    if(c->mode == FBCONS_SCROLL_PAN)
+        output(", %d screen copies", c->nrebase);
+    output(")\n");
+}
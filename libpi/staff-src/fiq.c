@@ -0,0 +1,56 @@
+// FIQ routing and handler installation: see <fiq.h>
+#include "rpi.h"
+#include "fiq.h"
+#include "vector-base.h"
+#include "irq-dispatch.h"
+
+extern uint32_t fiq_vec[];
+extern uint8_t fiq_vec_slot[];
+
+void fiq_route(unsigned src) {
+    // p116: bit 7 = enable, bits 0..6 = source.
+    if(src >= 72)
+        panic("illegal FIQ source=%d\n", src);
+
+    // don't also deliver it as an IRQ.
+    irq_disable(src);
+    dev_barrier();
+    PUT32(IRQ_FIQ_control, (1 << 7) | src);
+    dev_barrier();
+}
+
+void fiq_unroute(void) {
+    dev_barrier();
+    PUT32(IRQ_FIQ_control, 0);
+    dev_barrier();
+}
+
+void fiq_install_asm(const void *start, const void *end) {
+    unsigned n = (const uint8_t *)end - (const uint8_t *)start;
+    if(!n || n > FIQ_MAX_CODE)
+        panic("FIQ handler is %d bytes: must be in (0,%d]\n", n, FIQ_MAX_CODE);
+
+    // don't take a FIQ into a half-copied handler.
+    uint32_t cpsr = fiq_disable();
+    memcpy(fiq_vec_slot, start, n);
+
+    // we just wrote code as data: push it out of the dcache
+    // and make sure the icache and btb don't have the old slot.
+    cache_flush_all();
+    vector_base_reset(fiq_vec);
+    cpsr_set(cpsr);
+}
+
+void fiq_install_c(fiq_handler_t h, void *ctx) {
+    extern uint8_t fiq_c_tramp[], fiq_c_tramp_end[];
+
+    fiq_regs_t r = {
+        .r8 = (uint32_t)ctx,
+        .r9 = (uint32_t)h,
+        .sp = FIQ_STACK_ADDR,
+    };
+    uint32_t cpsr = fiq_disable();
+    fiq_regs_set(&r);
+    fiq_install_asm(fiq_c_tramp, fiq_c_tramp_end);
+    cpsr_set(cpsr);
+}
@@ -0,0 +1,86 @@
+// parallel GPIO bus and waveform replay: see <gpio-bus.h>
+#include "rpi.h"
+#include "rpi-inline-asm.h"
+#include "cycle-count.h"
+#include "gpio-bus.h"
+
+void gpio_bus_init(gpio_bus_t *b, const unsigned *pins, unsigned n) {
+    if(!n || n > 32)
+        panic("bus width %d: must be 1..32\n", n);
+
+    memset(b, 0, sizeof *b);
+    b->n = n;
+    b->contig_p = 1;
+    b->shift = pins[0];
+    for(unsigned i = 0; i < n; i++) {
+        unsigned p = pins[i];
+        if(p >= 32)
+            panic("bus pin %d: must be in bank 0 (0..31)\n", p);
+        if(b->mask & (1u << p))
+            panic("bus pin %d used twice\n", p);
+        b->pins[i] = p;
+        b->mask |= 1u << p;
+        if(p != pins[0] + i)
+            b->contig_p = 0;
+    }
+    if(b->contig_p)
+        return;
+
+    // each table entry is the or of the pins for the set bits.
+    for(unsigned k = 0; k < 4; k++) {
+        for(unsigned x = 0; x < 256; x++) {
+            uint32_t g = 0, v = 0;
+            for(unsigned j = 0; j < 8; j++) {
+                if(!(x & (1u << j)))
+                    continue;
+                unsigned bit = k*8 + j;
+                if(bit < n)
+                    g |= 1u << b->pins[bit];
+                // gpio bit <bit> -> bus bit <i> if pins[i] == bit.
+                for(unsigned i = 0; i < n; i++)
+                    if(b->pins[i] == bit)
+                        v |= 1u << i;
+            }
+            b->to_gpio[k][x] = g;
+            b->from_gpio[k][x] = v;
+        }
+    }
+}
+
+void gpio_bus_output(const gpio_bus_t *b) {
+    for(unsigned i = 0; i < b->n; i++)
+        gpio_set_output(b->pins[i]);
+}
+void gpio_bus_input(const gpio_bus_t *b) {
+    for(unsigned i = 0; i < b->n; i++)
+        gpio_set_input(b->pins[i]);
+}
+
+void gpio_wave_compile(const gpio_bus_t *b, gpio_wave_t *w,
+                       const uint32_t *vals, unsigned n) {
+    for(unsigned i = 0; i < n; i++) {
+        uint32_t g = gpio_bus_to_gpio(b, vals[i]);
+        w[i] = (gpio_wave_t){ .set = g, .clr = ~g & b->mask };
+    }
+}
+
+uint32_t gpio_wave_play(const gpio_wave_t *w, unsigned n, uint32_t period) {
+    volatile uint32_t *set = (void *)GPIO_SET0;
+    volatile uint32_t *clr = (void *)GPIO_CLR0;
+    uint32_t late = 0;
+
+    uint32_t cpsr = cpsr_int_disable();
+    dev_barrier();
+    uint32_t start = cycle_cnt_read(), t = 0, c;
+    for(unsigned i = 0; i < n; i++, t += period) {
+        while((c = cycle_cnt_read() - start) < t)
+            ;
+        *set = w[i].set;
+        *clr = w[i].clr;
+        if(c - t > late)
+            late = c - t;
+    }
+    dev_barrier();
+    cpsr_int_reset(cpsr);
+    return late;
+}
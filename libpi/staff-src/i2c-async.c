@@ -0,0 +1,274 @@
+// queued interrupt-driven i2c master: see <i2c-async.h>
+#include "rpi.h"
+#include "rpi-inline-asm.h"
+#include "cycle-count.h"
+#include "irq-dispatch.h"
+#include "i2c-async.h"
+
+// bsc1: bcm2835 p28--p37.
+enum {
+    BSC_BASE    = 0x20804000,
+    BSC_C       = BSC_BASE + 0x00,
+    BSC_S       = BSC_BASE + 0x04,
+    BSC_DLEN    = BSC_BASE + 0x08,
+    BSC_A       = BSC_BASE + 0x0c,
+    BSC_FIFO    = BSC_BASE + 0x10,
+    BSC_DIV     = BSC_BASE + 0x14,
+
+    C_READ      = 1 << 0,
+    C_CLEAR     = 3 << 4,
+    C_ST        = 1 << 7,
+    C_INTD      = 1 << 8,
+    C_INTT      = 1 << 9,
+    C_INTR      = 1 << 10,
+    C_I2CEN     = 1 << 15,
+
+    S_TA        = 1 << 0,
+    S_DONE      = 1 << 1,
+    S_TXD       = 1 << 4,
+    S_RXD       = 1 << 5,
+    S_ERR       = 1 << 8,
+    S_CLKT      = 1 << 9,
+    // write 1 to clear.
+    S_CLEAR     = S_DONE | S_ERR | S_CLKT,
+
+    SDA_PIN     = 2,
+    SCL_PIN     = 3,
+
+    // combined transactions: polls of S waiting for the write to
+    // start (TA) before we queue the read.
+    TA_SPIN     = 10000,
+};
+
+// running transaction is <head>; the rest follow <next>.
+static i2c_xfer_t *volatile head;
+static i2c_xfer_t *tail;
+static unsigned pos;            // bytes done in the current phase.
+
+static i2c_async_stats_t st;
+
+static void start(i2c_xfer_t *x);
+
+static void bsc_reset(void) {
+    PUT32(BSC_C, C_I2CEN | C_CLEAR);
+    PUT32(BSC_S, S_CLEAR);
+}
+
+// <head> is finished with <status>: start the next one, then tell
+// the caller.
+static void finish(int status) {
+    i2c_xfer_t *x = head;
+
+    dev_barrier();
+    bsc_reset();
+    dev_barrier();
+
+    x->usec = timer_get_usec() - x->start_usec;
+    st.nxfer++;
+    st.nbytes += x->nwritten + x->nread;
+    if(status == I2C_ERR_NACK)
+        st.nnack++;
+    else if(status == I2C_ERR_CLKT)
+        st.nclkt++;
+    else if(status == I2C_ERR_TIMEOUT)
+        st.ntimeout++;
+
+    if(!(head = x->next))
+        tail = 0;
+    else
+        start(head);
+
+    i2c_done_t done = x->done;
+    void *arg = x->arg;
+    x->status = status;
+    if(done)
+        done(x, arg);
+}
+
+static void start_read(i2c_xfer_t *x, uint32_t st_bit) {
+    x->reading_p = 1;
+    pos = 0;
+    PUT32(BSC_DLEN, x->nrd);
+    PUT32(BSC_C, C_I2CEN | st_bit | C_READ | C_INTR | C_INTD);
+}
+
+static void start(i2c_xfer_t *x) {
+    x->start_usec = timer_get_usec();
+    x->reading_p = 0;
+    pos = 0;
+
+    dev_barrier();
+    bsc_reset();
+    PUT32(BSC_A, x->addr);
+
+    if(!x->nwr) {
+        start_read(x, C_ST);
+        dev_barrier();
+        return;
+    }
+
+    PUT32(BSC_DLEN, x->nwr);
+    while(pos < x->nwr && pos < I2C_ASYNC_FIFO)
+        PUT32(BSC_FIFO, x->wr[pos++]);
+    x->nwritten = pos;
+
+    if(!x->nrd) {
+        PUT32(BSC_C, C_I2CEN | C_ST | C_INTD | (pos < x->nwr ? C_INTT : 0));
+        dev_barrier();
+        return;
+    }
+
+    // combined: start the write, and once it's active queue the read
+    // so the controller does a repeated start instead of a stop.
+    PUT32(BSC_C, C_I2CEN | C_ST);
+    uint32_t s = 0;
+    for(unsigned i = 0; i < TA_SPIN; i++)
+        if((s = GET32(BSC_S)) & (S_TA | S_DONE))
+            break;
+    // address nacked: let the interrupt report it.  (if the write
+    // already finished the read just gets a stop + start.)
+    if(s & (S_ERR | S_CLKT))
+        PUT32(BSC_C, C_I2CEN | C_INTD);
+    else
+        start_read(x, C_ST);
+    dev_barrier();
+}
+
+static void bsc_irq(unsigned irq, void *arg) {
+    uint32_t c0 = cycle_cnt_read();
+    st.nints++;
+
+    dev_barrier();
+    i2c_xfer_t *x = head;
+    uint32_t s = GET32(BSC_S);
+    if(!x) {
+        bsc_reset();
+        PUT32(BSC_C, 0);
+        dev_barrier();
+        return;
+    }
+
+    if(s & (S_ERR | S_CLKT)) {
+        finish(s & S_ERR ? I2C_ERR_NACK : I2C_ERR_CLKT);
+    } else if(!x->reading_p) {
+        while(x->nwritten < x->nwr && (GET32(BSC_S) & S_TXD))
+            PUT32(BSC_FIFO, x->wr[x->nwritten++]);
+        // all in the fifo: stop the TXW interrupts.
+        if(x->nwritten == x->nwr)
+            PUT32(BSC_C, C_I2CEN | C_INTD);
+        if(s & S_DONE)
+            finish(I2C_OK);
+    } else {
+        // drain, then check DONE: the fifo may still hold the end.
+        while(pos < x->nrd && (GET32(BSC_S) & S_RXD))
+            x->rd[pos++] = GET32(BSC_FIFO);
+        x->nread = pos;
+        if(s & S_DONE)
+            finish(I2C_OK);
+    }
+    dev_barrier();
+
+    // a stuck transaction is also caught here if anything else on
+    // the bus interrupts.
+    i2c_async_poll();
+    st.irq_cyc += cycle_cnt_read() - c0;
+}
+
+void i2c_async_init(unsigned div) {
+    if(div < 2 || div > 0xfffe)
+        panic("i2c: clock divider %d out of range\n", div);
+    if(head)
+        panic("i2c_async_init: transactions still queued\n");
+
+    gpio_set_function(SDA_PIN, GPIO_FUNC_ALT0);
+    gpio_set_function(SCL_PIN, GPIO_FUNC_ALT0);
+
+    dev_barrier();
+    PUT32(BSC_C, 0);
+    PUT32(BSC_DIV, div);
+    bsc_reset();
+    dev_barrier();
+
+    irq_register(IRQ_I2C, bsc_irq, 0);
+}
+
+void i2c_submit(i2c_xfer_t *x, i2c_done_t done, void *arg) {
+    if(!x->nwr && !x->nrd)
+        panic("i2c_submit: empty transaction\n");
+    if(x->nwr > I2C_ASYNC_MAX || x->nrd > I2C_ASYNC_MAX)
+        panic("i2c_submit: %d/%d bytes: max is %d\n", x->nwr, x->nrd, I2C_ASYNC_MAX);
+    if(x->nwr > I2C_ASYNC_FIFO && x->nrd)
+        panic("i2c_submit: write-then-read: write is %d bytes, max %d\n",
+            x->nwr, I2C_ASYNC_FIFO);
+    if(x->addr > 0x7f)
+        panic("i2c_submit: address %x is not 7-bit\n", x->addr);
+
+    x->done = done;
+    x->arg = arg;
+    x->next = 0;
+    x->nwritten = x->nread = 0;
+    x->status = I2C_PENDING;
+
+    uint32_t cpsr = cpsr_int_disable();
+    if(x == head || x == tail)
+        panic("i2c_submit: transaction %p already queued\n", x);
+    if(!head) {
+        head = tail = x;
+        start(x);
+    } else {
+        tail->next = x;
+        tail = x;
+    }
+    cpsr_int_reset(cpsr);
+}
+
+void i2c_async_poll(void) {
+    uint32_t cpsr = cpsr_int_disable();
+    i2c_xfer_t *x = head;
+    if(x && x->timeout_usec
+    && timer_get_usec() - x->start_usec > x->timeout_usec)
+        finish(I2C_ERR_TIMEOUT);
+    cpsr_int_reset(cpsr);
+}
+
+int i2c_xfer_wait(i2c_xfer_t *x) {
+    if(!cpsr_int_enabled())
+        panic("i2c_xfer_wait: interrupts are off\n");
+    while(!i2c_xfer_done_p(x))
+        i2c_async_poll();
+    return x->status;
+}
+
+unsigned i2c_async_pending(void) {
+    unsigned n = 0;
+    uint32_t cpsr = cpsr_int_disable();
+    for(i2c_xfer_t *x = head; x; x = x->next)
+        n++;
+    cpsr_int_reset(cpsr);
+    return n;
+}
+
+const char *i2c_status_str(int status) {
+    switch(status) {
+    case I2C_OK:            return "ok";
+    case I2C_PENDING:       return "pending";
+    case I2C_ERR_NACK:      return "nack";
+    case I2C_ERR_CLKT:      return "clock-stretch timeout";
+    case I2C_ERR_TIMEOUT:   return "timeout";
+    default:                return "bad status";
+    }
+}
+
+i2c_async_stats_t i2c_async_stats(void) {
+    uint32_t cpsr = cpsr_int_disable();
+    i2c_async_stats_t s = st;
+    cpsr_int_reset(cpsr);
+    return s;
+}
+
+void i2c_async_stats_print(const char *msg) {
+    i2c_async_stats_t s = i2c_async_stats();
+    output("%s: %d transactions (%d nack, %d clkt, %d timeout), %d bytes, %d interrupts, %d cycles in handler\n",
+        msg, s.nxfer, s.nnack, s.nclkt, s.ntimeout, s.nbytes, s.nints,
+        (uint32_t)s.irq_cyc);
+}
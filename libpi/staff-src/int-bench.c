@@ -0,0 +1,215 @@
+// GPIO interrupt latency + throughput benchmark: see <int-bench.h>
+#include "rpi.h"
+#include "cycle-count.h"
+#include "int-bench.h"
+
+volatile uint32_t int_bench_nedges;
+
+// max latency pairs we keep samples for.
+enum { MAX_TRIALS = 4096, NBINS = 16, BAR_MAX = 50 };
+static uint32_t samples[2*MAX_TRIALS];
+
+// toggle periods in cycles for the throughput test, slowest first.
+static const uint32_t periods[] = {
+    7000, 3500, 1750, 1400, 1000, 700, 500, 350, 250, 175, 140, 100, 70
+};
+enum { NPERIODS = sizeof periods / sizeof periods[0] };
+
+// after the last toggle, how long to wait for stragglers.
+enum { SETTLE_CYCLES = 20000 };
+
+int_bench_cfg_t int_bench_cfg_mk(unsigned out_pin, unsigned in_pin) {
+    return (int_bench_cfg_t) {
+        .out_pin = out_pin,
+        .in_pin = in_pin,
+        .ntrials = 2000,
+        .ntoggles = 2000,
+        .verbose_p = 1,
+    };
+}
+
+// shellsort: n is a few thousand and we don't have qsort.
+static void sort_u32(uint32_t *a, unsigned n) {
+    unsigned gap = 1;
+    while(gap < n/3)
+        gap = 3*gap + 1;
+    for(; gap > 0; gap /= 3) {
+        for(unsigned i = gap; i < n; i++) {
+            uint32_t x = a[i];
+            unsigned j = i;
+            for(; j >= gap && a[j-gap] > x; j -= gap)
+                a[j] = a[j-gap];
+            a[j] = x;
+        }
+    }
+}
+
+// cycles from writing <v> until the handler counts the edge.
+static inline uint32_t edge(unsigned pin, unsigned v) {
+    uint32_t n = int_bench_nedges;
+    uint32_t s = cycle_cnt_read();
+    gpio_write(pin, v);
+    while(int_bench_nedges == n)
+        ;
+    return cycle_cnt_read() - s;
+}
+
+// linear buckets from min to p99; everything above p99 goes in
+// the last one so a few outliers don't squash the plot.  bucket
+// width and bar scale are powers of two so this only shifts (no
+// runtime divides: there's no libgcc).
+static void histogram(const uint32_t *a, unsigned n, uint32_t lo, uint32_t hi) {
+    unsigned bins[NBINS+1] = {0};
+    unsigned wshift = 0;
+    while(((hi - lo) >> wshift) >= NBINS)
+        wshift++;
+    uint32_t w = 1 << wshift;
+
+    for(unsigned i = 0; i < n; i++) {
+        unsigned b = (a[i] - lo) >> wshift;
+        bins[b < NBINS ? b : NBINS]++;
+    }
+
+    unsigned most = 0;
+    for(unsigned i = 0; i <= NBINS; i++)
+        if(bins[i] > most)
+            most = bins[i];
+    // longest bar is in (BAR_MAX/2, BAR_MAX].
+    unsigned bshift = 0;
+    while((most >> bshift) > BAR_MAX)
+        bshift++;
+
+    for(unsigned i = 0; i <= NBINS; i++) {
+        if(i < NBINS)
+            output("  [%d,%d)\t%d\t", lo + i*w, lo + (i+1)*w, bins[i]);
+        else if(bins[i])
+            output("  >=%d\t\t%d\t", lo + i*w, bins[i]);
+        else
+            break;
+        unsigned len = bins[i] >> bshift;
+        if(bins[i] && !len)
+            len = 1;
+        for(unsigned j = 0; j < len; j++)
+            output("#");
+        output("\n");
+    }
+}
+
+static void latency(const int_bench_cfg_t *c, int_bench_result_t *r) {
+    unsigned n = c->ntrials;
+    if(n > MAX_TRIALS)
+        panic("ntrials=%d: max is %d\n", n, MAX_TRIALS);
+    if(gpio_read(c->in_pin) != 0)
+        panic("in_pin=%d should start low\n", c->in_pin);
+
+    uint32_t sum = 0;
+    for(unsigned i = 0; i < n; i++) {
+        samples[2*i]   = edge(c->out_pin, 1);
+        samples[2*i+1] = edge(c->out_pin, 0);
+        sum += samples[2*i] + samples[2*i+1];
+    }
+    n *= 2;
+    sort_u32(samples, n);
+
+    r->min = samples[0];
+    r->median = samples[n/2];
+    r->p99 = samples[n*99/100];
+    r->max = samples[n-1];
+    r->sum = sum;
+    r->nedges = n;
+
+    output("%s latency over %d edges: min=%d median=%d p99=%d max=%d sum=%d cycles\n",
+        r->name, n, r->min, r->median, r->p99, r->max, r->sum);
+    if(c->verbose_p)
+        histogram(samples, n, r->min, r->p99);
+}
+
+// toggle <out_pin> <n> times, one edge every <period> cycles.
+// deadlines are absolute so time stolen by the handler doesn't
+// stretch the schedule (unless it takes longer than <period>).
+// returns the edges lost; <*elapsed> = cycles actually taken.
+static unsigned toggle(const int_bench_cfg_t *c, uint32_t period, uint32_t *elapsed) {
+    unsigned n = c->ntoggles & ~1;
+    unsigned pin = c->out_pin;
+
+    uint32_t before = int_bench_nedges;
+    uint32_t s = cycle_cnt_read(), t = 0;
+    for(unsigned i = 0; i < n; i++) {
+        gpio_write(pin, ~i & 1);
+        t += period;
+        while(cycle_cnt_read() - s < t)
+            ;
+    }
+    *elapsed = cycle_cnt_read() - s;
+
+    // let the last edges land.
+    uint32_t w = cycle_cnt_read();
+    while(cycle_cnt_read() - w < SETTLE_CYCLES)
+        ;
+
+    unsigned got = int_bench_nedges - before;
+    if(got > n)
+        panic("saw %d edges but only toggled %d: spurious interrupts?\n", got, n);
+    return n - got;
+}
+
+static void throughput(const int_bench_cfg_t *c, int_bench_result_t *r) {
+    unsigned n = c->ntoggles & ~1;
+    if(!n)
+        panic("ntoggles must be at least 2\n");
+
+    // raw cycles for all <n> edges: what we achieved can be slower
+    // than what we asked for.  per-edge and edges/sec are divides,
+    // left to whoever reads the output.
+    if(c->verbose_p)
+        output("  period(cyc)\telapsed(cyc)\tlost\n");
+    r->lossless_period = 0;
+    r->lossless_elapsed = 0;
+    for(unsigned i = 0; i < NPERIODS; i++) {
+        uint32_t elapsed;
+        unsigned lost = toggle(c, periods[i], &elapsed);
+
+        if(c->verbose_p)
+            output("  %d\t\t%d\t\t%d\n", periods[i], elapsed, lost);
+        if(!lost) {
+            r->lossless_period = periods[i];
+            r->lossless_elapsed = elapsed;
+        }
+        r->lost_at_max = lost;
+    }
+    output("%s throughput: lossless down to %d cycles/edge (%d edges took %d cycles), lost %d of %d at the fastest rate\n",
+        r->name, r->lossless_period, n, r->lossless_elapsed, r->lost_at_max, n);
+}
+
+int_bench_result_t int_bench_run(const int_bench_cfg_t *c, const int_bench_variant_t *v) {
+    int_bench_result_t r = { .name = v->name };
+
+    gpio_set_output(c->out_pin);
+    gpio_set_input(c->in_pin);
+    gpio_write(c->out_pin, 0);
+
+    int_bench_nedges = 0;
+    v->setup(c->in_pin);
+    latency(c, &r);
+    throughput(c, &r);
+    v->teardown(c->in_pin);
+    return r;
+}
+
+void int_bench_compare(const int_bench_cfg_t *c, const int_bench_variant_t *v, unsigned n) {
+    enum { MAXV = 16 };
+    int_bench_result_t r[MAXV];
+    if(n > MAXV)
+        panic("too many variants: %d, max=%d\n", n, MAXV);
+
+    for(unsigned i = 0; i < n; i++) {
+        output("---------------------------------------------------\n");
+        r[i] = int_bench_run(c, &v[i]);
+    }
+
+    output("---------------------------------------------------\n");
+    output("variant\t\t\tmin\tmedian\tp99\tmax\tlossless(cyc/edge)\n");
+    for(unsigned i = 0; i < n; i++)
+        output("%s\t\t%d\t%d\t%d\t%d\t%d\n", r[i].name,
+            r[i].min, r[i].median, r[i].p99, r[i].max, r[i].lossless_period);
+}
@@ -0,0 +1,156 @@
+// vectored IRQ dispatch: see <irq-dispatch.h>
+#include "rpi.h"
+#include "rpi-inline-asm.h"
+#include "irq-dispatch.h"
+#include "vector-base.h"
+
+// bits in <IRQ_basic_pending> (p113-114):
+//   8: something pending in <IRQ_pending_1>
+//   9: something pending in <IRQ_pending_2>
+//  10-14: shortcut for GPU irqs 7,9,10,18,19 (pending 1)
+//  15-20: shortcut for GPU irqs 53,54,55,56,57,62 (pending 2)
+// the shortcut irqs do not necessarily set bit 8/9, so check both.
+enum {
+    BASIC_ARM_MASK  = 0xff,
+    BASIC_PEND1     = (1 << 8) | (0b11111 << 10),
+    BASIC_PEND2     = (1 << 9) | (0b111111 << 15),
+};
+
+typedef struct {
+    irq_handler_t h;
+    void *arg;
+} irq_ent_t;
+
+static irq_ent_t handlers[IRQ_NUM];
+static unsigned counts[IRQ_NUM];
+static unsigned nspurious;
+
+// which sources we enabled: [0] = pending 1, [1] = pending 2,
+// [2] = basic.  we mask the pending registers with these.
+static uint32_t enabled[3];
+
+static void irq_chk(unsigned irq) {
+    if(irq >= IRQ_NUM)
+        panic("illegal irq=%d\n", irq);
+}
+
+// default: an enabled source with no handler.  disable it so we
+// don't take the same interrupt forever.
+static void irq_unhandled(unsigned irq, void *arg) {
+    nspurious++;
+    irq_disable(irq);
+}
+
+static void irq_ctrl(unsigned irq, uint32_t base_1, uint32_t base_2,
+    uint32_t base_basic) {
+    dev_barrier();
+    if(irq < 32)
+        PUT32(base_1, 1 << irq);
+    else if(irq < 64)
+        PUT32(base_2, 1 << (irq - 32));
+    else
+        PUT32(base_basic, 1 << (irq - IRQ_BASIC));
+    dev_barrier();
+}
+
+void irq_enable(unsigned irq) {
+    irq_chk(irq);
+    enabled[irq / 32] |= 1 << (irq % 32);
+    irq_ctrl(irq, IRQ_Enable_1, IRQ_Enable_2, IRQ_Enable_Basic);
+}
+void irq_disable(unsigned irq) {
+    irq_chk(irq);
+    irq_ctrl(irq, IRQ_Disable_1, IRQ_Disable_2, IRQ_Disable_Basic);
+    enabled[irq / 32] &= ~(1 << (irq % 32));
+}
+
+void irq_dispatch_init(void) {
+    extern uint32_t irq_dispatch_vec[];
+
+    if(cpsr_int_enabled())
+        panic("interrupts must be off\n");
+
+    dev_barrier();
+    PUT32(IRQ_Disable_1, 0xffffffff);
+    PUT32(IRQ_Disable_2, 0xffffffff);
+    PUT32(IRQ_Disable_Basic, 0xff);
+    dev_barrier();
+
+    for(unsigned i = 0; i < IRQ_NUM; i++) {
+        handlers[i] = (irq_ent_t){ .h = irq_unhandled };
+        counts[i] = 0;
+    }
+    enabled[0] = enabled[1] = enabled[2] = 0;
+    nspurious = 0;
+
+    vector_base_reset(irq_dispatch_vec);
+}
+
+void irq_register(unsigned irq, irq_handler_t h, void *arg) {
+    irq_chk(irq);
+    assert(h);
+
+    uint32_t cpsr = cpsr_int_disable();
+    handlers[irq] = (irq_ent_t){ .h = h, .arg = arg };
+    irq_enable(irq);
+    cpsr_int_reset(cpsr);
+}
+
+void irq_unregister(unsigned irq) {
+    irq_chk(irq);
+
+    uint32_t cpsr = cpsr_int_disable();
+    irq_disable(irq);
+    handlers[irq] = (irq_ent_t){ .h = irq_unhandled };
+    cpsr_int_reset(cpsr);
+}
+
+unsigned irq_count(unsigned irq) {
+    irq_chk(irq);
+    return counts[irq];
+}
+unsigned irq_spurious(void) {
+    return nspurious;
+}
+
+void irq_stats(void) {
+    for(unsigned i = 0; i < IRQ_NUM; i++)
+        if(counts[i])
+            output("irq %d: %d interrupts\n", i, counts[i]);
+    if(nspurious)
+        output("spurious: %d\n", nspurious);
+}
+
+// call the handler for every bit in <pending>, highest bit first.
+static inline void dispatch_word(uint32_t pending, unsigned base) {
+    while(pending) {
+        unsigned bit = 31 - __builtin_clz(pending);
+        unsigned irq = base + bit;
+        irq_ent_t *e = &handlers[irq];
+
+        counts[irq]++;
+        e->h(irq, e->arg);
+        pending &= ~(1 << bit);
+    }
+}
+
+void irq_dispatch(uint32_t pc) {
+    // we don't know what device the interrupted code was using.
+    dev_barrier();
+
+    uint32_t basic = GET32(IRQ_basic_pending);
+    uint32_t p;
+    if((p = basic & BASIC_ARM_MASK & enabled[2]))
+        dispatch_word(p, IRQ_BASIC);
+    if(basic & BASIC_PEND2) {
+        if((p = GET32(IRQ_pending_2) & enabled[1]))
+            dispatch_word(p, 32);
+    }
+    if(basic & BASIC_PEND1) {
+        if((p = GET32(IRQ_pending_1) & enabled[0]))
+            dispatch_word(p, 0);
+    }
+
+    // don't know what device the interrupted code will use next.
+    dev_barrier();
+}
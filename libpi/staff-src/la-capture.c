@@ -0,0 +1,161 @@
+// GPIO logic analyzer capture: see <la-capture.h>
+#include "rpi.h"
+#include "rpi-inline-asm.h"
+#include "cycle-count.h"
+#include "cpu-freq.h"
+#include "gpio-fast.h"
+#include "la-capture.h"
+
+la_capture_t la_capture(const la_cfg_t *c) {
+    unsigned n = c->n;
+    if(!n || (n & (n-1)))
+        panic("buffer size %d is not a power of two\n", n);
+    if(c->timeout_cyc >= (1u << 31))
+        panic("timeout %d cycles is too long\n", c->timeout_cyc);
+    if(c->trig_mask & ~c->mask)
+        panic("trigger mask %x has pins not in sample mask %x\n",
+            c->trig_mask, c->mask);
+
+    // keep everything in registers.
+    volatile uint32_t *lev0 = (void *)GPIO_LEV0;
+    la_sample_t *buf = c->buf;
+    uint32_t rmask = n - 1;
+    uint32_t mask = c->mask;
+    uint32_t tmask = c->trig_mask, tval = c->trig_val;
+    uint32_t timeout = c->timeout_cyc;
+    // never let the trigger sample get overwritten.
+    unsigned npost = c->npost && c->npost < n ? c->npost : n - 1;
+
+    la_capture_t cap = { .trigger = ~0 };
+    unsigned i = 0, stop = ~0;
+    uint32_t nloop = 0;
+
+    uint32_t cpsr = cpsr_int_disable();
+    dev_barrier();
+
+    uint32_t v, last = *lev0 & mask;
+    uint32_t t0 = cycle_cnt_read(), start = t0, now = t0;
+    buf[i++] = (la_sample_t){ .cyc = t0, .lev = last };
+    if((last & tmask) == tval) {
+        cap.triggered_p = 1;
+        cap.trigger = 0;
+        stop = npost + 1;
+    }
+
+    while(i != stop) {
+        // unrolled: only fall out of the straight line on a change.
+        if((v = *lev0 & mask) != last) goto change;
+        if((v = *lev0 & mask) != last) goto change;
+        if((v = *lev0 & mask) != last) goto change;
+        if((v = *lev0 & mask) != last) goto change;
+        nloop++;
+        if((now = cycle_cnt_read()) - start >= timeout) {
+            cap.timed_out_p = 1;
+            break;
+        }
+        continue;
+    change:
+        now = cycle_cnt_read();
+        buf[i & rmask] = (la_sample_t){ .cyc = now, .lev = v };
+        last = v;
+        if(!cap.triggered_p && (v & tmask) == tval) {
+            cap.triggered_p = 1;
+            cap.trigger = i;
+            stop = i + npost + 1;
+            start = now;
+        }
+        i++;
+        // a bus that never sits still for 4 reads never reaches the
+        // check above.
+        if(i != stop && now - start >= timeout) {
+            cap.timed_out_p = 1;
+            break;
+        }
+    }
+
+    dev_barrier();
+    cpsr_int_reset(cpsr);
+
+    cap.total = i;
+    cap.nkept = i < n ? i : n;
+    cap.first = i - cap.nkept;
+    cap.elapsed_cyc = now - t0;
+    cap.nloop = nloop;
+    return cap;
+}
+
+// raw counts: cycles per sample is a runtime divide (no libgcc), so
+// it's left to the reader (or the unix side).
+void la_report(const la_cfg_t *c, const la_capture_t *cap) {
+    output("la: %d changes (%d kept, %d bytes), %d usec, trigger=%s%s\n",
+        cap->total, cap->nkept, cap->nkept * sizeof(la_sample_t),
+        cpu_cyc_to_usec(cap->elapsed_cyc),
+        cap->triggered_p ? "yes" : "no",
+        cap->timed_out_p ? " (timed out)" : "");
+    output("la: %d samples in %d cycles\n", cap->nloop * 4, cap->elapsed_cyc);
+}
+
+/**********************************************************************
+ * streaming: hex lines.
+ */
+static uint8_t line[LA_LINE_BYTES];
+static unsigned nline;
+static uint32_t hash;
+
+static void line_flush(void) {
+    static const char hex[] = "0123456789abcdef";
+    if(!nline)
+        return;
+    for(const char *p = LA_LINE_PREFIX; *p; p++)
+        rpi_putchar(*p);
+    for(unsigned i = 0; i < nline; i++) {
+        rpi_putchar(hex[line[i] >> 4]);
+        rpi_putchar(hex[line[i] & 0xf]);
+    }
+    rpi_putchar('\n');
+    nline = 0;
+}
+
+static void emit(const void *data, unsigned n) {
+    const uint8_t *p = data;
+    hash = la_hash(hash, p, n);
+    for(unsigned i = 0; i < n; i++) {
+        line[nline++] = p[i];
+        if(nline == LA_LINE_BYTES)
+            line_flush();
+    }
+}
+
+void la_stream(const la_cfg_t *c, const la_capture_t *cap) {
+    if(!cap->nkept)
+        panic("empty capture\n");
+
+    la_sample_t *s0 = la_sample(c, cap, 0);
+    la_stream_hdr_t h = {
+        .magic = LA_STREAM_MAGIC,
+        .mask = c->mask,
+        .cyc_per_usec = cpu_cyc_per_usec(),
+        .nsamples = cap->nkept,
+        .trigger = cap->triggered_p ? cap->trigger - cap->first : ~0,
+        .cyc0 = s0->cyc,
+        .lev0 = s0->lev,
+    };
+
+    nline = 0;
+    hash = LA_HASH_INIT;
+    emit(&h, sizeof h);
+
+    la_sample_t prev = *s0;
+    for(unsigned i = 1; i < cap->nkept; i++) {
+        la_sample_t *s = la_sample(c, cap, i);
+        uint8_t rec[10];
+        unsigned k = la_varint_put(rec, s->cyc - prev.cyc);
+        k += la_varint_put(rec + k, s->lev ^ prev.lev);
+        emit(rec, k);
+        prev = *s;
+    }
+
+    uint32_t x = hash;
+    emit(&x, sizeof x);
+    line_flush();
+}
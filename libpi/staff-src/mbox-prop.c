@@ -0,0 +1,78 @@
+// batched mailbox property messages: see <mbox-prop.h>
+#include "rpi.h"
+#include "mbox-prop.h"
+
+void mbox_prop_init(mbox_prop_t *m) {
+    m->n = 2;
+    m->ntags = 0;
+    m->status = 0;
+    m->msg[0] = 0;
+    m->msg[1] = MBOX_REQUEST;
+}
+
+int mbox_prop_tag(mbox_prop_t *m, uint32_t id, const uint32_t *req,
+                  unsigned nreq, unsigned nresp) {
+    unsigned nval = nreq > nresp ? nreq : nresp;
+    // id, buffer size, request/response code, values, + end tag.
+    if(m->n + 3 + nval + 1 > MBOX_PROP_WORDS)
+        panic("mbox_prop: message full adding tag %x\n", id);
+    if(m->ntags == MBOX_PROP_MAXTAGS)
+        panic("mbox_prop: more than %d tags\n", MBOX_PROP_MAXTAGS);
+
+    int h = m->ntags++;
+    m->off[h] = m->n;
+
+    uint32_t *p = &m->msg[m->n];
+    p[0] = id;
+    p[1] = nval * 4;
+    p[2] = nreq * 4;
+    for(unsigned i = 0; i < nval; i++)
+        p[3 + i] = i < nreq ? req[i] : 0;
+    m->n += 3 + nval;
+    return h;
+}
+
+int mbox_prop_send(mbox_prop_t *m) {
+    m->msg[m->n] = 0;
+    m->msg[0] = (m->n + 1) * 4;
+    m->msg[1] = MBOX_REQUEST;
+
+    m->status = mbox_send(MBOX_CH_PROP, m->msg);
+    if(m->status != MBOX_SUCCESS)
+        return -1;
+    int nbad = 0;
+    for(unsigned h = 0; h < m->ntags; h++)
+        if(!mbox_prop_ok(m, h))
+            nbad++;
+    return nbad;
+}
+
+static uint32_t *tag(mbox_prop_t *m, int h) {
+    if(h < 0 || h >= (int)m->ntags)
+        panic("mbox_prop: bad tag handle %d\n", h);
+    return &m->msg[m->off[h]];
+}
+
+int mbox_prop_ok(mbox_prop_t *m, int h) {
+    return m->status == MBOX_SUCCESS && (tag(m, h)[2] & MBOX_TAG_RESPONSE);
+}
+uint32_t *mbox_prop_val(mbox_prop_t *m, int h) {
+    return &tag(m, h)[3];
+}
+unsigned mbox_prop_len(mbox_prop_t *m, int h) {
+    return tag(m, h)[2] & ~MBOX_TAG_RESPONSE;
+}
+
+void mbox_prop_check(mbox_prop_t *m, const char *msg) {
+    if(m->status != MBOX_SUCCESS)
+        panic("%s: mailbox returned %x\n", msg, m->status);
+    int bad = 0;
+    for(unsigned h = 0; h < m->ntags; h++) {
+        if(mbox_prop_ok(m, h))
+            continue;
+        output("%s: tag %d (%x) not handled\n", msg, h, tag(m, h)[0]);
+        bad++;
+    }
+    if(bad)
+        panic("%s: %d of %d tags failed\n", msg, bad, m->ntags);
+}
@@ -0,0 +1,51 @@
+// mailbox 0: see <mbox.h>
+#include "rpi.h"
+#include "dma.h"
+#include "mbox.h"
+
+// bcm2835 arm <-> vc mailbox (not in the datasheet: see the
+// firmware wiki).  we write to mailbox 1 and read replies from 0.
+enum {
+    MBOX_BASE       = 0x2000B880,
+    MBOX_READ       = MBOX_BASE + 0x00,
+    MBOX_STATUS     = MBOX_BASE + 0x18,
+    MBOX_WRITE      = MBOX_BASE + 0x20,
+
+    MBOX_FULL       = 1u << 31,
+    MBOX_EMPTY      = 1 << 30,
+
+    MBOX_TIMEOUT_USEC = 1000*1000,
+};
+
+uint32_t mbox_send(unsigned ch, volatile uint32_t *msg) {
+    if((uint32_t)msg % 16)
+        panic("mbox message %p: must be 16-byte aligned\n", msg);
+    if(ch > 0xf)
+        panic("mbox channel %d: must be 0..15\n", ch);
+
+    // the gpu reads and writes the buffer through the bus alias
+    // (same as dma), behind the arm's dcache.
+    unsigned n = msg[0];
+    dma_cache_clean((void *)msg, n);
+
+    uint32_t s = timer_get_usec();
+    dev_barrier();
+    while(GET32(MBOX_STATUS) & MBOX_FULL)
+        if(timer_get_usec() - s > MBOX_TIMEOUT_USEC)
+            panic("mbox: write side stayed full\n");
+    PUT32(MBOX_WRITE, dma_bus_addr(msg) | ch);
+
+    // drop replies that aren't ours (e.g. another channel).
+    uint32_t want = dma_bus_addr(msg) | ch;
+    while(1) {
+        while(GET32(MBOX_STATUS) & MBOX_EMPTY)
+            if(timer_get_usec() - s > MBOX_TIMEOUT_USEC)
+                panic("mbox: no reply on channel %d\n", ch);
+        if(GET32(MBOX_READ) == want)
+            break;
+    }
+    dev_barrier();
+
+    dma_cache_inv((void *)msg, n);
+    return msg[1];
+}
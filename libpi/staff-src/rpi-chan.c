@@ -0,0 +1,70 @@
+// non-inlined support for the channels in <rpi-chan.h>
+#include "rpi.h"
+#include "rpi-inline-asm.h"
+#include "rpi-chan.h"
+
+// the threads package is not pre-emptive, so "blocking" = moving
+// to the back of the run queue.  the thread that can unblock us
+// must run before we get rescheduled.
+void chan_block(chan_hdr_t *h, unsigned *nblocked) {
+    (*nblocked)++;
+
+    if(rpi_cur_thread() && rpi_nthreads() > 1) {
+        rpi_yield();
+        return;
+    }
+
+    // no other thread: only an interrupt handler can make progress.
+    if(!cpsr_int_enabled())
+        panic("channel <%s>: deadlock: no other threads and interrupts are off\n",
+            h->name);
+    rpi_wait();
+}
+
+void chan_stats(chan_hdr_t *h) {
+    output("channel <%s>: nsend=%d, nrecv=%d, send blocked=%d, recv blocked=%d\n",
+        h->name, h->nsend, h->nrecv, h->nblock_send, h->nblock_recv);
+}
+
+int chan_try_select(chan_case_t *cases, unsigned n) {
+    // rotate where we start so we are (roughly) fair.  compare and
+    // wrap instead of '%': a runtime modulo needs libgcc.
+    static unsigned start;
+
+    assert(n);
+    if(start >= n)
+        start = 0;
+    unsigned k = start++;
+    for(unsigned i = 0; i < n; i++) {
+        chan_case_t *c = &cases[k];
+        chan_hdr_t *h = c->ch;
+
+        switch(c->dir) {
+        case CHAN_SEND:
+            if(h->try_send(h, c->e))
+                return k;
+            break;
+        case CHAN_RECV:
+            if(h->try_recv(h, c->e))
+                return k;
+            break;
+        default: panic("illegal select direction: %d\n", c->dir);
+        }
+        if(++k == n)
+            k = 0;
+    }
+    return -1;
+}
+
+int chan_select(chan_case_t *cases, unsigned n) {
+    int k;
+    while((k = chan_try_select(cases, n)) < 0) {
+        // charge the block to the first case: good enough for stats.
+        chan_hdr_t *h = cases[0].ch;
+        if(cases[0].dir == CHAN_SEND)
+            chan_block(h, &h->nblock_send);
+        else
+            chan_block(h, &h->nblock_recv);
+    }
+    return k;
+}
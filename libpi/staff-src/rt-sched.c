@@ -0,0 +1,205 @@
+// non-preemptive EDF executive driven by the system-timer interrupt.
+// see <rt-sched.h> for the model.
+#include "rpi.h"
+#include "rt-sched.h"
+#include "udiv.h"
+
+// minimum distance in the future we arm the compare register.
+enum { RT_REARM_USEC = 2 };
+
+static rt_task_t *tasks;
+static unsigned ntasks;
+static unsigned timer_chan;
+static unsigned running_p;
+
+static int before(uint32_t a, uint32_t b) {
+    return (int32_t)(a - b) < 0;
+}
+
+rt_task_t *rt_task_add_deadline(const char *name, rt_job_t fn, void *arg,
+    uint32_t period_usec, uint32_t budget_usec, uint32_t deadline_usec) {
+    if(running_p)
+        panic("can't add task <%s> after rt_sched_start\n", name);
+    demand(period_usec, "period must be non-zero");
+    demand(deadline_usec && deadline_usec <= period_usec,
+        "deadline=%d must be in (0,period=%d]", deadline_usec, period_usec);
+    if(budget_usec > deadline_usec)
+        panic("task <%s>: budget %dusec > deadline %dusec: can never meet\n",
+            name, budget_usec, deadline_usec);
+
+    rt_task_t *t = kmalloc(sizeof *t);
+    t->name = name;
+    t->fn = fn;
+    t->arg = arg;
+    t->period_usec = period_usec;
+    t->budget_usec = budget_usec;
+    t->deadline_usec = deadline_usec;
+    // the one divide, once per task (no libgcc: see <udiv.h>).
+    // rounded up so a set that's just over 1 isn't admitted quietly.
+    t->util_ppt = udiv64((uint64_t)budget_usec * 1000 + period_usec - 1,
+                         period_usec);
+
+    // append so that ties in deadline go in creation order.
+    rt_task_t **p = &tasks;
+    while(*p)
+        p = &(*p)->next;
+    *p = t;
+    ntasks++;
+
+    unsigned u = rt_sched_util_ppt();
+    if(u > 1000)
+        output("WARNING: adding <%s>: utilization=%d/1000: not schedulable\n",
+            name, u);
+    return t;
+}
+
+rt_task_t *rt_task_add(const char *name, rt_job_t fn, void *arg,
+    uint32_t period_usec, uint32_t budget_usec) {
+    return rt_task_add_deadline(name, fn, arg,
+                period_usec, budget_usec, period_usec);
+}
+
+unsigned rt_sched_util_ppt(void) {
+    unsigned u = 0;
+    for(rt_task_t *t = tasks; t; t = t->next)
+        u += t->util_ppt;
+    return u;
+}
+
+// release every job that is due at <now>.  if the previous job
+// has not run yet, it's dropped and counted as a miss.
+static void release_jobs(uint32_t now) {
+    for(rt_task_t *t = tasks; t; t = t->next) {
+        while(!before(now, t->next_release)) {
+            if(t->ready) {
+                t->nskip++;
+                t->nmiss++;
+            }
+            t->ready = 1;
+            t->release = t->next_release;
+            t->deadline = t->release + t->deadline_usec;
+            t->next_release += t->period_usec;
+            t->njobs++;
+        }
+    }
+}
+
+// earliest absolute deadline among the ready jobs.
+static rt_task_t *edf_pick(void) {
+    rt_task_t *min = 0;
+    for(rt_task_t *t = tasks; t; t = t->next)
+        if(t->ready && (!min || before(t->deadline, min->deadline)))
+            min = t;
+    return min;
+}
+
+static uint32_t next_release(void) {
+    uint32_t n = tasks->next_release;
+    for(rt_task_t *t = tasks->next; t; t = t->next)
+        if(before(t->next_release, n))
+            n = t->next_release;
+    return n;
+}
+
+static void run_job(rt_task_t *t) {
+    t->ready = 0;
+
+    uint32_t s = timer_get_usec_raw();
+    t->fn(t->arg);
+    uint32_t e = timer_get_usec_raw();
+
+    uint32_t exec = e - s;
+    if(exec > t->max_exec)
+        t->max_exec = exec;
+    if(exec > t->budget_usec)
+        t->noverrun++;
+
+    uint32_t resp = e - t->release;
+    if(resp > t->max_resp)
+        t->max_resp = resp;
+    if(before(t->deadline, e))
+        t->nmiss++;
+    t->ndone++;
+}
+
+// release and run jobs until nothing is ready, then arm the timer
+// for the next release.  we run at most <ntasks> jobs per interrupt
+// so an overloaded task set can't livelock the best-effort code.
+static void dispatch(void) {
+    rt_task_t *t;
+    for(unsigned i = 0; i < ntasks; i++) {
+        release_jobs(timer_get_usec_raw());
+        if(!(t = edf_pick()))
+            break;
+        run_job(t);
+    }
+
+    // a compare only fires on equality, so if the next release
+    // has already passed (or is about to) arm a bit in the future
+    // instead.  the interrupt refires right after we return, but
+    // under overload the best-effort code still gets to run.
+    uint32_t n = next_release();
+    uint32_t soon = timer_get_usec_raw() + RT_REARM_USEC;
+    if(before(n, soon))
+        n = soon;
+    sys_timer_compare_set(timer_chan, n);
+}
+
+int rt_sched_int(void) {
+    if(!running_p || !sys_timer_matched(timer_chan))
+        return 0;
+    sys_timer_clear(timer_chan);
+    dispatch();
+    return 1;
+}
+
+void rt_sched_start(unsigned chan) {
+    sys_timer_chan_chk(chan);
+    if(!tasks)
+        panic("no real-time tasks\n");
+
+    timer_chan = chan;
+    dev_barrier();
+    uint32_t now = timer_get_usec_raw();
+    for(rt_task_t *t = tasks; t; t = t->next)
+        t->next_release = now + t->period_usec;
+
+    sys_timer_clear(chan);
+    sys_timer_compare_set(chan, next_release());
+    running_p = 1;
+    dev_barrier();
+    sys_timer_int_enable(chan);
+}
+
+void rt_sched_stop(void) {
+    if(!running_p)
+        return;
+    sys_timer_int_disable(timer_chan);
+    sys_timer_clear(timer_chan);
+    running_p = 0;
+}
+
+void rt_sched_reset(void) {
+    rt_sched_stop();
+    // no free: kmalloc'd tasks are just dropped.
+    tasks = 0;
+    ntasks = 0;
+}
+
+void rt_sched_report(void) {
+    unsigned njobs = 0, nmiss = 0;
+
+    output("EDF report: utilization=%d/1000\n", rt_sched_util_ppt());
+    for(rt_task_t *t = tasks; t; t = t->next) {
+        output("  %s: period=%dus budget=%dus deadline=%dus\n",
+            t->name, t->period_usec, t->budget_usec, t->deadline_usec);
+        output("    jobs=%d ran=%d missed=%d (skipped=%d) overruns=%d\n",
+            t->njobs, t->ndone, t->nmiss, t->nskip, t->noverrun);
+        output("    max exec=%dus max response=%dus\n",
+            t->max_exec, t->max_resp);
+        njobs += t->njobs;
+        nmiss += t->nmiss;
+    }
+    // raw counts: the rate is a divide, which we leave to the reader.
+    output("  total: jobs=%d missed=%d\n", njobs, nmiss);
+}
@@ -0,0 +1,292 @@
+// asynchronous SPI0 master: see <spi-async.h>
+#include "rpi.h"
+#include "rpi-inline-asm.h"
+#include "cycle-count.h"
+#include "irq-dispatch.h"
+#include "dma.h"
+#include "spi-async.h"
+
+// bcm2835 p148--p158.
+enum {
+    SPI_BASE    = 0x20204000,
+    SPI_CS      = SPI_BASE + 0x0,
+    SPI_FIFO    = SPI_BASE + 0x4,
+    SPI_CLK     = SPI_BASE + 0x8,
+    SPI_DLEN    = SPI_BASE + 0xc,
+
+    CS_CLEAR_TX = 1 << 4,
+    CS_CLEAR_RX = 1 << 5,
+    CS_TA       = 1 << 7,
+    CS_DMAEN    = 1 << 8,
+    CS_INTD     = 1 << 9,
+    CS_INTR     = 1 << 10,
+    CS_ADCS     = 1 << 11,
+    CS_DONE     = 1 << 16,
+    CS_RXD      = 1 << 17,
+    CS_TXD      = 1 << 18,
+
+    CS_CLEAR    = CS_CLEAR_TX | CS_CLEAR_RX,
+
+    // bytes we keep in flight in irq mode: the rx fifo holds 64.
+    SPI_FIFO_SIZE = 64,
+
+    // ce1 = 7, ce0 = 8, miso = 9, mosi = 10, sclk = 11.
+    SPI_PIN_FIRST = 7,
+    SPI_PIN_LAST  = 11,
+
+    SPI_TIMEOUT_USEC = 1000*1000,
+
+    // the fifo register is the same address every access; the
+    // engine does 32-bit accesses of four packed bytes.
+    TI_TX = DMA_TI_DEST_DREQ | DMA_TI_PERMAP(DMA_DREQ_SPI_TX) | DMA_TI_WAIT_RESP,
+    TI_RX = DMA_TI_SRC_DREQ | DMA_TI_PERMAP(DMA_DREQ_SPI_RX) | DMA_TI_WAIT_RESP,
+};
+
+typedef struct {
+    uint8_t *rx;
+    const uint8_t *tx;
+    unsigned n;
+    uint32_t cs;            // chip select bits.
+    uint32_t div;
+    spi_done_t done;
+    void *arg;
+} spi_req_t;
+
+static unsigned mode;
+static int tx_ch = -1, rx_ch = -1;
+
+// q[head % QSIZE] is running; [head, tail) are pending.  only
+// changed with interrupts off.
+static spi_req_t q[SPI_ASYNC_QSIZE];
+static volatile unsigned head, tail;
+
+// irq mode: progress through q[head].
+static unsigned tx_pos, rx_pos;
+
+static dma_cb_t tx_cb, rx_cb;
+// source for tx=0 and sink for rx=0.
+static uint32_t zero, sink;
+
+static spi_async_stats_t st;
+
+static void start(spi_req_t *r);
+
+// q[head] has finished: start the next one before running the
+// callback so the bus isn't idle while it runs.
+static void finish(void) {
+    dev_barrier();
+    PUT32(SPI_CS, q[head % SPI_ASYNC_QSIZE].cs | CS_CLEAR);
+    dev_barrier();
+
+    spi_req_t r = q[head % SPI_ASYNC_QSIZE];
+    head++;
+    st.ndone++;
+    st.nbytes += r.n;
+    if(head != tail)
+        start(&q[head % SPI_ASYNC_QSIZE]);
+    if(r.done)
+        r.done(r.rx, r.n, r.arg);
+}
+
+/*****************************************************************
+ * dma engine.
+ */
+static void rx_done(unsigned ch, void *arg) {
+    uint32_t s = cycle_cnt_read();
+    st.nints++;
+    finish();
+    st.irq_cyc += cycle_cnt_read() - s;
+}
+
+static void dma_go(spi_req_t *r) {
+    uint32_t fifo = dma_bus_addr((void *)SPI_FIFO);
+
+    rx_cb = (dma_cb_t){
+        .ti = TI_RX | (r->rx ? DMA_TI_DEST_INC : 0),
+        .src = fifo,
+        .dst = dma_bus_addr(r->rx ? (void *)r->rx : &sink),
+        .len = r->n,
+    };
+    tx_cb = (dma_cb_t){
+        .ti = TI_TX | (r->tx ? DMA_TI_SRC_INC : 0),
+        .src = dma_bus_addr(r->tx ? (const void *)r->tx : &zero),
+        .dst = fifo,
+        .len = r->n,
+    };
+    dma_start(rx_ch, &rx_cb, rx_done, 0);
+    dma_start(tx_ch, &tx_cb, 0, 0);
+
+    // the DREQs go live with DMAEN; ADCS drops CS after DLEN bytes.
+    dev_barrier();
+    PUT32(SPI_DLEN, r->n);
+    PUT32(SPI_CS, r->cs | CS_TA | CS_DMAEN | CS_ADCS);
+    dev_barrier();
+}
+
+/*****************************************************************
+ * fifo interrupt engine.
+ */
+static void fifo_fill(spi_req_t *r) {
+    while(tx_pos < r->n && tx_pos - rx_pos < SPI_FIFO_SIZE
+    && (GET32(SPI_CS) & CS_TXD)) {
+        PUT32(SPI_FIFO, r->tx ? r->tx[tx_pos] : 0);
+        tx_pos++;
+    }
+}
+
+static void spi_irq(unsigned irq, void *arg) {
+    uint32_t s = cycle_cnt_read();
+    st.nints++;
+
+    // nothing running: a stale DONE from before we dropped TA.
+    if(head == tail) {
+        dev_barrier();
+        PUT32(SPI_CS, CS_CLEAR);
+        dev_barrier();
+        return;
+    }
+    dev_barrier();
+    spi_req_t *r = &q[head % SPI_ASYNC_QSIZE];
+    while(rx_pos < r->n && (GET32(SPI_CS) & CS_RXD)) {
+        uint8_t c = GET32(SPI_FIFO);
+        if(r->rx)
+            r->rx[rx_pos] = c;
+        rx_pos++;
+    }
+    if(rx_pos == r->n)
+        finish();
+    else
+        fifo_fill(r);
+    dev_barrier();
+
+    st.irq_cyc += cycle_cnt_read() - s;
+}
+
+static void irq_go(spi_req_t *r) {
+    tx_pos = rx_pos = 0;
+    dev_barrier();
+    PUT32(SPI_CS, r->cs | CS_TA | CS_INTR | CS_INTD);
+    fifo_fill(r);
+    dev_barrier();
+}
+
+/*****************************************************************
+ * queue.
+ */
+static void start(spi_req_t *r) {
+    dev_barrier();
+    PUT32(SPI_CLK, r->div);
+    PUT32(SPI_CS, r->cs | CS_CLEAR);
+    dev_barrier();
+
+    if(mode == SPI_ASYNC_DMA)
+        dma_go(r);
+    else
+        irq_go(r);
+}
+
+void spi_async_init(unsigned m) {
+    if(m != SPI_ASYNC_DMA && m != SPI_ASYNC_IRQ)
+        panic("spi_async_init: bad mode %d\n", m);
+    // switching engines: drop the old one's resources.
+    if(head != tail)
+        panic("spi_async_init: %d transfers still pending\n", tail - head);
+    if(mode == SPI_ASYNC_DMA) {
+        dma_chan_free(tx_ch);
+        dma_chan_free(rx_ch);
+        tx_ch = rx_ch = -1;
+    } else if(mode == SPI_ASYNC_IRQ)
+        irq_unregister(IRQ_SPI);
+    mode = m;
+
+    for(unsigned p = SPI_PIN_FIRST; p <= SPI_PIN_LAST; p++)
+        gpio_set_function(p, GPIO_FUNC_ALT0);
+
+    dev_barrier();
+    PUT32(SPI_CS, CS_CLEAR);
+    dev_barrier();
+
+    if(mode == SPI_ASYNC_DMA) {
+        if((tx_ch = dma_chan_alloc(DMA_ANY)) < 0
+        || (rx_ch = dma_chan_alloc(DMA_ANY)) < 0)
+            panic("spi: not enough free dma channels\n");
+        dma_cache_clean(&zero, sizeof zero);
+    } else
+        irq_register(IRQ_SPI, spi_irq, 0);
+}
+
+spi_t spi_async_dev(unsigned chip, unsigned div) {
+    if(chip != SPI_CE0 && chip != SPI_CE1 && chip > 1)
+        panic("spi: bad chip select %d\n", chip);
+    if(div < 2 || div > 65534 || div % 2)
+        panic("spi: clock divider %d: must be even, 2..65534\n", div);
+    return (spi_t){ .chip = chip, .div = div,
+        .mosi = 10, .miso = 9, .clk = 11, .ce = chip == SPI_CE1 || chip == 1 ? 7 : 8 };
+}
+
+int spi_submit(spi_t s, uint8_t *rx, const uint8_t *tx, unsigned n,
+               spi_done_t done, void *arg) {
+    if(!mode)
+        panic("spi_async_init not called\n");
+    if(!n || n > SPI_ASYNC_MAX)
+        panic("spi_submit: %d bytes: must be 1..%d\n", n, SPI_ASYNC_MAX);
+
+    if(mode == SPI_ASYNC_DMA) {
+        if(tx)
+            dma_cache_clean(tx, n);
+        if(rx)
+            dma_cache_inv(rx, n);
+    }
+
+    uint32_t cpsr = cpsr_int_disable();
+    if(tail - head == SPI_ASYNC_QSIZE) {
+        st.nfull++;
+        cpsr_int_reset(cpsr);
+        return 0;
+    }
+    spi_req_t *r = &q[tail % SPI_ASYNC_QSIZE];
+    *r = (spi_req_t){
+        .rx = rx, .tx = tx, .n = n,
+        .cs = s.chip == SPI_CE1 || s.chip == 1,
+        .div = s.div,
+        .done = done, .arg = arg,
+    };
+    st.nsubmit++;
+    if(tail++ == head)
+        start(r);
+    cpsr_int_reset(cpsr);
+    return 1;
+}
+
+unsigned spi_async_pending(void) {
+    return tail - head;
+}
+
+void spi_async_wait(void) {
+    if(!cpsr_int_enabled())
+        panic("spi_async_wait: interrupts are off\n");
+    unsigned last = head;
+    uint32_t s = timer_get_usec();
+    while(head != tail) {
+        if(head != last) {
+            last = head;
+            s = timer_get_usec();
+        } else if(timer_get_usec() - s > SPI_TIMEOUT_USEC)
+            panic("spi: no transfer finished in %dusec (%d pending)\n",
+                SPI_TIMEOUT_USEC, tail - head);
+    }
+}
+
+spi_async_stats_t spi_async_stats(void) {
+    uint32_t cpsr = cpsr_int_disable();
+    spi_async_stats_t s = st;
+    cpsr_int_reset(cpsr);
+    return s;
+}
+
+void spi_async_stats_print(const char *msg) {
+    spi_async_stats_t s = spi_async_stats();
+    output("%s: %d submitted, %d done, %d refused, %d bytes, %d interrupts, %d cycles in handlers\n",
+        msg, s.nsubmit, s.ndone, s.nfull, (uint32_t)s.nbytes, s.nints,
+        (uint32_t)s.irq_cyc);
+}
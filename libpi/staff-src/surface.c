@@ -0,0 +1,383 @@
+// 2d raster primitives: see <surface.h>
+#include "surface.h"
+
+static inline int imin(int a, int b) { return a < b ? a : b; }
+static inline int imax(int a, int b) { return a > b ? a : b; }
+static inline int iabs(int a) { return a < 0 ? -a : a; }
+
+surface_t surface_mk(void *p, unsigned w, unsigned h, unsigned pitch,
+                     unsigned depth) {
+    if(depth != 16 && depth != 24 && depth != 32)
+        panic("surface: depth %d: must be 16, 24 or 32\n", depth);
+    unsigned bpp = depth / 8;
+    if(!pitch)
+        pitch = w * bpp;
+    if(pitch < w * bpp)
+        panic("surface: pitch %d < width %d * %d\n", pitch, w, bpp);
+    // whole pixels must be naturally aligned (24bpp is done in bytes).
+    unsigned align = bpp == 3 ? 1 : bpp;
+    if(((uintptr_t)p | pitch) & (align - 1))
+        panic("surface: %p / pitch %d not %d-byte aligned\n", p, pitch, align);
+
+    return (surface_t){
+        .p = p, .w = w, .h = h, .pitch = pitch,
+        .depth = depth, .bytes_pp = bpp,
+        .cx0 = 0, .cy0 = 0, .cx1 = w, .cy1 = h,
+    };
+}
+
+// <r> intersected with [0,w) x [0,h).  w/h <= 0 = empty.
+static rect_t rect_clip(rect_t r, int w, int h) {
+    int x0 = imax(r.x, 0), y0 = imax(r.y, 0);
+    int x1 = imin(r.x + r.w, w), y1 = imin(r.y + r.h, h);
+    return (rect_t){ x0, y0, imax(x1 - x0, 0), imax(y1 - y0, 0) };
+}
+
+surface_t surface_sub(const surface_t *s, rect_t r) {
+    r = rect_clip(r, s->w, s->h);
+    surface_t n = *s;
+    n.p = surface_row(s, r.y) + r.x * s->bytes_pp;
+    n.w = r.w;
+    n.h = r.h;
+    surface_unclip(&n);
+    return n;
+}
+
+void surface_clip(surface_t *s, rect_t r) {
+    r = rect_clip(r, s->w, s->h);
+    s->cx0 = r.x;
+    s->cy0 = r.y;
+    s->cx1 = r.x + r.w;
+    s->cy1 = r.y + r.h;
+}
+void surface_unclip(surface_t *s) {
+    s->cx0 = s->cy0 = 0;
+    s->cx1 = s->w;
+    s->cy1 = s->h;
+}
+
+/*****************************************************************
+ * span fills.
+ */
+#ifdef RPI_UNIX
+void surface_stm8(uint32_t *p, unsigned n, uint32_t v) {
+    for(unsigned i = 0; i < n * 8; i++)
+        p[i] = v;
+}
+void surface_stm6(uint32_t *p, unsigned n, const uint32_t *pat) {
+    for(unsigned i = 0; i < n * 6; i++)
+        p[i] = pat[i % 3];
+}
+#endif
+
+static void fill32(uint32_t *p, unsigned n, uint32_t c) {
+    // up to a cache line boundary, then whole lines.
+    for(; n && ((uintptr_t)p & 31); n--)
+        *p++ = c;
+    if(n >= 8) {
+        surface_stm8(p, n / 8, c);
+        p += n & ~7;
+        n &= 7;
+    }
+    while(n--)
+        *p++ = c;
+}
+
+static void fill16(uint16_t *p, unsigned n, uint32_t c) {
+    c &= 0xffff;
+    if(n && ((uintptr_t)p & 2)) {
+        *p++ = c;
+        n--;
+    }
+    fill32((uint32_t *)p, n / 2, c | c << 16);
+    if(n & 1)
+        p[n - 1] = c;
+}
+
+static void fill24(uint8_t *p, unsigned n, uint32_t c) {
+    uint8_t b0 = c, b1 = c >> 8, b2 = c >> 16;
+
+    // 3 and 4 are coprime: at most 3 pixels to word alignment.
+    for(; n && ((uintptr_t)p & 3); n--, p += 3) {
+        p[0] = b0; p[1] = b1; p[2] = b2;
+    }
+    // 4 pixels = 3 words.
+    uint32_t pat[3] = {
+        b0 | b1 << 8 | b2 << 16 | (uint32_t)b0 << 24,
+        b1 | b2 << 8 | b0 << 16 | (uint32_t)b1 << 24,
+        b2 | b0 << 8 | b1 << 16 | (uint32_t)b2 << 24,
+    };
+    uint32_t *w = (uint32_t *)p;
+    if(n >= 8) {
+        surface_stm6(w, n / 8, pat);
+        w += (n / 8) * 6;
+        n &= 7;
+    }
+    if(n >= 4) {
+        w[0] = pat[0]; w[1] = pat[1]; w[2] = pat[2];
+        w += 3;
+        n -= 4;
+    }
+    for(p = (uint8_t *)w; n; n--, p += 3) {
+        p[0] = b0; p[1] = b1; p[2] = b2;
+    }
+}
+
+// <n> pixels at <p>: no clipping.
+static void span_raw(const surface_t *s, uint8_t *p, unsigned n, uint32_t c) {
+    switch(s->bytes_pp) {
+    case 4: fill32((uint32_t *)p, n, c); break;
+    case 2: fill16((uint16_t *)p, n, c); break;
+    default: fill24(p, n, c); break;
+    }
+}
+
+void surf_hspan(const surface_t *s, int x0, int x1, int y, uint32_t c) {
+    if(y < s->cy0 || y >= s->cy1)
+        return;
+    x0 = imax(x0, s->cx0);
+    x1 = imin(x1, s->cx1);
+    if(x0 < x1)
+        span_raw(s, surface_row(s, y) + x0 * s->bytes_pp, x1 - x0, c);
+}
+
+void surf_vspan(const surface_t *s, int x, int y0, int y1, uint32_t c) {
+    if(x < s->cx0 || x >= s->cx1)
+        return;
+    y0 = imax(y0, s->cy0);
+    y1 = imin(y1, s->cy1);
+    for(int y = y0; y < y1; y++)
+        surface_put_raw(s, x, y, c);
+}
+
+void surf_fill_rect(const surface_t *s, int x, int y, int w, int h, uint32_t c) {
+    int x0 = imax(x, s->cx0), x1 = imin(x + w, s->cx1);
+    int y0 = imax(y, s->cy0), y1 = imin(y + h, s->cy1);
+    if(x0 >= x1 || y0 >= y1)
+        return;
+
+    // packed rows: one long span.
+    uint8_t *p = surface_row(s, y0) + x0 * s->bytes_pp;
+    unsigned n = x1 - x0;
+    if(n * s->bytes_pp == s->pitch) {
+        span_raw(s, p, n * (y1 - y0), c);
+        return;
+    }
+    for(int r = y0; r < y1; r++, p += s->pitch)
+        span_raw(s, p, n, c);
+}
+
+void surf_rect(const surface_t *s, int x, int y, int w, int h, uint32_t c) {
+    if(w <= 0 || h <= 0)
+        return;
+    surf_hspan(s, x, x + w, y, c);
+    if(h > 1)
+        surf_hspan(s, x, x + w, y + h - 1, c);
+    surf_vspan(s, x, y + 1, y + h - 1, c);
+    if(w > 1)
+        surf_vspan(s, x + w - 1, y + 1, y + h - 1, c);
+}
+
+void surf_clear(const surface_t *s, uint32_t c) {
+    surf_fill_rect(s, 0, 0, s->w, s->h, c);
+}
+
+/*****************************************************************
+ * lines.
+ */
+void surf_line(const surface_t *s, int x0, int y0, int x1, int y1, uint32_t c) {
+    if(y0 == y1) {
+        surf_hspan(s, imin(x0, x1), imax(x0, x1) + 1, y0, c);
+        return;
+    }
+    if(x0 == x1) {
+        surf_vspan(s, x0, imin(y0, y1), imax(y0, y1) + 1, c);
+        return;
+    }
+
+    // both ends inside: the clip check can't fail in between.
+    int inside = surface_in_clip(s, x0, y0) && surface_in_clip(s, x1, y1);
+    int dx = iabs(x1 - x0), sx = x0 < x1 ? 1 : -1;
+    int dy = -iabs(y1 - y0), sy = y0 < y1 ? 1 : -1;
+    int err = dx + dy;
+    while(1) {
+        if(inside)
+            surface_put_raw(s, x0, y0, c);
+        else
+            surf_pixel(s, x0, y0, c);
+        if(x0 == x1 && y0 == y1)
+            break;
+        int e2 = 2 * err;
+        if(e2 >= dy) {
+            err += dy;
+            x0 += sx;
+        }
+        if(e2 <= dx) {
+            err += dx;
+            y0 += sy;
+        }
+    }
+}
+
+// blend one channel <w> bits wide at <shift>.
+static inline uint32_t
+blend_ch(uint32_t c, uint32_t d, unsigned shift, unsigned w, unsigned a) {
+    uint32_t m = (1u << w) - 1;
+    uint32_t cc = (c >> shift) & m, dd = (d >> shift) & m;
+    return ((cc * a + dd * (255 - a) + 127) / 255) << shift;
+}
+
+void surf_blend(const surface_t *s, int x, int y, uint32_t c, unsigned a) {
+    if(!a || !surface_in_clip(s, x, y))
+        return;
+    if(a >= 255) {
+        surface_put_raw(s, x, y, c);
+        return;
+    }
+    uint32_t d = surface_get_raw(s, x, y), v;
+    if(s->depth == 16)
+        v = blend_ch(c, d, 11, 5, a) | blend_ch(c, d, 5, 6, a) | blend_ch(c, d, 0, 5, a);
+    else
+        v = blend_ch(c, d, 16, 8, a) | blend_ch(c, d, 8, 8, a) | blend_ch(c, d, 0, 8, a)
+          | (c & 0xff000000);
+    surface_put_raw(s, x, y, v);
+}
+
+// wu's algorithm with integer endpoints: step along the major axis,
+// split each step's pixel between the two nearest minor positions
+// by the 8-bit fraction.  the two weights always sum to 255.
+void surf_line_aa(const surface_t *s, int x0, int y0, int x1, int y1, uint32_t c) {
+    int steep = iabs(y1 - y0) > iabs(x1 - x0);
+    if(steep) {
+        int t;
+        t = x0; x0 = y0; y0 = t;
+        t = x1; x1 = y1; y1 = t;
+    }
+    if(x0 > x1) {
+        int t;
+        t = x0; x0 = x1; x1 = t;
+        t = y0; y0 = y1; y1 = t;
+    }
+    int dx = x1 - x0, dy = y1 - y0;
+
+    // the minor position in 24.8 fixed point steps by 256*|dy|/dx =
+    // <q> + <rem>/<dx>: whole 1/256ths in <y>, the rest as a
+    // bresenham error term in <err>.  no divide at runtime (the
+    // arm1176 has none and we don't link libgcc): <q> <= 256, so it's
+    // nine steps of long division.
+    int sign = dy < 0 ? -1 : 1;
+    unsigned n = iabs(dy) << 8, q = 0;
+    // (dx = 0 is a single point: dy is 0 too.)
+    for(int b = 8; dx && b >= 0; b--)
+        if(((unsigned)dx << b) <= n) {
+            n -= dx << b;
+            q |= 1 << b;
+        }
+    int step = sign * (int)q, rem = n, err = 0;
+    int32_t y = y0 << 8;
+
+    for(int x = x0; x <= x1; x++) {
+        int yi = y >> 8;
+        unsigned f = y & 0xff;
+        if(steep) {
+            surf_blend(s, yi, x, c, 255 - f);
+            surf_blend(s, yi + 1, x, c, f);
+        } else {
+            surf_blend(s, x, yi, c, 255 - f);
+            surf_blend(s, x, yi + 1, c, f);
+        }
+        y += step;
+        if((err += rem) >= dx) {
+            err -= dx;
+            y += sign;
+        }
+    }
+}
+
+/*****************************************************************
+ * circles: midpoint, one octant mirrored eight ways.
+ */
+void surf_circle(const surface_t *s, int cx, int cy, int r, uint32_t c) {
+    if(r < 0)
+        return;
+    int x = r, y = 0, err = 1 - r;
+    while(x >= y) {
+        surf_pixel(s, cx + x, cy + y, c);
+        surf_pixel(s, cx - x, cy + y, c);
+        surf_pixel(s, cx + x, cy - y, c);
+        surf_pixel(s, cx - x, cy - y, c);
+        surf_pixel(s, cx + y, cy + x, c);
+        surf_pixel(s, cx - y, cy + x, c);
+        surf_pixel(s, cx + y, cy - x, c);
+        surf_pixel(s, cx - y, cy - x, c);
+        y++;
+        if(err < 0)
+            err += 2 * y + 1;
+        else {
+            x--;
+            err += 2 * (y - x) + 1;
+        }
+    }
+}
+
+// the same points as <surf_circle>, joined into spans row by row.
+void surf_fill_circle(const surface_t *s, int cx, int cy, int r, uint32_t c) {
+    if(r < 0)
+        return;
+    int x = r, y = 0, err = 1 - r;
+    while(x >= y) {
+        surf_hspan(s, cx - x, cx + x + 1, cy + y, c);
+        if(y)
+            surf_hspan(s, cx - x, cx + x + 1, cy - y, c);
+        // the rows at +-x only once, on their last (widest) y.
+        int ny = y + 1, nx = x;
+        if(err >= 0)
+            nx--;
+        if(nx != x && x != y) {
+            surf_hspan(s, cx - y, cx + y + 1, cy + x, c);
+            surf_hspan(s, cx - y, cx + y + 1, cy - x, c);
+        }
+        y = ny;
+        if(err < 0)
+            err += 2 * y + 1;
+        else {
+            x = nx;
+            err += 2 * (y - x) + 1;
+        }
+    }
+}
+
+/*****************************************************************
+ * blit.
+ */
+void surf_blit(const surface_t *dst, int dx, int dy,
+               const surface_t *src, int sx, int sy, int w, int h) {
+    if(dst->depth != src->depth)
+        panic("surf_blit: depth %d -> %d\n", src->depth, dst->depth);
+
+    // clip to the source surface, then the destination's clip rect.
+    if(sx < 0) { dx -= sx; w += sx; sx = 0; }
+    if(sy < 0) { dy -= sy; h += sy; sy = 0; }
+    w = imin(w, (int)src->w - sx);
+    h = imin(h, (int)src->h - sy);
+    if(dx < dst->cx0) { int d = dst->cx0 - dx; sx += d; w -= d; dx = dst->cx0; }
+    if(dy < dst->cy0) { int d = dst->cy0 - dy; sy += d; h -= d; dy = dst->cy0; }
+    w = imin(w, dst->cx1 - dx);
+    h = imin(h, dst->cy1 - dy);
+    if(w <= 0 || h <= 0)
+        return;
+
+    unsigned n = w * dst->bytes_pp;
+    const uint8_t *sp = surface_row(src, sy) + sx * src->bytes_pp;
+    uint8_t *dp = surface_row(dst, dy) + dx * dst->bytes_pp;
+
+    // same buffer moving down: go bottom up so we don't read rows
+    // we've already written.
+    if(dst->p == src->p && dy > sy) {
+        for(int r = h - 1; r >= 0; r--)
+            memmove(dp + r * dst->pitch, sp + r * src->pitch, n);
+        return;
+    }
+    for(int r = 0; r < h; r++, sp += src->pitch, dp += dst->pitch)
+        memmove(dp, sp, n);
+}
@@ -0,0 +1,74 @@
+// parallel bit-banged spi lanes: see <sw-spi-fast.h>
+#include "rpi.h"
+#include "sw-spi-fast.h"
+
+void sw_spi_par_init(sw_spi_par_t *p, unsigned sck, const unsigned *mosi,
+                     const unsigned *miso, unsigned n, unsigned delay) {
+    if(sck >= 32)
+        panic("sw-spi: sck pin %d: must be 0..31\n", sck);
+
+    p->n = n;
+    p->sck = sck;
+    p->delay = delay;
+    gpio_bus_init(&p->mosi, mosi, n);
+    if(p->mosi.mask & (1u << sck))
+        panic("sw-spi: sck pin %d is also a mosi pin\n", sck);
+    gpio_bus_output(&p->mosi);
+    gpio_set_output(sck);
+    gpio_set_off(sck);
+
+    p->miso_p = miso != 0;
+    if(p->miso_p) {
+        gpio_bus_init(&p->miso, miso, n);
+        gpio_bus_input(&p->miso);
+    }
+}
+
+void sw_spi_par_transfer(sw_spi_par_t *p, uint8_t **rx,
+                         const uint8_t **tx, unsigned n) {
+    volatile uint32_t *set = (void *)GPIO_SET0;
+    volatile uint32_t *clr = (void *)GPIO_CLR0;
+    volatile uint32_t *lev = (void *)GPIO_LEV0;
+    uint32_t ck = 1u << p->sck, omask = p->mosi.mask;
+    unsigned delay = p->delay;
+
+    dev_barrier();
+    for(unsigned i = 0; i < n; i++) {
+        // transpose: bit <k> of every lane's byte -> one GPSET0 mask.
+        uint32_t out[8], in[8];
+        for(unsigned k = 0; k < 8; k++) {
+            uint32_t v = 0;
+            for(unsigned l = 0; l < p->n; l++)
+                if(tx[l])
+                    v |= ((tx[l][i] >> k) & 1) << l;
+            out[k] = gpio_bus_to_gpio(&p->mosi, v);
+        }
+
+        // mode 0, msb first: the trailing edge and the zero data bits
+        // go in one GPCLR0 store.
+        for(int k = 7; k >= 0; k--) {
+            *clr = ck | (~out[k] & omask);
+            *set = out[k];
+            sw_spi_delay(delay);
+            *set = ck;
+            in[k] = *lev;
+            sw_spi_delay(delay);
+        }
+        *clr = ck;
+
+        if(!p->miso_p || !rx)
+            continue;
+        // and back: GPLEV0 sample <k> -> bit <k> of each lane's byte.
+        for(unsigned k = 0; k < 8; k++)
+            in[k] = gpio_bus_from_gpio(&p->miso, in[k]);
+        for(unsigned l = 0; l < p->n; l++) {
+            if(!rx[l])
+                continue;
+            uint8_t c = 0;
+            for(unsigned k = 0; k < 8; k++)
+                c |= ((in[k] >> l) & 1) << k;
+            rx[l][i] = c;
+        }
+    }
+    dev_barrier();
+}
@@ -0,0 +1,108 @@
+// multi-channel sw-uart drivers: see <sw-uart-multi.h>
+#include "rpi.h"
+#include "rpi-inline-asm.h"
+#include "cycle-count.h"
+#include "cpu-freq.h"
+#include "gpio-fast.h"
+#include "irq-dispatch.h"
+#include "sw-uart-multi.h"
+
+// bcm2835 p196: the arm timer (see <rpi-armtimer.h>).
+enum {
+    ARM_TIMER_LOAD      = 0x2000B400,
+    ARM_TIMER_CONTROL   = 0x2000B408,
+    ARM_TIMER_IRQ_CLEAR = 0x2000B40c,
+    ARM_TIMER_RELOAD    = 0x2000B418,
+    ARM_TIMER_PREDIV    = 0x2000B41c,
+
+    ARM_TIMER_32BIT     = 1 << 1,
+    ARM_TIMER_INT_EN    = 1 << 5,
+    ARM_TIMER_EN        = 1 << 7,
+};
+
+void msu_init_helper(msu_t *m, const unsigned *pins, unsigned n,
+              unsigned baud, unsigned os,
+              uint32_t tick_cyc, uint32_t timer_load) {
+    if(!timer_load)
+        panic("msu: %d baud x %d too fast for the arm timer\n", baud, os);
+    msu_state_init(m, pins, n, os);
+    m->baud = baud;
+    m->tick_cyc = tick_cyc;
+    m->timer_load = timer_load;
+
+    for(unsigned i = 0; i < n; i++) {
+        gpio_set_input(pins[i]);
+        gpio_set_pullup(pins[i]);
+    }
+    dev_barrier();
+    m->prev = gpio_fast_read_all();
+}
+
+void msu_poll(msu_t *m, uint32_t ncycles) {
+    uint32_t period = m->tick_cyc;
+    uint32_t start = cycle_cnt_read(), t = 0, c;
+
+    dev_barrier();
+    while(t < ncycles) {
+        while((c = cycle_cnt_read() - start) < t)
+            ;
+        if(c - t >= period)
+            m->nlate++;
+        msu_tick(m, gpio_fast_read_all());
+        m->busy_cyc += cycle_cnt_read() - start - c;
+        m->nticks++;
+        t += period;
+    }
+    dev_barrier();
+}
+
+static void msu_timer_handler(unsigned irq, void *arg) {
+    uint32_t s = cycle_cnt_read();
+    msu_t *m = arg;
+
+    dev_barrier();
+    PUT32(ARM_TIMER_IRQ_CLEAR, 1);
+    dev_barrier();
+    msu_tick(m, gpio_fast_read_all());
+    dev_barrier();
+
+    m->nticks++;
+    m->busy_cyc += cycle_cnt_read() - s;
+}
+
+void msu_timer_start(msu_t *m) {
+    unsigned load = m->timer_load;
+
+    dev_barrier();
+    PUT32(ARM_TIMER_CONTROL, 0);
+    PUT32(ARM_TIMER_PREDIV, 0);         // count every apb cycle.
+    PUT32(ARM_TIMER_LOAD, load - 1);
+    PUT32(ARM_TIMER_RELOAD, load - 1);
+    PUT32(ARM_TIMER_IRQ_CLEAR, 1);
+    PUT32(ARM_TIMER_CONTROL, ARM_TIMER_32BIT | ARM_TIMER_INT_EN | ARM_TIMER_EN);
+    dev_barrier();
+    irq_register(IRQ_ARM_TIMER, msu_timer_handler, m);
+}
+
+void msu_timer_stop(msu_t *m) {
+    irq_unregister(IRQ_ARM_TIMER);
+    dev_barrier();
+    PUT32(ARM_TIMER_CONTROL, 0);
+    PUT32(ARM_TIMER_IRQ_CLEAR, 1);
+    // reset value.
+    PUT32(ARM_TIMER_PREDIV, 0x7d);
+    dev_barrier();
+}
+
+void msu_stats_print(msu_t *m) {
+    // raw totals: a 64-bit divide here would need libgcc.  busy in
+    // units of 1024 cycles so it doesn't wrap in 32 bits.
+    output("msu: %d channels at %d baud x%d: %d ticks, %d late, busy %dK cycles\n",
+        m->nchan, m->baud, m->os, m->nticks, m->nlate,
+        (uint32_t)(m->busy_cyc >> 10));
+    for(unsigned i = 0; i < m->nchan; i++) {
+        msu_chan_stats_t *s = &m->ch[i].st;
+        output("  chan %d (pin %d): %d bytes, %d framing errs, %d glitches, %d dropped\n",
+            i, m->ch[i].pin, s->nbytes, s->nframe_err, s->nglitch, s->ndrop);
+    }
+}
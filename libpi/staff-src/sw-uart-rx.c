@@ -0,0 +1,136 @@
+// edge-driven sw-uart receiver: see <sw-uart-rx.h>
+#include "rpi.h"
+#include "rpi-inline-asm.h"
+#include "cycle-count.h"
+#include "gpio-fast.h"
+#include "irq-dispatch.h"
+#include "sw-uart-rx.h"
+
+// bcm2835 p99: async falling edge detect enable.
+enum { GPIO_AFEN0 = GPIO_BASE + 0x88 };
+
+// spin until <off> cycles after <t0>.
+static inline void wait_until(uint32_t t0, uint32_t off) {
+    while(cycle_cnt_read() - t0 < off)
+        ;
+}
+
+static void sw_uart_rx_handler(unsigned irq, void *arg) {
+    uint32_t now = cycle_cnt_read();
+    sw_uart_rx_t *r = arg;
+    volatile uint32_t *lev = (void *)GPIO_LEV0;
+    uint32_t m = 1u << r->pin;
+    const uint32_t *off = r->off;
+
+    dev_barrier();
+    if(!(*(volatile uint32_t *)GPIO_EDS0 & m))
+        return;
+
+    uint32_t t0 = now - r->lat_cyc;
+    wait_until(t0, off[0]);
+    if(*lev & m) {
+        r->st.nglitch++;
+        goto out;
+    }
+
+    uint32_t b = 0;
+    for(unsigned i = 0; i < 8; i++) {
+        wait_until(t0, off[i+1]);
+        if(*lev & m)
+            b |= 1 << i;
+    }
+
+    wait_until(t0, off[9]);
+    if(!(*lev & m))
+        r->st.nframe_err++;
+    else if(!sw_rxq_push(&r->q, b))
+        r->st.ndrop++;
+    else
+        r->st.nbytes++;
+
+out:
+    *(volatile uint32_t *)GPIO_EDS0 = m;
+    dev_barrier();
+    r->st.busy_cyc += cycle_cnt_read() - now;
+}
+
+void sw_uart_rx_set_latency(sw_uart_rx_t *r, unsigned lat_cyc) {
+    // past the start-bit center we'd sample the wrong bits.
+    if(lat_cyc >= r->cyc_per_bit / 2)
+        panic("latency %d >= half a bit (%d cycles)\n",
+            lat_cyc, r->cyc_per_bit / 2);
+    r->lat_cyc = lat_cyc;
+}
+
+void sw_uart_rx_init_helper(sw_uart_rx_t *r, unsigned pin,
+                            unsigned baud, unsigned cyc_per_bit) {
+    if(pin >= 32)
+        panic("rx pin %d: must be in bank 0 (0..31)\n", pin);
+    if(!cyc_per_bit)
+        panic("cyc_per_bit = 0 for baud %d\n", baud);
+
+    memset(r, 0, sizeof *r);
+    r->pin = pin;
+    r->baud = baud;
+    r->cyc_per_bit = cyc_per_bit;
+    r->q = sw_rxq_mk();
+    sw_uart_rx_set_latency(r, SW_UART_RX_LAT_CYC < cyc_per_bit / 2 ?
+        SW_UART_RX_LAT_CYC : 0);
+
+    // center of bit <i> (0 = start, 9 = stop).
+    for(unsigned i = 0; i < 10; i++)
+        r->off[i] = (2*i + 1) * cyc_per_bit / 2;
+
+    gpio_set_input(pin);
+    gpio_set_pullup(pin);
+    gpio_int_async_falling_edge(pin);
+    gpio_event_clear(pin);
+    irq_register(IRQ_GPIO0, sw_uart_rx_handler, r);
+}
+
+void sw_uart_rx_stop(sw_uart_rx_t *r) {
+    irq_unregister(IRQ_GPIO0);
+    dev_barrier();
+    PUT32(GPIO_AFEN0, GET32(GPIO_AFEN0) & ~(1u << r->pin));
+    gpio_event_clear(r->pin);
+    dev_barrier();
+}
+
+int sw_uart_rx_get8_nonblk(sw_uart_rx_t *r) {
+    uint8_t c;
+    if(!sw_rxq_pop_nonblk(&r->q, &c))
+        return -1;
+    return c;
+}
+
+int sw_uart_rx_get8_timeout(sw_uart_rx_t *r, uint32_t timeout_usec) {
+    uint32_t s = timer_get_usec();
+    int c;
+    while((c = sw_uart_rx_get8_nonblk(r)) < 0)
+        if(timer_get_usec() - s >= timeout_usec)
+            return -1;
+    return c;
+}
+
+unsigned sw_uart_rx_read(sw_uart_rx_t *r, void *buf, unsigned n) {
+    uint8_t *p = buf;
+    unsigned i;
+    for(i = 0; i < n && sw_rxq_pop_nonblk(&r->q, &p[i]); i++)
+        ;
+    return i;
+}
+
+sw_uart_rx_stats_t sw_uart_rx_stats(sw_uart_rx_t *r) {
+    uint32_t cpsr = cpsr_int_disable();
+    sw_uart_rx_stats_t s = r->st;
+    cpsr_int_reset(cpsr);
+    return s;
+}
+
+void sw_uart_rx_stats_print(sw_uart_rx_t *r) {
+    sw_uart_rx_stats_t s = sw_uart_rx_stats(r);
+    output("sw-uart-rx pin=%d baud=%d (%d cyc/bit): %d bytes, %d framing errs, "
+        "%d glitches, %d dropped, %d busy cycles\n",
+        r->pin, r->baud, r->cyc_per_bit, s.nbytes, s.nframe_err,
+        s.nglitch, s.ndrop, (uint32_t)s.busy_cyc);
+}
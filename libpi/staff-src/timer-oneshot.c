@@ -0,0 +1,155 @@
+// one-shot timers on a system timer compare channel: see
+// <timer-oneshot.h>
+#include "rpi.h"
+#include "rpi-inline-asm.h"
+#include "irq-dispatch.h"
+#include "timer-oneshot.h"
+
+enum {
+    // minimum distance in the future we arm the compare register.
+    ONESHOT_REARM_USEC = 2,
+    // the compare register only sees the low 32 bits: never arm
+    // further out than this.
+    ONESHOT_MAX_HOP = 1u << 31,
+};
+
+static oneshot_t *head;
+static unsigned chan;
+static unsigned init_p;
+static unsigned nints, ncallbacks;
+
+// arm the compare channel for the earliest deadline.  interrupts
+// must be off.
+static void rearm(void) {
+    if(!head)
+        return;
+
+    while(1) {
+        uint64_t now = timer_get_usec64();
+        uint64_t d = head->deadline;
+        if(d < now + ONESHOT_REARM_USEC)
+            d = now + ONESHOT_REARM_USEC;
+        else if(d - now > ONESHOT_MAX_HOP)
+            d = now + ONESHOT_MAX_HOP;
+
+        sys_timer_compare_set(chan, d);
+        dev_barrier();
+
+        // a compare only fires on equality: if we were slow and
+        // <d> already went by, the match is lost until CLO wraps.
+        if(timer_get_usec64() < d || sys_timer_matched(chan))
+            return;
+    }
+}
+
+static void oneshot_int(unsigned irq, void *arg) {
+    dev_barrier();
+    sys_timer_clear(chan);
+    nints++;
+
+    // run everything that's due.  callbacks can arm new timers.
+    while(head && head->deadline <= timer_get_usec64()) {
+        oneshot_t *t = head;
+        head = t->next;
+        t->next = 0;
+        t->armed_p = 0;
+        ncallbacks++;
+        t->fn(t->arg);
+    }
+    rearm();
+    dev_barrier();
+}
+
+void oneshot_init(unsigned c) {
+    sys_timer_chan_chk(c);
+    if(cpsr_int_enabled())
+        panic("interrupts must be off\n");
+
+    chan = c;
+    head = 0;
+    nints = ncallbacks = 0;
+
+    dev_barrier();
+    sys_timer_clear(chan);
+    dev_barrier();
+    irq_register(chan == SYS_TIMER_CHAN1 ? IRQ_SYS_TIMER1 : IRQ_SYS_TIMER3,
+        oneshot_int, 0);
+    init_p = 1;
+}
+
+void oneshot_arm(oneshot_t *t, uint64_t deadline, oneshot_fn_t fn, void *arg) {
+    if(!init_p)
+        panic("oneshot_init not called\n");
+    assert(fn);
+
+    uint32_t cpsr = cpsr_int_disable();
+    if(t->armed_p)
+        panic("timer %p is already armed\n", t);
+
+    t->deadline = deadline;
+    t->fn = fn;
+    t->arg = arg;
+    t->armed_p = 1;
+
+    // insert after any timers with the same deadline so they fire
+    // in the order armed.
+    oneshot_t **p = &head;
+    while(*p && (*p)->deadline <= deadline)
+        p = &(*p)->next;
+    t->next = *p;
+    *p = t;
+
+    if(head == t)
+        rearm();
+    cpsr_int_reset(cpsr);
+}
+
+int oneshot_cancel(oneshot_t *t) {
+    uint32_t cpsr = cpsr_int_disable();
+    int was_p = t->armed_p;
+    if(was_p) {
+        oneshot_t **p = &head;
+        while(*p != t)
+            p = &(*p)->next;
+        *p = t->next;
+        t->next = 0;
+        t->armed_p = 0;
+        // if <t> was first the compare is now early: the handler
+        // will find nothing due and rearm.
+    }
+    cpsr_int_reset(cpsr);
+    return was_p;
+}
+
+static void wakeup(void *arg) {
+    *(volatile int *)arg = 1;
+}
+
+void oneshot_sleep_until(uint64_t deadline) {
+    if(!init_p || !cpsr_int_enabled()) {
+        while(timer_get_usec64() < deadline)
+            rpi_wait();
+        return;
+    }
+
+    volatile int done = 0;
+    oneshot_t t = {0};
+    oneshot_arm(&t, deadline, wakeup, (void *)&done);
+
+    // check <done> with interrupts off so the wakeup can't slip in
+    // between the check and the wait: a pending interrupt still
+    // wakes the cpu, and we take it once we re-enable.
+    while(1) {
+        cpsr_int_disable();
+        if(done)
+            break;
+        cpu_wait_for_int();
+        cpsr_int_enable();
+    }
+    cpsr_int_enable();
+}
+
+void oneshot_stats(void) {
+    output("oneshot: chan=%d interrupts=%d callbacks=%d\n",
+        chan, nints, ncallbacks);
+}
@@ -15,6 +15,20 @@ uint32_t timer_get_usec(void) {
     return u;
 }
 
+// full 64-bit usec counter: never wraps in practice.  CHI and
+// CLO are separate loads, so if CLO wraps between them we'd be off
+// by 2^32: re-read CHI and retry until it didn't change.
+uint64_t timer_get_usec64(void) {
+    dev_barrier();
+    uint32_t hi, lo;
+    do {
+        hi = GET32(0x20003008);
+        lo = GET32(0x20003004);
+    } while(GET32(0x20003008) != hi);
+    dev_barrier();
+    return (uint64_t)hi << 32 | lo;
+}
+
 void delay_us(uint32_t us) {
     uint32_t s = timer_get_usec();
     while(1) {
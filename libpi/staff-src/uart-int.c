@@ -0,0 +1,219 @@
+// interrupt-driven mini-uart: see <uart-int.h>
+#include "rpi.h"
+#include "irq-dispatch.h"
+#include "uart-int.h"
+#include "rpi-inline-asm.h"
+#include "circular-T.h"
+
+// bcm2835 p8--p19 (with the errata for IER/IIR).
+enum {
+    AUX_ENABLES     = 0x20215004,
+    AUX_MU_IO       = 0x20215040,
+    AUX_MU_IER      = 0x20215044,
+    AUX_MU_IIR      = 0x20215048,
+    AUX_MU_LCR      = 0x2021504c,
+    AUX_MU_MCR      = 0x20215050,
+    AUX_MU_LSR      = 0x20215054,
+    AUX_MU_CNTL     = 0x20215060,
+    AUX_MU_BAUD     = 0x20215068,
+
+    // IER: the doc has RX/TX swapped, and bits 2,3 must be set
+    // to get any interrupts at all.
+    IER_RX          = 1 << 0,
+    IER_TX          = 1 << 1,
+    IER_ON          = 0b11 << 2,
+
+    // IIR: bit 0 = 0 if an interrupt is pending.  writing 0b11 << 1
+    // clears both fifos.
+    IIR_CLEAR_FIFOS = 0b11 << 1,
+
+    LSR_RX_READY    = 1 << 0,
+    LSR_RX_OVERRUN  = 1 << 1,
+    LSR_TX_SPACE    = 1 << 5,
+
+    UART_TX_PIN     = 14,
+    UART_RX_PIN     = 15,
+};
+
+gen_circular_T(uq, uq_t, uint8_t, UART_QSIZE)
+
+static uq_t rx, tx;
+static uart_int_stats_t st;
+static int on_p;
+
+// interrupts may or may not be on: enable TX ints after every
+// push.  if the handler drained <tx> and turned them off between
+// our push and here, the worst case is one extra interrupt.
+static inline void tx_kick(void) {
+    dev_barrier();
+    PUT32(AUX_MU_IER, IER_ON | IER_RX | IER_TX);
+    dev_barrier();
+}
+
+static void uart_int_handler(unsigned irq, void *arg) {
+    dev_barrier();
+    st.nints++;
+
+    // drain the RX fifo.  reading LSR clears the overrun bit.
+    uint32_t lsr;
+    while((lsr = GET32(AUX_MU_LSR)) & LSR_RX_READY) {
+        if(lsr & LSR_RX_OVERRUN)
+            st.hw_overrun++;
+        uint8_t c = GET32(AUX_MU_IO) & 0xff;
+        st.nrx++;
+        if(!uq_push(&rx, c))
+            st.rx_drop++;
+    }
+    if(lsr & LSR_RX_OVERRUN)
+        st.hw_overrun++;
+
+    unsigned n = uq_cnt(&rx);
+    if(n > st.rx_max)
+        st.rx_max = n;
+
+    // top up the TX fifo.
+    uint8_t c;
+    while((GET32(AUX_MU_LSR) & LSR_TX_SPACE) && uq_pop_nonblk(&tx, &c)) {
+        PUT32(AUX_MU_IO, c);
+        st.ntx++;
+    }
+    // the TX-empty interrupt is level triggered: turn it off if
+    // there is nothing left to send.
+    if(uq_empty(&tx))
+        PUT32(AUX_MU_IER, IER_ON | IER_RX);
+    dev_barrier();
+}
+
+void uart_int_init_helper(unsigned baud, unsigned baud_reg) {
+    if(cpsr_int_enabled())
+        panic("interrupts must be off\n");
+    // too fast comes out as -1.
+    if(baud_reg > 0xffff)
+        panic("baud=%d out of range\n", baud);
+
+    // let the staff driver finish anything in flight.
+    uart_flush_tx();
+
+    rx = uq_mk();
+    tx = uq_mk();
+    st = (uart_int_stats_t){0};
+
+    dev_barrier();
+    gpio_set_function(UART_TX_PIN, GPIO_FUNC_ALT5);
+    gpio_set_function(UART_RX_PIN, GPIO_FUNC_ALT5);
+    dev_barrier();
+
+    PUT32(AUX_ENABLES, GET32(AUX_ENABLES) | 1);
+    dev_barrier();
+    PUT32(AUX_MU_CNTL, 0);
+    PUT32(AUX_MU_IER, 0);
+    PUT32(AUX_MU_LCR, 0b11);        // 8 bits
+    PUT32(AUX_MU_MCR, 0);
+    PUT32(AUX_MU_IIR, IIR_CLEAR_FIFOS);
+    PUT32(AUX_MU_BAUD, baud_reg);
+    PUT32(AUX_MU_CNTL, 0b11);       // rx + tx on
+    PUT32(AUX_MU_IER, IER_ON | IER_RX);
+    dev_barrier();
+
+    irq_register(IRQ_AUX, uart_int_handler, 0);
+    on_p = 1;
+}
+
+void uart_int_disable(void) {
+    if(!on_p)
+        return;
+    uart_int_flush_tx();
+
+    uint32_t cpsr = cpsr_int_disable();
+    dev_barrier();
+    PUT32(AUX_MU_IER, 0);
+    dev_barrier();
+    irq_unregister(IRQ_AUX);
+    on_p = 0;
+    cpsr_int_reset(cpsr);
+}
+
+unsigned uart_read(void *buf, unsigned n) {
+    uint8_t *p = buf;
+    unsigned i;
+    for(i = 0; i < n; i++)
+        if(!uq_pop_nonblk(&rx, &p[i]))
+            break;
+    return i;
+}
+
+unsigned uart_write(const void *buf, unsigned n) {
+    const uint8_t *p = buf;
+    unsigned i;
+    for(i = 0; i < n; i++)
+        if(!uq_push(&tx, p[i]))
+            break;
+    if(i)
+        tx_kick();
+    return i;
+}
+
+unsigned uart_rx_avail(void) {
+    return uq_cnt(&rx);
+}
+unsigned uart_tx_space(void) {
+    return UART_QSIZE - 1 - uq_cnt(&tx);
+}
+
+// only an interrupt can make progress.
+static void uart_int_wait(const char *what) {
+    if(!cpsr_int_enabled())
+        panic("%s: deadlock: interrupts are off\n", what);
+    rpi_wait();
+}
+
+int uart_int_get8(void) {
+    uint8_t c;
+    while(!uart_read(&c, 1))
+        uart_int_wait("uart_int_get8");
+    return c;
+}
+
+int uart_int_put8(uint8_t c) {
+    while(!uart_write(&c, 1))
+        uart_int_wait("uart_int_put8");
+    return c;
+}
+
+void uart_int_flush_tx(void) {
+    while(!uq_empty(&tx))
+        uart_int_wait("uart_int_flush_tx");
+    // and the hardware fifo.
+    uart_flush_tx();
+}
+
+int uart_int_putchar(int c) {
+    if(!on_p) {
+        uart_put8(c);
+        return c;
+    }
+    // interrupts off (e.g., in a handler or panic): nothing will
+    // drain <tx>, so push it out by polling (in order) and then <c>.
+    if(!cpsr_int_enabled()) {
+        uint8_t b;
+        while(uq_pop_nonblk(&tx, &b)) {
+            uart_put8(b);
+            st.ntx++;
+        }
+        uart_put8(c);
+        st.ntx++;
+        return c;
+    }
+    uart_int_put8(c);
+    return c;
+}
+
+uart_int_stats_t uart_int_stats(void) {
+    return st;
+}
+
+void uart_int_stats_print(void) {
+    output("uart: ints=%d rx=%d tx=%d hw overrun=%d rx drop=%d rx max=%d/%d\n",
+        st.nints, st.nrx, st.ntx, st.hw_overrun, st.rx_drop,
+        st.rx_max, UART_QSIZE - 1);
+}
@@ -0,0 +1,25 @@
+// shift-subtract divide: see <udiv.h>
+#include "rpi.h"
+#include "udiv.h"
+
+uint64_t udiv64(uint64_t n, uint64_t d) {
+    if(!d)
+        panic("divide by zero\n");
+
+    // long division a bit at a time.  only constant shifts, so no
+    // 64-bit shift helpers either.
+    uint64_t q = 0, r = 0;
+    for(unsigned i = 0; i < 64; i++) {
+        // <r> can need 65 bits for a <d> over 2^63: the top bit
+        // shifted out means it's certainly >= d.
+        unsigned top = r >> 63;
+        r = r << 1 | n >> 63;
+        n <<= 1;
+        q <<= 1;
+        if(top || r >= d) {
+            r -= d;
+            q |= 1;
+        }
+    }
+    return q;
+}